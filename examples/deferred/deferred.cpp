@@ -6,16 +6,23 @@
 
 #include "renderer.h"
 
+#include <cctype>
+#include <cstring>
+
 class DeferredExample {
 public:
+  // Without a window (eg. on CI with a software ICD like lavapipe), renders
+  // that many frames with a fixed camera and exits
+  std::optional<uint32_t> headless_frames;
+
   ovk::Instance instance;
-  ovk::Surface surface;
+  std::optional<ovk::Surface> surface;
   ovk::Device device;
 
   std::unique_ptr<ovk::util::Model> model;
   std::unique_ptr<Renderer> renderer;
 
-  DeferredExample();
+  explicit DeferredExample(std::optional<uint32_t> headless_frames);
   void run();
 
   void create_model();
@@ -29,12 +36,32 @@ vk::PhysicalDeviceFeatures get_features() {
   return vk::PhysicalDeviceFeatures();
 }
 
-DeferredExample::DeferredExample()
-    : instance(ovk::AppInfo{"Deferred", 0, 0, 1}, {}),
-      surface(std::move(
-          instance.create_surface(1960, 1080, "Deferred Shading", true))),
-      device(std::move(instance.create_device(get_required_extensions(),
-																						 get_features(), surface))) {
+static ovk::Instance create_instance(bool headless) {
+  const ovk::AppInfo app_info{"Deferred", 0, 0, 1};
+  return headless ? ovk::Instance::create_headless(app_info)
+                  : ovk::Instance(app_info, {});
+}
+
+static std::optional<ovk::Surface> create_surface(ovk::Instance &instance,
+                                                  bool headless) {
+  if (headless)
+    return std::nullopt;
+  return instance.create_surface(1960, 1080, "Deferred Shading", true);
+}
+
+static ovk::Device create_device(ovk::Instance &instance,
+                                 std::optional<ovk::Surface> &surface) {
+  // A headless device does not need the swapchain extension
+  return surface ? instance.create_device(get_required_extensions(),
+                                          get_features(), *surface)
+                 : instance.create_device({}, get_features());
+}
+
+DeferredExample::DeferredExample(std::optional<uint32_t> headless_frames)
+    : headless_frames(headless_frames),
+      instance(create_instance(headless_frames.has_value())),
+      surface(create_surface(instance, headless_frames.has_value())),
+      device(create_device(instance, surface)) {
 
   // Now that we have that the rendering context of the application is already
   // finished
@@ -44,7 +71,7 @@ DeferredExample::DeferredExample()
 	create_model();
 	
 	// Create the Renderer
-	renderer = std::make_unique<Renderer>(&device, &surface, model.get());
+	renderer = std::make_unique<Renderer>(&device, surface ? &*surface : nullptr, model.get());
 	
 	
 }
@@ -52,7 +79,9 @@ DeferredExample::DeferredExample()
 void DeferredExample::run() {
 
 	spdlog::info("start main loop");
-	while(surface.update()) {
+	uint32_t frame_count = 0;
+	while (headless_frames ? frame_count < *headless_frames : surface->update()) {
+		frame_count++;
 
 		// Figure out delta time
 		static int fps = 0;
@@ -71,6 +100,8 @@ void DeferredExample::run() {
 
 			delta = time - last_time;
 			last_time = time;
+			// Frames are not shown, so every run renders the same frames
+			if (headless_frames) delta = 1.0f / 60.0f;
 
 			frames++;
 			
@@ -92,11 +123,14 @@ void DeferredExample::run() {
 	}
 
 	renderer->finish();
+	spdlog::info("Rendered {} frames", frame_count);
 	
 }
 
 void DeferredExample::create_model() {
   ovk::util::ParseOptions parse_options{
+      .use_index_buffer = true,
+      .optimize_mesh = true,
       .disable_callback = false,
       .callback = [](const ovk::util::VertexData &data,
                      ovk::util::OutputBuffer &output) {
@@ -110,8 +144,17 @@ void DeferredExample::create_model() {
 }
 
 int main(int argc, char **argv) {
+  // --headless [frames]
+  std::optional<uint32_t> headless_frames;
+  for (auto i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--headless"))
+      headless_frames = i + 1 < argc && isdigit(argv[i + 1][0])
+                            ? static_cast<uint32_t>(std::stoul(argv[i + 1]))
+                            : 100u;
+  }
+
   try {
-    DeferredExample example;
+    DeferredExample example(headless_frames);
     example.run();
   } catch (const std::exception &e) {
     // This should not happen but maybe it will and we dont want everything to
@@ -15,55 +15,59 @@ Renderer::Renderer(ovk::Device *device, ovk::Surface *surface,
 void Renderer::recreate_swapchain() {
   device->wait_idle();
 
-  int width = 0, height = 0;
-  glfwGetFramebufferSize(surface->window.get(), &width, &height);
-  while (width == 0 || height == 0) {
+  if (surface) {
+    int width = 0, height = 0;
     glfwGetFramebufferSize(surface->window.get(), &width, &height);
-    glfwWaitEvents();
+    while (width == 0 || height == 0) {
+      glfwGetFramebufferSize(surface->window.get(), &width, &height);
+      glfwWaitEvents();
+    }
   }
 
   depth = {};
+  gbuffer = {};
 
+  const auto extent = swapchain->swap_extent;
   swapchain->handle.invalidate();
-  swapchain = ovk::make_unique(device->create_swapchain(*surface));
+  swapchain = ovk::make_unique(
+      surface ? device->create_swapchain(*surface, pacer->get_present_mode())
+              : device->create_offscreen_swapchain(extent));
 
   create_dynamic_objects();
 }
 
 void Renderer::update(float dt) {
   // Acquire new image
-  device->wait_fences({sync.in_flight_fences[sync.current_frame]});
-
-  auto [recreate, index] = device->acquire_image(
-      *swapchain, sync.image_available[sync.current_frame]);
-  if (recreate) {
+  auto index = pacer->begin_frame(*swapchain);
+  while (!index) {
     recreate_swapchain();
+    index = pacer->begin_frame(*swapchain);
   }
 
-  swapchain_index = index;
+  swapchain_index = *index;
 
   // ImGui Update stage
-  ImGui::NewFrame();
-  imgui->update();
+  if (imgui) {
+    ImGui::NewFrame();
+    imgui->update();
+    pacer->debug_draw();
+  }
 
   // Camera Update
-  camera->update(dt, true);
-
-  const auto dir = camera->dir;
-  // spdlog::info("camera dir: {}, {}, {}", dir.x, dir.y, dir.z);
+  if (camera)
+    camera->update(dt, true);
 }
 
 void Renderer::render() {
 
   // Update Camera Buffer
-  auto &camera_data = camera->get_data();
+  auto &camera_data = camera ? camera->get_data() : fixed_camera;
   device->update_buffer(descriptor.uniform_buffers[swapchain_index],
                         camera_data);
 
   // Create ImGui Draw Data
-  ImGui::Render();
-
-  device->reset_fences({sync.in_flight_fences[sync.current_frame]});
+  if (imgui)
+    ImGui::Render();
 
   if (commands[swapchain_index]) {
     static auto &pool = device->get_command_pool(ovk::QueueType::graphics);
@@ -77,19 +81,10 @@ void Renderer::render() {
             build_cmd_buffers(cmd, swapchain_index);
           })[0]);
 
-  device->submit(
-      {ovk::WaitInfo{sync.image_available[sync.current_frame],
-                     vk::PipelineStageFlagBits::eColorAttachmentOutput}},
-      {commands[swapchain_index]->cmd_handle},
-      {sync.render_finished[sync.current_frame]},
-      sync.in_flight_fences[sync.current_frame]);
+  pacer->submit({commands[swapchain_index]->cmd_handle});
 
-  const auto recreate = device->present_image(
-      *swapchain, swapchain_index, {sync.render_finished[sync.current_frame]});
-  if (recreate)
+  if (pacer->present(*swapchain))
     recreate_swapchain();
-
-  sync.current_frame = (sync.current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
 void Renderer::finish() {
@@ -98,45 +93,83 @@ void Renderer::finish() {
 
 void Renderer::create_const_objects() {
   // Create the Swapchain
-  swapchain = ovk::make_unique(device->create_swapchain(*surface));
-
-  camera = std::make_unique<ovk::FirstPersonCamera>(glm::vec3(0.0f, 0.0f, 3.0f),
-                                                    *swapchain);
+  swapchain = ovk::make_unique(
+      surface ? device->create_swapchain(*surface)
+              : device->create_offscreen_swapchain(vk::Extent2D(1960, 1080)));
+
+  // The camera needs the window for its input
+  if (surface) {
+    camera = std::make_unique<ovk::FirstPersonCamera>(
+        glm::vec3(0.0f, 0.0f, 3.0f), *swapchain);
+  } else {
+    const auto aspect = static_cast<float>(swapchain->swap_extent.width) /
+                        static_cast<float>(swapchain->swap_extent.height);
+    fixed_camera.view =
+        glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 2.0f),
+                    glm::vec3(0.0f, 1.0f, 0.0f));
+    fixed_camera.projection =
+        glm::perspective(glm::radians(45.0f), aspect, 0.1f, 1000.f);
+    fixed_camera.projection[1][1] *= -1.f;
+  }
 
   // The Render Pass
-  // atm just forward rendering
+  // Deferred shading in one render pass with two subpasses:
+  //  0: the geometry writes albedo, normal and depth (G-buffer)
+  //  1: a fullscreen triangle reads them as input attachments and shades into the swapchain image
+  // The G-buffer is cleared and never stored, so a tiler keeps it in tile memory and the images are transient
   // if you want more information about the api see triangle example
   const auto color_attachment_description =
       swapchain->get_color_attachment_description();
 
-  const vk::AttachmentDescription depth_attachment{
-      {},
-      device->default_depth_format().value(),
-      vk::SampleCountFlagBits::e1,
-      vk::AttachmentLoadOp::eClear,
-      vk::AttachmentStoreOp::eDontCare,
-      vk::AttachmentLoadOp::eDontCare,
-      vk::AttachmentStoreOp::eDontCare,
-      vk::ImageLayout::eUndefined,
-      vk::ImageLayout::eDepthStencilAttachmentOptimal};
-
-  const ovk::GraphicSubpass main_pass(
-      {},                             // input attachments
-      {color_attachment_description}, // color attachments
-      {},                             // resolve attachments
-      {},                             // preserve attachments
-      depth_attachment                // depth attachment
+  const auto gbuffer_attachment = [](vk::Format format,
+                                     vk::ImageLayout final_layout) {
+    return vk::AttachmentDescription{{},
+                                     format,
+                                     vk::SampleCountFlagBits::e1,
+                                     vk::AttachmentLoadOp::eClear,
+                                     vk::AttachmentStoreOp::eDontCare,
+                                     vk::AttachmentLoadOp::eDontCare,
+                                     vk::AttachmentStoreOp::eDontCare,
+                                     vk::ImageLayout::eUndefined,
+                                     final_layout};
+  };
+
+  // The final layouts are the ones of the lighting subpass, so there is no transition at the end
+  const auto albedo_attachment = gbuffer_attachment(
+      GBUFFER_ALBEDO_FORMAT, vk::ImageLayout::eShaderReadOnlyOptimal);
+  const auto normal_attachment = gbuffer_attachment(
+      GBUFFER_NORMAL_FORMAT, vk::ImageLayout::eShaderReadOnlyOptimal);
+  const auto depth_attachment =
+      gbuffer_attachment(device->default_depth_format().value(),
+                         vk::ImageLayout::eDepthStencilReadOnlyOptimal);
+
+  const ovk::GraphicSubpass gbuffer_pass(
+      {},                                     // input attachments
+      {albedo_attachment, normal_attachment}, // color attachments
+      {},                                     // resolve attachments
+      {},                                     // preserve attachments
+      depth_attachment                        // depth attachment
   );
 
-  render_pass = ovk::make_unique(device->create_render_pass(
-      {color_attachment_description, depth_attachment}, {main_pass}, true));
+  const ovk::GraphicSubpass lighting_pass(
+      {albedo_attachment, normal_attachment, depth_attachment}, // input attachments
+      {color_attachment_description}                           // color attachments
+  );
 
-  // Create ImGui Renderer
-  ovk::ImGuiSetupProps imgui_props{
-      .use_extern_font = true, .font_path = "res/fonts/FiraCode-Regular.ttf"};
-  imgui = std::make_unique<ovk::ImGuiRenderer>(*render_pass, *swapchain,
-                                               *surface, *device, imgui_props);
-  {
+  // The dependency G-buffer -> lighting is generated from the shared attachments
+  render_pass = ovk::make_unique(device->create_render_pass(
+      {color_attachment_description, albedo_attachment, normal_attachment,
+       depth_attachment},
+      {gbuffer_pass, lighting_pass}, true));
+
+  // Create ImGui Renderer (drawn on top of the lit image), it needs the window
+  // for its input
+  ovk::ImGuiSetupProps imgui_props{.use_extern_font = true,
+                                   .font_path = "res/fonts/FiraCode-Regular.ttf",
+                                   .subpass = 1};
+  if (surface) {
+    imgui = std::make_unique<ovk::ImGuiRenderer>(
+        *render_pass, *swapchain, *surface, *device, imgui_props);
     // ImGui Settings
     ImGui::SetCurrentContext(imgui->context);
     auto &io = ImGui::GetIO();
@@ -149,11 +182,20 @@ void Renderer::create_const_objects() {
 			.add_uniform_buffer(0, vk::ShaderStageFlagBits::eVertex)
           .build());
 
+  lighting.temp = ovk::make_unique(device->build_descriptor_template()
+                                       .add_input_attachment(0) // albedo
+                                       .add_input_attachment(1) // normal
+                                       .add_input_attachment(2) // depth
+                                       .build());
+  lighting.pool = ovk::make_unique(
+      device->create_descriptor_pool({lighting.temp.get()}, {1}));
+  lighting.set = ovk::make_unique(std::move(
+      device->make_descriptor_sets(*lighting.pool, 1, *lighting.temp)
+          .front()));
+
   // Sync Primitives
-  sync.image_available = device->create_semaphores(MAX_FRAMES_IN_FLIGHT);
-  sync.render_finished = device->create_semaphores(MAX_FRAMES_IN_FLIGHT);
-  sync.in_flight_fences = device->create_fences(
-      MAX_FRAMES_IN_FLIGHT, vk::FenceCreateFlagBits::eSignaled);
+  pacer = std::make_unique<ovk::FramePacer>(
+      *device, ovk::FramePacer::Settings{2, swapchain->present_mode});
 
   spdlog::info("created const objects");
 }
@@ -162,28 +204,52 @@ void Renderer::create_dynamic_objects() {
 
   const auto depth_format = device->default_depth_format();
 
-  depth.image = ovk::make_unique(device->create_image(
-      vk::ImageType::e2D, depth_format.value(),
-      vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height,
-                   1),
-      vk::ImageUsageFlagBits::eDepthStencilAttachment,
-      vk::ImageTiling::eOptimal, ovk::mem::MemoryType::device_local));
+  // Depth, albedo and normal are only used inside the render pass
+  depth.image = ovk::make_unique(device->create_transient_attachment(
+      depth_format.value(), swapchain->swap_extent,
+      vk::ImageUsageFlagBits::eDepthStencilAttachment |
+          vk::ImageUsageFlagBits::eInputAttachment));
 
   depth.view = ovk::make_unique(
       device->view_from_image(*depth.image, vk::ImageAspectFlagBits::eDepth));
 
-  pipeline = ovk::make_unique(
+  const auto gbuffer_usage = vk::ImageUsageFlagBits::eColorAttachment |
+                             vk::ImageUsageFlagBits::eInputAttachment;
+  gbuffer.albedo = ovk::make_unique(device->create_transient_attachment(
+      GBUFFER_ALBEDO_FORMAT, swapchain->swap_extent, gbuffer_usage));
+  gbuffer.normal = ovk::make_unique(device->create_transient_attachment(
+      GBUFFER_NORMAL_FORMAT, swapchain->swap_extent, gbuffer_usage));
+  gbuffer.albedo_view =
+      ovk::make_unique(device->view_from_image(*gbuffer.albedo));
+  gbuffer.normal_view =
+      ovk::make_unique(device->view_from_image(*gbuffer.normal));
+
+  ovk::DescriptorWriter()
+      .write_image(*lighting.set, 0, {}, gbuffer.albedo_view->handle.get(),
+                   vk::ImageLayout::eShaderReadOnlyOptimal,
+                   vk::DescriptorType::eInputAttachment)
+      .write_image(*lighting.set, 1, {}, gbuffer.normal_view->handle.get(),
+                   vk::ImageLayout::eShaderReadOnlyOptimal,
+                   vk::DescriptorType::eInputAttachment)
+      .write_image(*lighting.set, 2, {}, depth.view->handle.get(),
+                   vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+                   vk::DescriptorType::eInputAttachment)
+      .flush();
+
+  gbuffer.pipeline = ovk::make_unique(
       device->build_pipeline()
           .set_render_pass(*render_pass, /*subpass index: */ 0)
-          // This will add a Spir-V Shader from a File
+          // This will compile the GLSL Shader from a File (cached on disk)
           .add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex,
-                                      "res/shaders/triangle.vert.spv")
+                                      "res/shaders/gbuffer.vert", true)
           .add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment,
-                                      "res/shaders/triangle.frag.spv")
+                                      "res/shaders/gbuffer.frag", true)
           .set_vertex_layout<RenderVertex>()
           // Will add depth test to this pipeline (using our depth target)
           .set_depth_stencil()
-          .add_descriptor_set_layouts({descriptor.temp->handle.get()})
+          // Albedo and normal, blending makes no sense for a G-buffer
+          .set_color_blend(2, false)
+          .add_descriptor_templates({descriptor.temp.get()})
           .add_viewport(glm::vec2(0, 0),
                         glm::vec2(swapchain->swap_extent.width,
                                   swapchain->swap_extent.height),
@@ -193,6 +259,25 @@ void Renderer::create_dynamic_objects() {
 
   );
 
+  lighting.pipeline = ovk::make_unique(
+      device->build_pipeline()
+          .set_render_pass(*render_pass, /*subpass index: */ 1)
+          .add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex,
+                                      "res/shaders/lighting.vert", true)
+          .add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment,
+                                      "res/shaders/lighting.frag", true)
+          // Fullscreen triangle from gl_VertexIndex
+          .set_vertex_layout({}, {})
+          .set_depth_stencil(false, false)
+          .set_color_blend(1, false)
+          .add_descriptor_templates({lighting.temp.get()})
+          .add_viewport(glm::vec2(0, 0),
+                        glm::vec2(swapchain->swap_extent.width,
+                                  swapchain->swap_extent.height),
+                        0.0f, 1.0f)
+          .add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
+          .build());
+
   // Framebuffers
   framebuffers.clear();
   framebuffers.reserve(swapchain->image_count);
@@ -203,7 +288,8 @@ void Renderer::create_dynamic_objects() {
             *render_pass,
             vk::Extent3D(swapchain->swap_extent.width,
                          swapchain->swap_extent.height, 1),
-            {swap_image, *depth.view})));
+            {swap_image, *gbuffer.albedo_view, *gbuffer.normal_view,
+             *depth.view})));
   }
 
   // Descriptor Pool and Camera Buffers
@@ -218,7 +304,7 @@ void Renderer::create_dynamic_objects() {
   descriptor.uniform_buffers.reserve(swapchain->image_count);
 
   // Demo Data
-  auto &camera_data = camera->get_data();
+  auto &camera_data = camera ? camera->get_data() : fixed_camera;
 
   for (size_t i = 0; i < swapchain->image_count; ++i) {
     descriptor.uniform_buffers.push_back(device->create_uniform_buffer(
@@ -237,23 +323,43 @@ void Renderer::create_dynamic_objects() {
 }
 
 void Renderer::build_cmd_buffers(ovk::RenderCommand &cmd, const int i) {
+  // Clear values in attachment order: swapchain, albedo, normal, depth
   cmd.begin_render_pass(*render_pass, framebuffers[i], swapchain->swap_extent,
-                        {glm::vec4(1.0), glm::vec2(1.0f, 0.0f)}, vk::SubpassContents::eInline);
+                        {glm::vec4(1.0), glm::vec4(0.0), glm::vec4(0.0),
+                         glm::vec2(1.0f, 0.0f)},
+                        vk::SubpassContents::eInline);
 
   {
-    cmd.begin_region("Game Rendering", glm::vec4(0.23f, 0.34f, 0.87f, 1.00f));
+    cmd.begin_region("G-Buffer", glm::vec4(0.23f, 0.34f, 0.87f, 1.00f));
 
-    cmd.bind_graphics_pipeline(*pipeline);
-    cmd.bind_descriptor_sets(*pipeline, 0, {descriptor.sets[i]});
+    cmd.bind_graphics_pipeline(*gbuffer.pipeline);
+    cmd.bind_descriptor_sets(*gbuffer.pipeline, 0, {descriptor.sets[i]});
 
     cmd.bind_vertex_buffers(0, {ovk::RenderCommand::BufferDescription{
                                    std::ref(*render_model->vertex), 0}});
-    cmd.draw(render_model->draw_count, 1, 0, 0);
+    if (render_model->index) {
+      cmd.bind_index_buffer(*render_model->index, 0, render_model->index_type);
+      cmd.draw_indexed(render_model->draw_count, 1, 0, 0, 0);
+    } else {
+      cmd.draw(render_model->draw_count, 1, 0, 0);
+    }
 
     cmd.end_region();
   }
 
+  cmd.next_subpass();
+
   {
+    cmd.begin_region("Lighting", glm::vec4(0.82f, 0.64f, 0.25f, 1.00f));
+
+    cmd.bind_graphics_pipeline(*lighting.pipeline);
+    cmd.bind_descriptor_sets(*lighting.pipeline, 0, {*lighting.set});
+    cmd.draw(3, 1, 0, 0);
+
+    cmd.end_region();
+  }
+
+  if (imgui) {
     cmd.begin_region("ImGui Rendering", glm::vec4(0.87f, 0.21f, 0.11f, 1.00f));
     cmd.draw_imgui(*imgui, i, ImGui::GetDrawData());
     cmd.end_region();
@@ -1,10 +1,13 @@
 #include "app/camera.h"
 #include "gui/gui_renderer.h"
 #include <base/device.h>
+#include <base/frame_pacer.h>
 
 #include <util/model_loader.h>
 
-constexpr auto MAX_FRAMES_IN_FLIGHT = 2;
+// G-buffer formats, every attachment of a render pass needs its own description (so its own format here)
+constexpr auto GBUFFER_ALBEDO_FORMAT = vk::Format::eR8G8B8A8Unorm;
+constexpr auto GBUFFER_NORMAL_FORMAT = vk::Format::eA2B10G10R10UnormPack32;
 
 struct RenderVertex {
   glm::vec3 pos;
@@ -21,14 +24,17 @@ struct Renderable {
 struct Renderer {
 
   ovk::Device *device;
+  // nullptr when headless, the swapchain is offscreen then and there is no
+  // camera input or ImGui
   ovk::Surface *surface;
   ovk::util::Model *render_model;
 
   std::unique_ptr<ovk::FirstPersonCamera> camera;
+  // Used without a camera, the initial view of the camera
+  ovk::CameraData fixed_camera;
 
   std::unique_ptr<ovk::SwapChain> swapchain;
   std::unique_ptr<ovk::RenderPass> render_pass;
-  std::unique_ptr<ovk::GraphicsPipeline> pipeline;
   std::vector<ovk::Framebuffer> framebuffers;
 
   std::vector<std::unique_ptr<ovk::RenderCommand>> commands;
@@ -46,15 +52,27 @@ struct Renderer {
     std::unique_ptr<ovk::ImageView> view;
   } depth;
 
+  // Subpass 0, the attachments never leave the render pass (transient)
   struct {
-    std::vector<ovk::Semaphore> image_available, render_finished;
-    std::vector<ovk::Fence> in_flight_fences;
-    uint32_t current_frame = 0;
-  } sync;
+    std::unique_ptr<ovk::Image> albedo, normal;
+    std::unique_ptr<ovk::ImageView> albedo_view, normal_view;
+    std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+  } gbuffer;
+
+  // Subpass 1, reads the G-buffer (and depth) as input attachments
+  struct {
+    std::unique_ptr<ovk::DescriptorTemplate> temp;
+    std::unique_ptr<ovk::DescriptorPool> pool;
+    std::unique_ptr<ovk::DescriptorSet> set;
+    std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+  } lighting;
+
+  std::unique_ptr<ovk::FramePacer> pacer;
 
   std::unique_ptr<ovk::ImGuiRenderer> imgui;
 
   // PUBLIC API
+  // surface may be nullptr to render into an offscreen swapchain
   Renderer(ovk::Device *device, ovk::Surface *surface,
            ovk::util::Model *render_model);
   void recreate_swapchain();
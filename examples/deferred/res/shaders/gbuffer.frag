@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout (location = 0) in vec3 pass_normal;
+
+// G-buffer, read by lighting.frag as input attachments
+layout (location = 0) out vec4 out_albedo;
+layout (location = 1) out vec4 out_normal;
+
+const vec3 material_color = vec3(0.639282, 0.483062, 0.269731);
+
+void main() {
+	out_albedo = vec4(material_color, 1.0);
+	// Unorm target, so pack the normal into [0, 1]
+	out_normal = vec4(normalize(pass_normal) * 0.5 + 0.5, 0.0);
+}
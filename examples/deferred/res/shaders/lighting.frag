@@ -0,0 +1,33 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Written by the G-buffer subpass, only the current pixel can be read
+layout (input_attachment_index = 0, binding = 0) uniform subpassInput in_albedo;
+layout (input_attachment_index = 1, binding = 1) uniform subpassInput in_normal;
+layout (input_attachment_index = 2, binding = 2) uniform subpassInput in_depth;
+
+layout (location = 0) out vec4 color;
+
+const vec3 clear_color = vec3(1.0f, 1.0f, 1.0f);
+
+const vec3 light_dir = normalize(vec3(5.0f, 8.0f, 3.0f));
+const vec3 light_color = vec3(1.0f, 1.0f, 1.0f);
+
+void main() {
+	// Nothing was drawn here
+	if (subpassLoad(in_depth).r >= 1.0f) {
+		color = vec4(clear_color, 1.0f);
+		return;
+	}
+
+	const vec3 material_color = subpassLoad(in_albedo).rgb;
+	const vec3 normal = normalize(subpassLoad(in_normal).xyz * 2.0f - 1.0f);
+
+	float ambient_strength = 0.15f;
+	vec3 ambient = ambient_strength * light_color * material_color;
+
+	float diff = max(dot(normal, light_dir), 0.15f);
+	vec3 diffuse = diff * light_color * material_color;
+
+	color = vec4(ambient + diffuse, 1.0);
+}
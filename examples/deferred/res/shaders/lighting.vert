@@ -0,0 +1,8 @@
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+
+// Fullscreen triangle, no vertex buffer needed
+void main() {
+	const vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+}
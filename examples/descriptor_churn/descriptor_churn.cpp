@@ -0,0 +1,113 @@
+#include <base/device.h>
+#include <base/instance.h>
+#include <spdlog/spdlog.h>
+#include <ui/renderer.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Creates and destroys the descriptor sets of ui::TexturedRects every frame,
+// the way ui::Renderer::create_textured_rect does without a bindless table,
+// and reports the time and how many sets were taken from the pools
+// Usage: descriptor_churn [frames] [rects per frame]
+//
+// before: one DescriptorSet::write per binding, and the set is dropped with
+//         the rect (never handed back to the allocator)
+// after:  one DescriptorSet::update through an update template, and the rect
+//         frees its set so the next one reuses it
+// Runs headless, nothing is drawn, so only the descriptor work is measured
+
+// What every rect points to
+struct Resources {
+  const ovk::DescriptorTemplate &descriptor_template;
+  const ovk::DescriptorUpdateTemplate &update_template;
+  ovk::Buffer &uniform_buffer;
+  ovk::ImageView &view;
+  ovk::Sampler &sampler;
+};
+
+enum class Mode { before, after };
+
+static void run(const char *name, Mode mode, const Resources &resources,
+                ovk::Device &device, uint32_t frames,
+                uint32_t rects_per_frame) {
+  ovk::DescriptorAllocator allocator(device);
+  const auto layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+  std::vector<ovk::ui::TexturedRect> rects;
+  rects.reserve(rects_per_frame);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t frame = 0; frame < frames; frame++) {
+    for (uint32_t i = 0; i < rects_per_frame; i++) {
+      auto set = allocator.allocate(resources.descriptor_template);
+      const glm::vec2 pos(static_cast<float>(i), 0.0f), scale(1.0f);
+
+      if (mode == Mode::before) {
+        set.write(resources.uniform_buffer, 0, 0);
+        set.write(resources.sampler.handle.get(), resources.view.handle.get(),
+                  layout, 1);
+        rects.emplace_back(std::move(set), pos, scale);
+      } else {
+        set.update(
+            resources.update_template,
+            {ovk::descriptor::Data::from_buffer(resources.uniform_buffer),
+             ovk::descriptor::Data::from_image(resources.sampler.handle.get(),
+                                               resources.view.handle.get(),
+                                               layout)});
+        rects.emplace_back(allocator, resources.descriptor_template,
+                           std::move(set), pos, scale);
+      }
+    }
+    // The frame is over, the UI throws its rects away
+    rects.clear();
+  }
+  const std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+
+  const auto rect_count = static_cast<double>(frames) * rects_per_frame;
+  spdlog::info("{:<7} {:8.1f} ms ({:.2f} us per rect), {} sets from {} pools",
+               name, time.count(), time.count() * 1000.0 / rect_count,
+               allocator.persistent_set_count(), allocator.pool_count());
+}
+
+int main(int argc, char **argv) {
+  uint32_t frames = 1000, rects_per_frame = 64;
+  if (argc > 1)
+    frames = static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10));
+  if (argc > 2)
+    rects_per_frame = static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10));
+
+  auto instance = ovk::Instance::create_headless({"Descriptor Churn", 0, 0, 1});
+  auto device = instance.create_device({}, vk::PhysicalDeviceFeatures());
+
+  auto descriptor_template =
+      device.build_descriptor_template()
+          .add_uniform_buffer(0, vk::ShaderStageFlagBits::eVertex)
+          .add_sampler(1, vk::ShaderStageFlagBits::eFragment)
+          .build();
+  auto update_template =
+      device.create_descriptor_update_template(descriptor_template);
+
+  auto projection = glm::mat4(1.0f);
+  auto uniform_buffer = device.create_uniform_buffer(
+      projection, ovk::mem::MemoryType::cpu_coherent_and_cached,
+      {ovk::QueueType::graphics});
+  auto image = device.create_image(
+      vk::ImageType::e2D, vk::Format::eR8G8B8A8Unorm, vk::Extent3D(4, 4, 1),
+      vk::ImageUsageFlagBits::eSampled, vk::ImageTiling::eOptimal,
+      ovk::mem::MemoryType::device_local);
+  auto view = device.view_from_image(image);
+
+  Resources resources{descriptor_template, update_template, uniform_buffer,
+                      view, device.get_default_nearest_sampler()};
+
+  spdlog::info("{} frames with {} rects each", frames, rects_per_frame);
+  run("before", Mode::before, resources, device, frames, rects_per_frame);
+  run("after", Mode::after, resources, device, frames, rects_per_frame);
+
+  device.wait_idle();
+  return 0;
+}
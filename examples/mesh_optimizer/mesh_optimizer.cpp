@@ -0,0 +1,174 @@
+#include <spdlog/spdlog.h>
+
+#include <util/loader/obj_parser.h>
+#include <util/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Prints the simulated vertex cache efficiency and an overdraw estimate of the
+// bundled models after every pass of ParseOptions::optimize_mesh, in the same
+// order load_model runs them. No device is needed, so this runs anywhere
+// Usage: mesh_optimizer [model.obj...], without arguments it loads the models
+// of the deferred example (run from the examples directory)
+
+struct Mesh {
+  std::vector<uint32_t> indices;
+  std::vector<glm::vec3> positions;
+};
+
+// Welds the corners with the same position, normal and texcoord like
+// load_model, the vertices only keep the position since nothing else is
+// needed here
+static std::optional<Mesh> load_mesh(const std::string &path) {
+  const auto obj = ovk::util::parse_obj_file(path);
+  if (!obj)
+    return std::nullopt;
+
+  Mesh mesh;
+  std::map<std::tuple<int32_t, int32_t, int32_t>, uint32_t> unique_vertices;
+  for (const auto &corner : obj->indices) {
+    const auto [it, inserted] = unique_vertices.try_emplace(
+        std::make_tuple(corner.position, corner.normal, corner.texcoord),
+        static_cast<uint32_t>(mesh.positions.size()));
+    if (inserted) {
+      glm::vec3 position(0.0f);
+      if (corner.position >= 0) {
+        const auto p = &obj->positions[3 * corner.position];
+        position = glm::vec3(p[0], p[1], p[2]);
+      }
+      mesh.positions.push_back(position);
+    }
+    mesh.indices.push_back(it->second);
+  }
+  return mesh;
+}
+
+static ovk::util::VertexCacheStats analyze(const Mesh &mesh) {
+  return ovk::util::analyze_vertex_cache(mesh.indices, mesh.positions.size());
+}
+
+// Rasterizes the mesh in index order with a depth test from the 6 axis
+// directions (orthographic, no culling) and returns the shaded fragments per
+// covered pixel, 1 means every pixel was shaded once
+static double estimate_overdraw(const Mesh &mesh) {
+  constexpr int resolution = 256;
+  constexpr float empty = std::numeric_limits<float>::max();
+
+  glm::vec3 min(empty), max(-empty);
+  for (const auto &p : mesh.positions) {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+
+  uint64_t shaded = 0, covered = 0;
+  std::vector<float> depth(resolution * resolution);
+  for (int axis = 0; axis < 3; axis++) {
+    const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+    const auto extent = std::max(max[u] - min[u], max[v] - min[v]);
+    const auto scale = extent > 0.0f ? (resolution - 1) / extent : 0.0f;
+
+    for (const float direction : {1.0f, -1.0f}) {
+      std::fill(depth.begin(), depth.end(), empty);
+      for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3) {
+        // Screen space x, y and depth of the corners
+        std::array<glm::vec3, 3> s;
+        for (uint32_t k = 0; k < 3; k++) {
+          const auto &p = mesh.positions[mesh.indices[t + k]];
+          s[k] = glm::vec3((p[u] - min[u]) * scale, (p[v] - min[v]) * scale,
+                           direction * p[axis]);
+        }
+
+        const auto edge = [](glm::vec3 a, glm::vec3 b, float x, float y) {
+          return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+        };
+        const auto area = edge(s[0], s[1], s[2].x, s[2].y);
+        if (std::abs(area) < 1e-12f)
+          continue;
+
+        // Bounding box, the positions are never below 0 or above resolution
+        const auto low = glm::min(glm::min(s[0], s[1]), s[2]);
+        const auto high = glm::ceil(glm::max(glm::max(s[0], s[1]), s[2]));
+        const auto x1 = std::min(resolution - 1, static_cast<int>(high.x));
+        const auto y1 = std::min(resolution - 1, static_cast<int>(high.y));
+        for (int y = static_cast<int>(low.y); y <= y1; y++) {
+          for (int x = static_cast<int>(low.x); x <= x1; x++) {
+            const auto px = x + 0.5f, py = y + 0.5f;
+            const auto w0 = edge(s[1], s[2], px, py) / area;
+            const auto w1 = edge(s[2], s[0], px, py) / area;
+            const auto w2 = 1.0f - w0 - w1;
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+              continue;
+
+            auto &d = depth[y * resolution + x];
+            const auto z = w0 * s[0].z + w1 * s[1].z + w2 * s[2].z;
+            if (z < d) {
+              covered += d == empty;
+              shaded++;
+              d = z;
+            }
+          }
+        }
+      }
+    }
+  }
+  return covered ? static_cast<double>(shaded) / covered : 0.0;
+}
+
+// Runs pass on mesh and prints the stats afterwards
+template <typename F>
+static void run_pass(const char *name, const Mesh &mesh, F pass) {
+  const auto start = std::chrono::steady_clock::now();
+  pass();
+  const std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+
+  const auto stats = analyze(mesh);
+  spdlog::info("  {:<12} ACMR {:.3f}, ATVR {:.3f}, overdraw {:.3f} ({:.2f} ms)",
+               name, stats.acmr, stats.atvr, estimate_overdraw(mesh),
+               time.count());
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> paths(argv + 1, argv + argc);
+  if (paths.empty())
+    for (const auto name : {"Horse", "cow", "lamp", "pug", "wolf"})
+      paths.push_back(std::string("deferred/res/models/") + name + ".obj");
+
+  for (const auto &path : paths) {
+    auto mesh = load_mesh(path);
+    if (!mesh) {
+      spdlog::error("failed to open {}", path);
+      continue;
+    }
+
+    const auto input = analyze(*mesh);
+    spdlog::info("{}: {} triangles, {} vertices", path,
+                 mesh->indices.size() / 3, mesh->positions.size());
+    spdlog::info("  {:<12} ACMR {:.3f}, ATVR {:.3f}, overdraw {:.3f}", "input",
+                 input.acmr, input.atvr, estimate_overdraw(*mesh));
+
+    const auto vertex_count = mesh->positions.size();
+    run_pass("vertex cache", *mesh, [&]() {
+      ovk::util::optimize_vertex_cache(mesh->indices, vertex_count);
+    });
+    run_pass("overdraw", *mesh, [&]() {
+      ovk::util::optimize_overdraw(mesh->indices, mesh->positions);
+    });
+    run_pass("vertex fetch", *mesh, [&]() {
+      ovk::util::optimize_vertex_fetch(
+          mesh->indices, reinterpret_cast<uint8_t *>(mesh->positions.data()),
+          vertex_count, sizeof(glm::vec3));
+    });
+  }
+
+  return 0;
+}
@@ -0,0 +1,202 @@
+#include <spdlog/spdlog.h>
+
+#include <util/loader/obj_parser.h>
+#include <util/mesh_cache.h>
+#include <util/thread_pool.h>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Times ovk::util::parse_obj_data against tinyobj::LoadObj on a generated
+// OBJ and prints the throughput of both
+// Usage: obj_bench [grid size] [parse|cache], the default of 1000 generates
+// about 180 MB
+//
+// parse (default): tinyobj against parse_obj_data
+// cache: a cold load (parse the file and write the ovk::util::MeshCache)
+//        against a load from the cache. Both stop before welding and the mesh
+//        optimizations, which load_model skips on a cache hit as well, so its
+//        real saving is larger
+
+// Grid of size x size vertices with positions, normals and texcoords, faces
+// are a mix of triangles and quads with and without texcoords like an export
+// of a typical modeling tool
+static std::string generate_obj(uint32_t size) {
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+  std::string obj = "# generated by obj_bench\no grid\n";
+  for (uint32_t y = 0; y < size; y++) {
+    for (uint32_t x = 0; x < size; x++) {
+      obj += fmt::format("v {:.6f} {:.6f} {:.6f}\n", x * 0.01f,
+                         distribution(random), y * 0.01f);
+      obj += fmt::format("vn {:.6f} {:.6f} {:.6f}\n", distribution(random),
+                         distribution(random), distribution(random));
+      obj += fmt::format("vt {:.6f} {:.6f}\n", static_cast<float>(x) / size,
+                         static_cast<float>(y) / size);
+    }
+  }
+
+  obj += "s off\n";
+  for (uint32_t y = 0; y + 1 < size; y++) {
+    for (uint32_t x = 0; x + 1 < size; x++) {
+      const auto a = y * size + x + 1, b = a + 1, c = a + size, d = c + 1;
+      if ((x + y) % 7 == 0)
+        obj += fmt::format(
+            "f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2} {3}/{3}/{3}\n", a, b, d, c);
+      else if ((x + y) % 5 == 0)
+        obj += fmt::format("f {0}//{0} {1}//{1} {2}//{2}\n", a, b, d);
+      else
+        obj += fmt::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n"
+                           "f {0}/{0}/{0} {2}/{2}/{2} {3}/{3}/{3}\n",
+                           a, b, d, c);
+    }
+  }
+  return obj;
+}
+
+// Best of a few runs in seconds, f returns the triangle count so the results
+// can be compared
+template <typename F>
+static double measure(const std::string &name, size_t bytes, F f) {
+  constexpr uint32_t runs = 3;
+  double best = std::numeric_limits<double>::max();
+  size_t triangles = 0;
+  for (uint32_t i = 0; i < runs; i++) {
+    const auto start = std::chrono::steady_clock::now();
+    triangles = f();
+    const std::chrono::duration<double> time =
+        std::chrono::steady_clock::now() - start;
+    best = std::min(best, time.count());
+  }
+
+  spdlog::info("{:<26} {:8.1f} ms {:8.1f} MB/s ({} triangles)", name,
+               best * 1000.0, bytes / best / 1e6, triangles);
+  return best;
+}
+
+static void run_cache(const std::string &obj, ovk::util::ThreadPool &pool) {
+  using ovk::util::MeshCache;
+
+  const auto path =
+      (std::filesystem::temp_directory_path() / "obj_bench.obj").string();
+  std::ofstream(path, std::ios::binary).write(obj.data(), obj.size());
+  constexpr uint64_t key = 1;
+
+  const auto cold_time =
+      measure("cold (parse, write cache)", obj.size(), [&]() {
+        const auto attributes = ovk::util::parse_obj_file(path, &pool);
+        if (!attributes) {
+          spdlog::error("failed to open {}", path);
+          return size_t(0);
+        }
+
+        const auto section = [](const auto &v) {
+          return MeshCache::Section{reinterpret_cast<const uint8_t *>(v.data()),
+                                    v.size() * sizeof(v[0])};
+        };
+        if (!MeshCache::write(path, key,
+                              {section(attributes->positions),
+                               section(attributes->normals),
+                               section(attributes->texcoords),
+                               section(attributes->indices)}))
+          spdlog::error("failed to write the cache of {}", path);
+        return attributes->indices.size() / 3;
+      });
+
+  const auto cached_time =
+      measure("cached (open, validate)", obj.size(), [&]() {
+        const auto cache = MeshCache::open(path, key);
+        if (!cache || cache->section_count() != 4) {
+          spdlog::error("no cache for {}", path);
+          return size_t(0);
+        }
+
+        // Every index is checked against the attributes like load_model does
+        const auto positions = cache->section(0).count<float>() / 3;
+        const auto normals = cache->section(1).count<float>() / 3;
+        const auto texcoords = cache->section(2).count<float>() / 2;
+        const auto corners = cache->section(3);
+        const auto corner_data = corners.as<ovk::util::ObjIndex>();
+        size_t invalid = 0;
+        for (size_t i = 0; i < corners.count<ovk::util::ObjIndex>(); i++) {
+          const auto &corner = corner_data[i];
+          invalid += corner.position >= static_cast<int64_t>(positions) ||
+                     corner.normal >= static_cast<int64_t>(normals) ||
+                     corner.texcoord >= static_cast<int64_t>(texcoords);
+        }
+        if (invalid > 0)
+          spdlog::error("{} invalid indices in the cache", invalid);
+        return corners.count<ovk::util::ObjIndex>() / 3;
+      });
+
+  spdlog::info("speedup of the cache: {:.1f}x", cold_time / cached_time);
+
+  std::filesystem::remove(MeshCache::path_for(path));
+  std::filesystem::remove(path);
+}
+
+int main(int argc, char **argv) {
+  uint32_t size = 1000;
+  if (argc > 1)
+    size = std::max<uint32_t>(std::strtoul(argv[1], nullptr, 10), 2);
+  const std::string mode = argc > 2 ? argv[2] : "parse";
+
+  spdlog::info("generating a {0}x{0} grid", size);
+  const auto obj = generate_obj(size);
+  spdlog::info("{:.1f} MB", obj.size() / 1e6);
+
+  ovk::util::ThreadPool pool;
+
+  if (mode == "cache") {
+    run_cache(obj, pool);
+    return 0;
+  }
+
+  // Both parse from memory, the stream is rewound before every run
+  std::istringstream stream(obj);
+  const auto tinyobj_time = measure("tinyobj::LoadObj", obj.size(), [&]() {
+    stream.clear();
+    stream.seekg(0);
+    tinyobj::attrib_t attribute;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+    std::string warn, error;
+    if (!tinyobj::LoadObj(&attribute, &shapes, &materials, &warn, &error,
+                          &stream))
+      spdlog::error("tinyobj failed: {}", error);
+
+    size_t indices = 0;
+    for (const auto &shape : shapes)
+      indices += shape.mesh.indices.size();
+    return indices / 3;
+  });
+
+  const auto single_time =
+      measure("parse_obj_data (1 thread)", obj.size(), [&]() {
+        const auto result = ovk::util::parse_obj_data(obj.data(), obj.size());
+        return result.indices.size() / 3;
+      });
+
+  const auto pool_name =
+      fmt::format("parse_obj_data ({} threads)", pool.size() + 1);
+  const auto pool_time = measure(pool_name, obj.size(), [&]() {
+    const auto result =
+        ovk::util::parse_obj_data(obj.data(), obj.size(), &pool);
+    return result.indices.size() / 3;
+  });
+
+  spdlog::info("speedup over tinyobj: {:.1f}x (1 thread), {:.1f}x (pool)",
+               tinyobj_time / single_time, tinyobj_time / pool_time);
+  return 0;
+}
@@ -1,21 +1,42 @@
 #include <base/device.h>
+#include <base/frame_capture.h>
 #include <base/instance.h>
-
-void run_example() {
-
-  ovk::Instance instance(ovk::AppInfo{"Triangle", 0, 0, 1}, {});
-
-  auto surface =
-      instance.create_surface(1960, 1080, "Triangle", /*events: */ false);
+#include <base/surface.h>
+
+#include <cctype>
+#include <cstring>
+#include <string>
+
+// headless_frames: render that many frames without a window (eg. on CI with a
+// software ICD like lavapipe) and exit
+// capture_directory: headless only, writes every frame there as png
+void run_example(std::optional<uint32_t> headless_frames,
+                 std::optional<std::string> capture_directory) {
+
+  const auto headless = headless_frames.has_value();
+  const ovk::AppInfo app_info{"Triangle", 0, 0, 1};
+  auto instance = headless ? ovk::Instance::create_headless(app_info)
+                           : ovk::Instance(app_info, {});
+
+  std::optional<ovk::Surface> surface;
+  if (!headless)
+    surface.emplace(
+        instance.create_surface(1960, 1080, "Triangle", /*events: */ false));
   // Device is pretty simple, no extra features and just Swapchain support
-  // extension
-  auto device = instance.create_device({VK_KHR_SWAPCHAIN_EXTENSION_NAME},
-                                       vk::PhysicalDeviceFeatures(), surface);
+  // extension (a headless device does not need it)
+  auto device = headless
+                    ? instance.create_device({}, vk::PhysicalDeviceFeatures())
+                    : instance.create_device({VK_KHR_SWAPCHAIN_EXTENSION_NAME},
+                                             vk::PhysicalDeviceFeatures(),
+                                             *surface);
 
 	spdlog::info("Device created!");
 	
   // Now we can create the swapchain
-  auto swapchain = device.create_swapchain(surface);
+  // Headless it is a set of offscreen images, everything below works the same
+  auto swapchain =
+      headless ? device.create_offscreen_swapchain(vk::Extent2D(1960, 1080))
+               : device.create_swapchain(*surface);
 
   // Now that we have the basic setup of a vulkan program
   // we can start preparing the triangle
@@ -152,22 +173,29 @@ void run_example() {
     device.wait_idle();
 
     int width = 0, height = 0;
-    glfwGetFramebufferSize(surface.window.get(), &width, &height);
+    glfwGetFramebufferSize(surface->window.get(), &width, &height);
     while (width == 0 || height == 0) {
-      glfwGetFramebufferSize(surface.window.get(), &width, &height);
+      glfwGetFramebufferSize(surface->window.get(), &width, &height);
       glfwWaitEvents();
     }
 
     swapchain.handle.invalidate();
-    swapchain = std::move(device.create_swapchain(surface));
+    swapchain = std::move(device.create_swapchain(*surface));
 
     create_dynamic_objects();
   };
 
   // To keep track of the current swapchain image
   auto swapchain_index = 0;
+  uint32_t frame_count = 0;
+
+  std::unique_ptr<ovk::FrameCapture> capture;
+  if (headless && capture_directory)
+    capture = std::make_unique<ovk::FrameCapture>(device);
+
 	spdlog::info("Entering Loop!");
-  while (surface.update()) {
+  while (headless ? frame_count < *headless_frames : surface->update()) {
+    frame_count++;
     // Acquire new image
     device.wait_fences({sync.in_flight_fences[sync.current_frame]});
 
@@ -188,6 +216,16 @@ void run_example() {
         {sync.render_finished[sync.current_frame]},
         sync.in_flight_fences[sync.current_frame]);
 
+    // Offscreen images end the render pass in TransferSrcOptimal
+    if (capture) {
+      capture->capture(swapchain.images[swapchain_index],
+                       vk::ImageLayout::eTransferSrcOptimal,
+                       swapchain.swap_extent, swapchain.format.format,
+                       fmt::format("{}/frame_{:04}.png", *capture_directory,
+                                   frame_count));
+      capture->update();
+    }
+
     recreate = device.present_image(swapchain, swapchain_index,
                                     {sync.render_finished[sync.current_frame]});
     if (recreate)
@@ -197,12 +235,31 @@ void run_example() {
   }
 
   device.wait_idle();
+  spdlog::info("Rendered {} frames", frame_count);
+  if (capture) {
+    capture->flush();
+    const auto &stats = capture->get_stats();
+    spdlog::info("Captured {} frames ({} dropped), record {:.3f} ms, readback "
+                 "latency {:.3f} ms, encode {:.3f} ms",
+                 stats.captured, stats.dropped, stats.record_time,
+                 stats.readback_latency, stats.encode_time);
+  }
   // -> RAII does its stuff autmagically
 }
 
 int main(int argc, char** argv) {
+	// --headless [frames] [--capture directory]
+	std::optional<uint32_t> headless_frames;
+	std::optional<std::string> capture_directory;
+	for (auto i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--headless"))
+			headless_frames = i + 1 < argc && isdigit(argv[i + 1][0]) ? static_cast<uint32_t>(std::stoul(argv[i + 1])) : 100u;
+		else if (!strcmp(argv[i], "--capture") && i + 1 < argc)
+			capture_directory = argv[i + 1];
+	}
+
 	try {
-		run_example();
+		run_example(headless_frames, capture_directory);
 	} catch(const std::exception& e) {
 		spdlog::critical("Exception Thrown");
 		spdlog::critical(e.what());
@@ -1,8 +1,14 @@
 #include "mesh.h"
 
 #include <base/device.h>
+#include <util/mesh_cache.h>
+#include <util/profiler.h>
 
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+// ovk parses obj files itself, tinyobj is only used here (for the materials)
+#define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
 #include <noise/noise.h>
@@ -12,8 +18,8 @@
 
 #include "..\world\world.h"
 
-Mesh::Mesh(ovk::Buffer &&buffer, uint32_t count, uint32_t offset)
-    : vertex(std::move(buffer)), vertices_count(count), dynamic_offset(offset) {
+Mesh::Mesh(ovk::Buffer &&buffer, uint32_t count, uint32_t material)
+    : vertex(std::move(buffer)), vertices_count(count), material_index(material) {
 }
 
 Model::Model(std::string n, std::vector<std::unique_ptr<Mesh>>&& m)
@@ -22,20 +28,11 @@ Model::Model(std::string n, std::vector<std::unique_ptr<Mesh>>&& m)
 ModelManager::ModelManager(std::shared_ptr<ovk::Device>& d) : device(d) {
 
 	// create materials buffer
-	// Here are some variables to tweak
-	// Maximum Number of Materials possible
-	const uint32_t material_count = 128;
 	{
-		auto buffer_usage = vk::BufferUsageFlagBits::eUniformBuffer;
-
-		size_t min_buffer_alignment = device->physical_device.getProperties().limits.minUniformBufferOffsetAlignment;
-
-		dynamic_alignment = sizeof(Material);
-		if (min_buffer_alignment > 0) {
-			dynamic_alignment = (dynamic_alignment + min_buffer_alignment - 1) & ~(min_buffer_alignment - 1);
-		}
+		auto buffer_usage = vk::BufferUsageFlagBits::eStorageBuffer;
 
-		const uint32_t size = material_count * dynamic_alignment;
+		// Tightly packed, the shader indexes the array instead of binding every material with a dynamic offset
+		const uint32_t size = max_materials * sizeof(Material);
 
 		materials = ovk::make_unique(device->create_buffer(
 			buffer_usage,
@@ -70,7 +67,23 @@ glm::vec3 to_vec3(float* a) {
 }
 
 
-std::vector<std::unique_ptr<Mesh>> ModelManager::do_load(const std::string filename) {
+// Run of faces with the same material
+struct MeshRange {
+	uint32_t first_vertex;
+	uint32_t vertex_count;
+	// Index into the materials of the file, -1 if none
+	int32_t material;
+};
+
+// Everything do_load needs from the obj, this is what the mesh cache stores
+struct ParsedObj {
+	std::vector<Material> materials;
+	std::vector<MeshRange> ranges;
+	std::vector<MeshVertex> vertices;
+};
+
+static ParsedObj parse_obj(const std::string& filename) {
+	OVK_PROFILE_SCOPE("parse_obj");
 
 	// Load TinyOBJ
 	tinyobj::attrib_t attribute;
@@ -94,26 +107,15 @@ std::vector<std::unique_ptr<Mesh>> ModelManager::do_load(const std::string filen
 	if (!parse_result)
 		spdlog::critical("(load_mesh_from_obj) failed to parse {}", filename);
 
-	std::vector<std::unique_ptr<Mesh>> meshes;
-
-	auto mem_pointer = (uint8_t*) materials->memory->map(*device);
-	auto base_head = materials_head;
+	ParsedObj parsed;
 	for (auto& obj_m : obj_materials) {
-
-		Material material {
+		parsed.materials.push_back(Material {
 											 to_vec3(obj_m.ambient),
 											 to_vec3(obj_m.diffuse),
 											 to_vec3(obj_m.specular),
 											 obj_m.shininess
-		};
-			
-		// Copy it to the plan data buffer
-
-		memcpy(&mem_pointer[(int) materials_head], &material, sizeof(material));
-			
-		materials_head += dynamic_alignment;
+		});
 	}
-	materials->memory->unmap(*device);
 
 	auto to_vertex = [&](tinyobj::index_t& idx) {
 										 const auto vidx = idx.vertex_index;
@@ -135,17 +137,16 @@ std::vector<std::unique_ptr<Mesh>> ModelManager::do_load(const std::string filen
 	ovk_assert(!shapes.empty());
 	for (auto& shape : shapes) {
 		auto&  mesh = shape.mesh;
-		
-		std::vector<MeshVertex> vertices;
 
+		auto first_vertex = parsed.vertices.size();
 		auto push_mesh = [&](int idx) {
-			meshes.push_back(std::make_unique<Mesh>(
-		    std::move(device->create_vertex_buffer(vertices, ovk::mem::MemoryType::device_local)),
-				vertices.size(),
-				base_head + idx * dynamic_alignment
-      ));
+			parsed.ranges.push_back(MeshRange{
+				static_cast<uint32_t>(first_vertex),
+				static_cast<uint32_t>(parsed.vertices.size() - first_vertex),
+				idx
+			});
 
-			vertices.clear();													
+			first_vertex = parsed.vertices.size();
 	  };
 	 
 	
@@ -164,19 +165,141 @@ std::vector<std::unique_ptr<Mesh>> ModelManager::do_load(const std::string filen
 			auto idx1 = mesh.indices[f * 3 + 1];
 			auto idx2 = mesh.indices[f * 3 + 2];
 
-			vertices.push_back(to_vertex(idx0));
-			vertices.push_back(to_vertex(idx1));
-			vertices.push_back(to_vertex(idx2));
+			parsed.vertices.push_back(to_vertex(idx0));
+			parsed.vertices.push_back(to_vertex(idx1));
+			parsed.vertices.push_back(to_vertex(idx2));
 		}
 
 
 		push_mesh(last_material_idx);
 	}
+
+	return parsed;
+}
+
+// FNV-1a of the size and modification time of the material libraries of the obj, the mesh cache only checks the obj
+// itself. Only the mtllib statements before the first vertex are read, which is where exporters put them
+static uint64_t material_libraries_hash(const std::string& filename) {
+	OVK_PROFILE_SCOPE("material_libraries_hash");
+
+	uint64_t hash = 14695981039346656037ull;
+	const auto add = [&hash](uint64_t value) {
+		for (int i = 0; i < 8; i++) {
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	std::ifstream obj(filename);
+	std::string line;
+	while (std::getline(obj, line)) {
+		std::istringstream stream(line);
+		std::string statement;
+		stream >> statement;
+		if (statement == "v" || statement == "f")
+			break;
+		if (statement != "mtllib")
+			continue;
+
+		std::string library;
+		while (stream >> library) {
+			// Same directory as tinyobj is told in parse_obj, missing libraries hash as size and time ~0
+			const auto path = "res/materials/" + library;
+			std::error_code ec;
+			const auto size = std::filesystem::file_size(path, ec);
+			add(ec ? ~0ull : size);
+			const auto time = std::filesystem::last_write_time(path, ec);
+			add(ec ? ~0ull : static_cast<uint64_t>(time.time_since_epoch().count()));
+		}
+	}
+	return hash;
+}
+
+std::vector<std::unique_ptr<Mesh>> ModelManager::do_load(const std::string filename) {
+	OVK_PROFILE_SCOPE("ModelManager::do_load");
+
+	// The cache has to be rebuilt if the layout of what it stores changes, or any material library of the obj
+	constexpr uint64_t layout_key = (1ull << 32) | (sizeof(MeshVertex) << 16) | sizeof(Material);
+	const uint64_t cache_key = layout_key ^ material_libraries_hash(filename);
+
+	// Either points into the mapping of the cache or into parsed
+	const Material* obj_materials;
+	size_t obj_material_count;
+	const MeshRange* ranges;
+	size_t range_count;
+	const MeshVertex* vertices;
+	size_t vertex_count;
+
+	ParsedObj parsed;
+	auto cache = ovk::util::MeshCache::open(filename, cache_key);
+	if (cache && cache->section_count() != 3) cache.reset();
+	if (cache) {
+		obj_materials = cache->section(0).as<Material>();
+		obj_material_count = cache->section(0).count<Material>();
+		ranges = cache->section(1).as<MeshRange>();
+		range_count = cache->section(1).count<MeshRange>();
+		vertices = cache->section(2).as<MeshVertex>();
+		vertex_count = cache->section(2).count<MeshVertex>();
+	} else {
+		parsed = parse_obj(filename);
+		ovk::util::MeshCache::write(filename, cache_key, {
+			{ reinterpret_cast<const uint8_t*>(parsed.materials.data()), parsed.materials.size() * sizeof(Material) },
+			{ reinterpret_cast<const uint8_t*>(parsed.ranges.data()), parsed.ranges.size() * sizeof(MeshRange) },
+			{ reinterpret_cast<const uint8_t*>(parsed.vertices.data()), parsed.vertices.size() * sizeof(MeshVertex) }
+		});
+
+		obj_materials = parsed.materials.data();
+		obj_material_count = parsed.materials.size();
+		ranges = parsed.ranges.data();
+		range_count = parsed.ranges.size();
+		vertices = parsed.vertices.data();
+		vertex_count = parsed.vertices.size();
+	}
+
+	std::vector<std::unique_ptr<Mesh>> meshes;
+
+	auto mem_pointer = (uint8_t*) materials->memory->map(*device);
+	auto base_index = material_count;
+	for (size_t m = 0; m < obj_material_count; m++) {
+		if (material_count == max_materials) {
+			spdlog::error("[ModelManager] (do_load) more than {} materials, {} uses the last one", max_materials, filename);
+			break;
+		}
+
+		// Copy it to the plan data buffer
+
+		memcpy(&mem_pointer[material_count * sizeof(Material)], &obj_materials[m], sizeof(Material));
+			
+		material_count++;
+	}
+	materials->memory->unmap(*device);
+
+	for (size_t r = 0; r < range_count; r++) {
+		const auto& range = ranges[r];
+		if (static_cast<size_t>(range.first_vertex) + range.vertex_count > vertex_count) {
+			spdlog::error("[ModelManager] (do_load) mesh cache of {} is corrupt", filename);
+			break;
+		}
+
+		// Uploaded straight from the cache mapping
+		meshes.push_back(std::make_unique<Mesh>(
+			device->create_buffer(
+				vk::BufferUsageFlagBits::eVertexBuffer,
+				range.vertex_count * sizeof(MeshVertex),
+				const_cast<MeshVertex*>(vertices + range.first_vertex),
+				{ ovk::QueueType::graphics },
+				ovk::mem::MemoryType::device_local
+			),
+			range.vertex_count,
+			std::min(base_index + range.material, max_materials - 1)
+		));
+	}
 	
 	return meshes;
 }
 
 void calculate_terrain(const Terrain* terrain, Chunk* chunk, ovk::Device& device) {
+	OVK_PROFILE_SCOPE("calculate_terrain");
 
 	std::vector<TerrainVertex> vertices;
 	// TODO: this must not be a TerrainVertex but we dont care atm
@@ -24,6 +24,7 @@ struct MeshVertex {
 	glm::vec3 tex_coord;
 };
 
+// Matches the std430 layout of the Materials buffer in mesh.frag (array stride 48)
 struct Material {
 	alignas(16) glm::vec3 ambient;
 	alignas(16) glm::vec3 diffuse;
@@ -32,10 +33,11 @@ struct Material {
 };
 
 struct Mesh {
-	Mesh(ovk::Buffer&& buffer, uint32_t count, uint32_t offset);
+	Mesh(ovk::Buffer&& buffer, uint32_t count, uint32_t material);
 	ovk::Buffer vertex;
 	uint32_t vertices_count;
-	uint32_t dynamic_offset;
+	// Index into ModelManager::materials
+	uint32_t material_index;
 };
 
 struct Model {
@@ -55,8 +57,12 @@ struct ModelManager {
 	std::shared_ptr<ovk::Device> device;
 	std::unordered_map<std::string, Model> models;
 
+	// Maximum Number of Materials possible
+	static constexpr uint32_t max_materials = 128;
+
+	// Storage buffer with all materials, indexed per draw
 	std::unique_ptr<ovk::Buffer> materials;
-	uint32_t materials_head = 0, dynamic_alignment = 0;
+	uint32_t material_count = 0;
 
 	std::vector<std::unique_ptr<Mesh>> do_load(const std::string filename);
 };
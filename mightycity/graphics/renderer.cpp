@@ -2,15 +2,18 @@
 
 #include <gui/gui_renderer.h>
 #include <base/surface.h>
+#include <util/profiler.h>
+#include <util/render_graph.h>
 
 #include "../world/chunk.h"
 #include "../world/world.h"
 
 // Render Defines and constants
-#define MAX_FRAMES_IN_FLIGHT 2
 constexpr auto picker_format = vk::Format::eB8G8R8A8Unorm;
 const auto picker_blit_extent = 100; /*px across*/
 const vk::Extent2D shadow_extent(3000, 3000);
+// Chunks in one direction the picker can encode (specialization constant of terrain_picker.vert)
+constexpr int32_t max_chunks_1D = 32;
 
 
 // *****************************
@@ -46,15 +49,17 @@ void MasterRenderer::post_init(ovk::Buffer* materials_buffer) {
 }
 
 bool MasterRenderer::update(float dt) {
+	OVK_PROFILE_SCOPE("MasterRenderer::update");
+#ifdef DEBUG
+	shader_watcher->poll();
+#endif
 	// Acquire new image
-	device->wait_fences({ sync.in_flight_fences[sync.current_frame] });
-
-	auto [recreate, index] = device->acquire_image(*swapchain, sync.image_available[sync.current_frame]);
-	if (recreate) {
+	const auto index = sync.pacer->begin_frame(*swapchain);
+	if (!index) {
 		recreate_swapchain(); return true;
 	}
 
-	swapchain_index = index;
+	swapchain_index = *index;
 
 	ImGui::NewFrame();
 
@@ -108,6 +113,12 @@ bool MasterRenderer::update(float dt) {
 		// debug draw shadow depth map
 		static bool show_shadow_depth = true;
 		ImGui::Checkbox("Show Shadow Map", &show_shadow_depth);
+
+		// Index is the PCF range of the terrain shader
+		static int shadow_quality = 2;
+		const char* shadow_qualities[] = { "1x1", "3x3", "5x5", "7x7" };
+		if (ImGui::Combo("Shadow PCF", &shadow_quality, shadow_qualities, IM_ARRAYSIZE(shadow_qualities)))
+			terrain->set_pcf_range(shadow_quality);
 		
 		ImGui::End();
 
@@ -117,6 +128,8 @@ bool MasterRenderer::update(float dt) {
 	
 	// Renderer ImGui Windows
 	device->get_default_allocator()->debug_draw();
+	gpu_profiler->debug_draw();
+	sync.pacer->debug_draw();
 
 	
 	return false;
@@ -124,6 +137,7 @@ bool MasterRenderer::update(float dt) {
 }
 
 void MasterRenderer::render() {
+	OVK_PROFILE_SCOPE("MasterRenderer::render");
 
 	// Prepare new uniform buffers
 	auto& camera_data = camera.get_data();
@@ -135,30 +149,30 @@ void MasterRenderer::render() {
 	// TODO: Maybe this shouldn't be here
 	ImGui::Render();
 
- 	device->reset_fences({ sync.in_flight_fences[sync.current_frame] });
-
 		if (dynamic.command_buffers[swapchain_index]) {
 			static auto& pool = device->get_command_pool(ovk::QueueType::graphics);
 			device->device->freeCommandBuffers(pool, { dynamic.command_buffers[swapchain_index]->cmd_handle });
 		}
 
 		dynamic.command_buffers[swapchain_index] = std::make_unique<ovk::RenderCommand>(device->create_render_commands(1, [&](ovk::RenderCommand& cmd, const int) {
+			OVK_PROFILE_SCOPE("build_command_buffer");
 			build_command_buffer(swapchain_index, cmd);
 		})[0]);
 
 
-		device->submit(
-			{ ovk::WaitInfo{ sync.image_available[sync.current_frame], vk::PipelineStageFlagBits::eColorAttachmentOutput } },
+		sync.scheduler->begin_frame(sync.pacer->get_frame());
+		sync.scheduler->add({
+			ovk::QueueType::graphics,
 			{ dynamic.command_buffers[swapchain_index]->cmd_handle },
-			{ sync.render_finished[sync.current_frame] },
-			sync.in_flight_fences[sync.current_frame]
-		);
+			{},
+			{ sync.pacer->get_image_available() },
+			{ sync.pacer->get_render_finished() }
+		});
+		sync.pacer->submit(*sync.scheduler);
 
-	const auto recreate = device->present_image(*swapchain, swapchain_index, { sync.render_finished[sync.current_frame] });
+	const auto recreate = sync.pacer->present(*swapchain);
 		if (recreate) recreate_swapchain();
 
-		sync.current_frame = (sync.current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
-
 
 }
 
@@ -173,9 +187,7 @@ void MasterRenderer::draw_mesh(Model *m, Transform transform) const {
 std::optional<PickInfo> MasterRenderer::pick(glm::vec2 mouse_pos, Terrain& terrain) {
 
 	// NOTE: we blit from the frame before that one so that rendering must be completed
-	int wait_frame = sync.current_frame - 1;
-	if (wait_frame < 0) wait_frame = MAX_FRAMES_IN_FLIGHT - 1;
-	device->wait_fences({ sync.in_flight_fences[wait_frame]});
+	sync.pacer->wait_last_frame();
 	
 	// we need to blit around the cursor
 	auto cmd = device->create_single_submit_cmd(ovk::QueueType::transfer);
@@ -186,10 +198,7 @@ std::optional<PickInfo> MasterRenderer::pick(glm::vec2 mouse_pos, Terrain& terra
 
 	// picker.blit_image->transition_layout(cmd, vk::ImageLayout::eTransferDstOptimal, ovk::QueueType::transfer, *device);
 
-	// Ok Image was already rendered to so it should be in vk::ImageLayout::eColorAttachmentOptimal
-	// NOTE: this only needs to be done because subpasses dont report layout changes to images
-	picker.color_targets[blit_image_idx].set_layout(vk::ImageLayout::eColorAttachmentOptimal);
-	
+	// The render graph that rendered the target wrote its current layout back into the image
 	picker.color_targets[blit_image_idx].transition_layout(cmd, vk::ImageLayout::eTransferSrcOptimal, { ovk::QueueType::transfer }, *device);
 
 	auto in_range = [](float v, float min, float max) {
@@ -238,9 +247,6 @@ std::optional<PickInfo> MasterRenderer::pick(glm::vec2 mouse_pos, Terrain& terra
 	// If white than there is nothing to click
 	if (r == 255 && b == 255 && g == 255) return std::nullopt;
 
-	// HARDCODE: Copy from terrain_picker.vert
-	const auto max_chunks_1D = 32;
-
 	glm::vec3 color = (1 / 255.0f) * glm::vec3(r, g, b);
 	Chunk* found_chunk = nullptr;
 
@@ -411,13 +417,7 @@ uint32_t MasterRenderer::get_index() {
 }
 
 void MasterRenderer::wait_last_frame() {
-	uint32_t last_frame;
-	if (sync.current_frame == 0)
-		last_frame = MAX_FRAMES_IN_FLIGHT - 1;
-	else
-		last_frame = sync.current_frame - 1;
-	
-	device->wait_fences({ sync.in_flight_fences[last_frame] });
+	sync.pacer->wait_last_frame();
 }
 
 void MasterRenderer::create_const_objects() {
@@ -436,6 +436,9 @@ void MasterRenderer::create_const_objects() {
 
 	auto color_attachment = swapchain->get_color_attachment_description();
 
+	attachments.color = color_attachment;
+	attachments.depth = depth_attachment;
+
 	
 	const ovk::GraphicSubpass main_pass {
 		{},
@@ -467,6 +470,7 @@ void MasterRenderer::create_const_objects() {
 			vk::ImageLayout::eUndefined,
 			vk::ImageLayout::eDepthStencilAttachmentOptimal
 		};
+		attachments.shadow_depth = shadow_depth_attachment;
 		
 		const ovk::GraphicSubpass shadow_prepass {
 			{},
@@ -491,14 +495,21 @@ void MasterRenderer::create_const_objects() {
 	
 	lights = LightData { glm::vec3(100.0f, 100.f, 100.f), camera.pos };
 	
-	sync.image_available = device->create_semaphores(MAX_FRAMES_IN_FLIGHT);
-	sync.render_finished = device->create_semaphores(MAX_FRAMES_IN_FLIGHT);
-	sync.in_flight_fences = device->create_fences(MAX_FRAMES_IN_FLIGHT, vk::FenceCreateFlagBits::eSignaled);
+	// Frames in flight, present mode and pacing can be changed at runtime in the "Frame Pacer" window
+	sync.pacer = std::make_unique<ovk::FramePacer>(*device, ovk::FramePacer::Settings{ 2, swapchain->present_mode });
+	sync.scheduler = std::make_unique<ovk::FrameScheduler>(*device, ovk::FramePacer::max_frames_in_flight);
+
+	gpu_profiler = ovk::make_unique(device->create_gpu_profiler(ovk::FramePacer::max_frames_in_flight));
+#ifdef DEBUG
+	// Edit the shaders in res/shader while running
+	shader_watcher = std::make_unique<ovk::ShaderWatcher>(*device);
+#endif
 
 	// Picker Const Things
 	{
 		color_attachment.format = picker_format;
 		color_attachment.finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+		attachments.picker_color = color_attachment;
 		
 		const ovk::GraphicSubpass picker_subpass{
 			{},
@@ -561,33 +572,27 @@ void MasterRenderer::create_dynamic_objects() {
 		glm::mat4(1.0)
 	};
 	
+	shadow.light_buffer.clear();
 	for (auto i = 0; i < swapchain->image_count; i++) {
 		shadow.light_buffer.push_back(std::move(device->create_uniform_buffer(light_uniform, ovk::mem::MemoryType::cpu_coherent_and_cached, { ovk::QueueType::graphics })));
-		
-		shadow.descriptor_sets[i].write(shadow.light_buffer[i], 0, 0);
 	}
+
+	ovk::DescriptorWriter shadow_writer;
+	for (auto i = 0; i < swapchain->image_count; i++) shadow_writer.write_buffer(shadow.descriptor_sets[i], 0, shadow.light_buffer[i]);
+	shadow_writer.flush();
 		
-	// Create Depth Ressources
-	depth.image = ovk::make_unique(device->create_image(
-		vk::ImageType::e2D,
-		depth_format.value(),
-		vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height, 1),
-		vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageTiling::eOptimal, ovk::mem::MemoryType::device_local
-	));
+	dynamic.command_buffers.resize(swapchain->image_count);
 
-	depth.view = ovk::make_unique(device->view_from_image(*depth.image, vk::ImageAspectFlagBits::eDepth));
+	// because format required 4 bytes (maybe we should have a utility function in ovk that tells us the size of given format)
+	const vk::DeviceSize buffer_size = picker_blit_extent * picker_blit_extent * 4;
 
-	for (auto i = 0; i < swapchain->image_count; i++) {
-		auto &swap_image = swapchain->image_views[i];
-		dynamic.swapchain_framebuffers.push_back(
-			std::forward<ovk::Framebuffer>(
-				device->create_framebuffer(
-					*render_pass,
-					vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height, 1),
-					{ swap_image, *depth.view })));
-	}
-
-	dynamic.command_buffers.resize(swapchain->image_count);
+	picker.pick_buffer = ovk::make_unique(device->create_buffer(
+		vk::BufferUsageFlagBits::eTransferDst,
+		buffer_size,
+		nullptr,
+		{ ovk::QueueType::transfer },
+		ovk::mem::MemoryType::cpu_coherent_and_cached
+	));
 
 	auto& camera_data = camera.get_data();
 
@@ -596,52 +601,81 @@ void MasterRenderer::create_dynamic_objects() {
 		dynamic.light_uniform_buffers.push_back(std::move(device->create_uniform_buffer(lights, ovk::mem::MemoryType::cpu_coherent_and_cached, { ovk::QueueType::graphics })));
 	}
 
-	// Picker dynamic Stuff
-	{
-		picker.depth_image = ovk::make_unique(device->create_image(
+	create_extent_objects();
+}
+
+void MasterRenderer::create_extent_objects() {
+
+	const auto depth_format = device->default_depth_format();
+	const auto extent = swapchain->swap_extent;
+	const auto allocation_extent = ovk::attachment_extent(extent);
+
+	// Frames in flight still render into the old attachments, the pacer destroys them once they are done
+	auto& pacer = *sync.pacer;
+	pacer.retire(std::move(dynamic.swapchain_framebuffers));
+	pacer.retire(std::move(picker.framebuffers));
+	dynamic.swapchain_framebuffers.clear();
+	picker.framebuffers.clear();
+
+	// Depth and picker targets only grow, after shrinking the framebuffers just use the top left corner of them
+	const auto create_depth_target = [&](std::unique_ptr<ovk::Image>& image, std::unique_ptr<ovk::ImageView>& view) {
+		if (image && image->covers(extent)) return;
+		pacer.retire(std::move(image));
+		pacer.retire(std::move(view));
+
+		image = ovk::make_unique(device->create_image(
 			vk::ImageType::e2D,
 			depth_format.value(),
-			vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height, 1),
+			allocation_extent,
 			vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::ImageTiling::eOptimal, ovk::mem::MemoryType::device_local
 		));
+		view = ovk::make_unique(device->view_from_image(*image, vk::ImageAspectFlagBits::eDepth));
+	};
 
-		picker.depth_view = ovk::make_unique(device->view_from_image(*picker.depth_image, vk::ImageAspectFlagBits::eDepth));
-
-		picker.color_targets.clear();
-		picker.color_target_views.clear();
-		picker.framebuffers.clear();
-		
-		for (auto i = 0; i < swapchain->image_count; i++) {
+	// Create Depth Ressources
+	create_depth_target(depth.image, depth.view);
 
-			picker.color_targets.push_back(
-				std::move(device->create_image(
-					vk::ImageType::e2D, 
-					picker_format, 
-					vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height, 1),
-					vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eColorAttachment, vk::ImageTiling::eOptimal, ovk::mem::MemoryType::device_local
-				)));
+	for (auto i = 0; i < swapchain->image_count; i++) {
+		auto &swap_image = swapchain->image_views[i];
+		dynamic.swapchain_framebuffers.push_back(
+			std::forward<ovk::Framebuffer>(
+				device->create_framebuffer(
+					*render_pass,
+					vk::Extent3D(extent.width, extent.height, 1),
+					{ swap_image, *depth.view })));
+	}
 
-			picker.color_target_views.push_back(
-				std::move(device->view_from_image(picker.color_targets[i], vk::ImageAspectFlagBits::eColor)));
+	// Picker dynamic Stuff
+	{
+		create_depth_target(picker.depth_image, picker.depth_view);
+
+		if (picker.color_targets.size() != swapchain->image_count || !picker.color_targets.front().covers(extent)) {
+			pacer.retire(std::move(picker.color_targets));
+			pacer.retire(std::move(picker.color_target_views));
+			picker.color_targets.clear();
+			picker.color_target_views.clear();
+
+			for (auto i = 0; i < swapchain->image_count; i++) {
+				picker.color_targets.push_back(
+					std::move(device->create_image(
+						vk::ImageType::e2D, 
+						picker_format, 
+						allocation_extent,
+						vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eColorAttachment, vk::ImageTiling::eOptimal, ovk::mem::MemoryType::device_local
+					)));
+
+				picker.color_target_views.push_back(
+					std::move(device->view_from_image(picker.color_targets[i], vk::ImageAspectFlagBits::eColor)));
+			}
+		}
 
+		for (auto i = 0; i < swapchain->image_count; i++) {
 			picker.framebuffers.push_back(std::move(
 				device->create_framebuffer(
 					*picker.render_pass,
-					vk::Extent3D(swapchain->swap_extent.width, swapchain->swap_extent.height, 1),
+					vk::Extent3D(extent.width, extent.height, 1),
 					{picker.color_target_views[i], picker.depth_view->handle.get()}
 			)));
-
-			// because format required 4 bytes (maybe we should have a utility function in ovk that tells us the size of given format)
-			const vk::DeviceSize buffer_size = picker_blit_extent * picker_blit_extent * 4;
-
-			picker.pick_buffer = ovk::make_unique(device->create_buffer(
-				vk::BufferUsageFlagBits::eTransferDst,
-				buffer_size,
-				nullptr,
-				{ ovk::QueueType::transfer },
-				ovk::mem::MemoryType::cpu_coherent_and_cached
-			));
-			
 		}
 
 	}
@@ -666,8 +700,7 @@ void MasterRenderer::create_objects() {
 }
 
 void MasterRenderer::recreate_swapchain() {
-
-	device->wait_idle();
+	OVK_PROFILE_SCOPE("MasterRenderer::recreate_swapchain");
 
 	int width = 0, height = 0;
 	glfwGetFramebufferSize(surface->window.get(), &width, &height);
@@ -675,13 +708,26 @@ void MasterRenderer::recreate_swapchain() {
 		glfwGetFramebufferSize(surface->window.get(), &width, &height);
 		glfwWaitEvents();
 	}
-	
+
+	// Handing over the old swapchain keeps presentation going, frames in flight still use it so the pacer destroys it later
+	const auto image_count = swapchain->image_count;
+	auto old_swapchain = std::move(*swapchain);
+	*swapchain = device->create_swapchain(*surface, sync.pacer->get_present_mode(), &old_swapchain);
+	sync.pacer->retire(std::move(old_swapchain));
+
+	if (swapchain->image_count == image_count) {
+		// Pipelines (dynamic viewport), descriptor sets and uniform buffers do not depend on the extent
+		create_extent_objects();
+		imgui->resize(*swapchain);
+		return;
+	}
+
+	// The per image resources change as well, rare enough (eg. a new present mode) to rebuild everything
+	device->wait_idle();
+
 	dynamic = {};
 	depth = {};
 
-	swapchain->handle.invalidate();
-	*swapchain = std::move(device->create_swapchain(*surface));
-
 	create_dynamic_objects();
 
 	imgui->recreate(*swapchain, *render_pass, *device);
@@ -689,15 +735,31 @@ void MasterRenderer::recreate_swapchain() {
 	mesh->recreate();
 
 	create_objects();
+
+	// We waited for the device above, so pipelines nobody holds anymore are safe to destroy
+	device->get_pipeline_registry().collect_unused();
 	
 }
 
 void MasterRenderer::build_command_buffer(uint32_t index, ovk::RenderCommand &cmd) {
 
-	// First we will render to the color picker target
+	// update() already waited on the fence of this frame, so the profiler can read back its last results
+	gpu_profiler->begin_frame(cmd, sync.pacer->get_frame());
 
-	cmd.begin_region("Picker Pass", glm::vec4(0.12f, 0.76f, 0.82f, 1.0f));
-	{
+	ovk::util::RenderGraph graph;
+	const auto picker_color = graph.import_image(picker.color_targets[index]);
+	const auto picker_depth = graph.import_image(*picker.depth_image);
+	const auto shadow_map = graph.import_image(shadow.depth_targets[index]);
+	const auto depth_target = graph.import_image(*depth.image);
+	// The previous contents of the swapchain image are discarded anyway
+	const auto backbuffer = graph.import_image(swapchain->images[index], vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eUndefined);
+
+	// pick() reads the picker target back after the frame
+	graph.mark_output(picker_color);
+	graph.mark_output(backbuffer);
+
+	// First we will render to the color picker target
+	graph.add_pass("Picker Pass", [&](ovk::RenderCommand& cmd) {
 		cmd.begin_render_pass(
 				*picker.render_pass, 
 				picker.framebuffers[index], 
@@ -705,55 +767,74 @@ void MasterRenderer::build_command_buffer(uint32_t index, ovk::RenderCommand &cm
 				{ glm::vec4(1.0), glm::vec2(1.0f, 0.0f) }, 
 				vk::SubpassContents::eInline
 			);
+		cmd.set_viewport_scissor(swapchain->swap_extent);
 
 		terrain->on_picker_render(index, cmd);
 
 		cmd.end_render_pass();
-	}
-	cmd.end_region();
-
-	cmd.begin_render_pass(
-		*shadow.renderpass,
-		shadow.framebuffers[index],
-		shadow_extent,
-		{ glm::vec2(1.0f, 0.0f) },
-		vk::SubpassContents::eInline);
-	{
+	})
+		.set_color(glm::vec4(0.12f, 0.76f, 0.82f, 1.0f))
+		.attachment(picker_color, attachments.picker_color)
+		.attachment(picker_depth, attachments.depth);
+
+	graph.add_pass("Shadow Pass", [&](ovk::RenderCommand& cmd) {
+		cmd.begin_render_pass(
+			*shadow.renderpass,
+			shadow.framebuffers[index],
+			shadow_extent,
+			{ glm::vec2(1.0f, 0.0f) },
+			vk::SubpassContents::eInline);
+
 		// on shadow rendering
 		terrain->on_shadow_render(index, cmd);
 		mesh->on_shadow_render(index, cmd);
-	}
-	cmd.end_render_pass();
 
+		cmd.end_render_pass();
+	})
+		.set_color(glm::vec4(0.45f, 0.45f, 0.45f, 1.0f))
+		.attachment(shadow_map, attachments.shadow_depth);
 
-	// Transition the image layout of the shadow depth attachment
-	{
-		auto &shadow_attachment = shadow.depth_targets[index];
-		shadow_attachment.set_layout(vk::ImageLayout::eDepthStencilAttachmentOptimal);
-		shadow_attachment.transition_layout(cmd.cmd_handle, vk::ImageLayout::eShaderReadOnlyOptimal, ovk::QueueType::graphics, *device);
-	}
-	// Main Render Pass
-	cmd.begin_render_pass(
-		*render_pass,
-		dynamic.swapchain_framebuffers[index],
-		swapchain->swap_extent,
-		{ glm::vec4(1.0f), glm::vec2(1.0f, 0.0f) },
-		vk::SubpassContents::eInline);
+	// Main Render Pass, the terrain samples the shadow map
+	graph.add_pass("Main Pass", [&](ovk::RenderCommand& cmd) {
+		cmd.begin_render_pass(
+			*render_pass,
+			dynamic.swapchain_framebuffers[index],
+			swapchain->swap_extent,
+			{ glm::vec4(1.0f), glm::vec2(1.0f, 0.0f) },
+			vk::SubpassContents::eInline);
+		cmd.set_viewport_scissor(swapchain->swap_extent);
 
-	{
-		cmd.begin_region("Game Rendering", glm::vec4(0.23f, 0.34f, 0.87f, 1.00f));
-		terrain->on_inline_render(index, cmd);
-		mesh->on_inline_render(index, cmd);
-		cmd.end_region();
-	}
-	
-	{
-		cmd.begin_region("ImGui Rendering", glm::vec4(0.87f, 0.21f, 0.11f, 1.00f));
-		cmd.draw_imgui(*imgui, index, ImGui::GetDrawData());
-		cmd.end_region();
-	}
-	
-	cmd.end_render_pass();
+		{
+			cmd.begin_region("Game Rendering", glm::vec4(0.23f, 0.34f, 0.87f, 1.00f));
+
+			cmd.begin_region("Terrain", glm::vec4(0.31f, 0.68f, 0.29f, 1.00f));
+			terrain->on_inline_render(index, cmd);
+			cmd.end_region();
+
+			cmd.begin_region("Meshes", glm::vec4(0.82f, 0.64f, 0.25f, 1.00f));
+			mesh->on_inline_render(index, cmd);
+			cmd.end_region();
+
+			cmd.end_region();
+		}
+
+		{
+			cmd.begin_region("ImGui Rendering", glm::vec4(0.87f, 0.21f, 0.11f, 1.00f));
+			cmd.draw_imgui(*imgui, index, ImGui::GetDrawData());
+			cmd.end_region();
+		}
+
+		cmd.end_render_pass();
+	})
+		.set_color(glm::vec4(0.23f, 0.34f, 0.87f, 1.0f))
+		.read(shadow_map, ovk::util::access::fragment_sampled)
+		.attachment(backbuffer, attachments.color)
+		.attachment(depth_target, attachments.depth);
+
+	graph.compile();
+	graph.execute(cmd);
+
+	gpu_profiler->end_frame(cmd);
 }
 
 // =======================================================================================================================
@@ -772,13 +853,12 @@ void TerrainRenderer::create_const_objects() {
 		.build());
 
 	// Shadow Pipeline
-	shadow.pipeline = ovk::make_unique(
-		parent->device->build_pipeline()
+	shadow.pipeline = parent->device->build_pipeline()
 		.set_render_pass(*parent->shadow.renderpass, 0)
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/shadow.vert.spv")
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/shadow.frag.spv")
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/shadow.vert", true)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/shadow.frag", true)
 		.set_vertex_layout<TerrainVertex>()
-		.add_descriptor_set_layouts({ parent->shadow.descriptor_template->handle.get() })
+		.add_descriptor_templates({ parent->shadow.descriptor_template.get() })
 		.set_rasterizer(
 			vk::PipelineRasterizationStateCreateInfo(
 				{},
@@ -792,12 +872,12 @@ void TerrainRenderer::create_const_objects() {
 				1.0f)
 		)
 		.set_depth_stencil()
-		.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
+		// Push constant ranges come from the shaders, the descriptor template and vertex layout are validated against them
+		.use_reflection()
 		// TODO: Dynamic State (duh.)
 		.add_viewport(glm::vec2(0, 0), glm::vec2(shadow_extent.width, shadow_extent.height), 0.0f, 1.0f)
 		.add_scissor(vk::Offset2D(0, 0), shadow_extent)
-		.build()
-	);
+		.build_async();
 	
 }
 
@@ -805,13 +885,39 @@ void TerrainRenderer::create_dynamic_objects() {
 
 	auto& swapchain = parent->swapchain;
 	
-	dynamic.pipeline = ovk::make_unique(
-		parent->device->build_pipeline()
-		.set_render_pass(*parent->render_pass, 0)
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/terrain.vert.spv")
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/terrain.frag.spv")
+	// All pipelines are compiled on the worker pool of the device and resolved when the first command buffer is recorded
+	// Viewport and scissor are dynamic, so after a resize this returns the pipeline from the registry
+	dynamic.pipeline = create_pipeline();
+	
+	dynamic.descriptor_pool = ovk::make_unique(parent->device->create_descriptor_pool({ descriptor_template.get() }, { swapchain->image_count }));
+
+	dynamic.descriptor_sets = parent->device->make_descriptor_sets(*dynamic.descriptor_pool, swapchain->image_count, *descriptor_template);
+	
+	// All sets of all swapchain images in one vkUpdateDescriptorSets
+	ovk::DescriptorWriter writer;
+	for (auto i = 0; i < swapchain->image_count; i++) {
+		writer.write_buffer(dynamic.descriptor_sets[i], 0, parent->dynamic.camera_uniform_buffers[i])
+			.write_buffer(dynamic.descriptor_sets[i], 1, parent->dynamic.light_uniform_buffers[i])
+			.write_buffer(dynamic.descriptor_sets[i], 2, parent->shadow.light_buffer[i])
+			.write_image(
+				dynamic.descriptor_sets[i],
+				3,
+				parent->device->get_default_linear_sampler(),
+				parent->shadow.depth_views[i],
+				vk::ImageLayout::eShaderReadOnlyOptimal
+			);
+	}
+	writer.flush();
+
+	// Picker related stuff
+	dynamic.picker_pipeline = parent->device->build_pipeline()
+ 		.set_render_pass(*parent->picker.render_pass, 0)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/terrain_picker.vert", true)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/terrain_picker.frag", true)
+		.set_specialization(vk::ShaderStageFlagBits::eVertex, 0, max_chunks_1D)
+		.set_specialization(vk::ShaderStageFlagBits::eVertex, 1, static_cast<int32_t>(chunk_size))
 		.set_vertex_layout<TerrainVertex>()
-		.add_descriptor_set_layouts({ descriptor_template->handle.get() })
+		.add_descriptor_templates({ descriptor_template.get() })
 		.set_rasterizer(
 			vk::PipelineRasterizationStateCreateInfo(
 				{},
@@ -825,37 +931,26 @@ void TerrainRenderer::create_dynamic_objects() {
 				1.0f)
 		)
 		.set_depth_stencil()
-		.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::vec2))
-		// TODO: Dynamic State (duh.)
-		.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-		.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-		.build()
-	);
-	
-	dynamic.descriptor_pool = ovk::make_unique(parent->device->create_descriptor_pool({ descriptor_template.get() }, { swapchain->image_count }));
+		.use_reflection()
+		.set_dynamic_viewport_scissor()
+		.build_async();
+}
 
-	dynamic.descriptor_sets = parent->device->make_descriptor_sets(*dynamic.descriptor_pool, swapchain->image_count, *descriptor_template);
-	
-	for (auto i = 0; i < swapchain->image_count; i++) {
-		dynamic.descriptor_sets[i].write(parent->dynamic.camera_uniform_buffers[i], 0, 0);
-		dynamic.descriptor_sets[i].write(parent->dynamic.light_uniform_buffers[i], 0, 1);
-		dynamic.descriptor_sets[i].write(parent->shadow.light_buffer[i], 0, 2);
-		dynamic.descriptor_sets[i].write(
-			parent->device->get_default_linear_sampler(),
-			parent->shadow.depth_views[i],
-			vk::ImageLayout::eShaderReadOnlyOptimal,
-			3
-		);
-	}
+void TerrainRenderer::set_pcf_range(int range) {
+	if (range == pcf_range) return;
+	pcf_range = range;
+	// The old pipeline stays in the registry, so frames in flight can still use it (and switching back is free)
+	dynamic.pipeline = create_pipeline();
+}
 
-	// Picker related stuff
-	dynamic.picker_pipeline = ovk::make_unique(
-		parent->device->build_pipeline()
- 		.set_render_pass(*parent->picker.render_pass, 0)
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/terrain_picker.vert.spv")
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/terrain_picker.frag.spv")
+ovk::PipelineFuture TerrainRenderer::create_pipeline() {
+	return parent->device->build_pipeline()
+		.set_render_pass(*parent->render_pass, 0)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/terrain.vert", true)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/terrain.frag", true)
+		.set_specialization(vk::ShaderStageFlagBits::eFragment, 0, pcf_range)
 		.set_vertex_layout<TerrainVertex>()
-		.add_descriptor_set_layouts({ descriptor_template->handle.get() })
+		.add_descriptor_templates({ descriptor_template.get() })
 		.set_rasterizer(
 			vk::PipelineRasterizationStateCreateInfo(
 				{},
@@ -869,12 +964,9 @@ void TerrainRenderer::create_dynamic_objects() {
 				1.0f)
 		)
 		.set_depth_stencil()
-		.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::vec2))		
-		// TODO: Dynamic State (duh.)
-		.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-		.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-		.build()
-	);
+		.use_reflection()
+		.set_dynamic_viewport_scissor()
+		.build_async();
 }
 
 void TerrainRenderer::recreate_swapchain() {
@@ -949,9 +1041,11 @@ MeshRenderer::MeshRenderer(MasterRenderer *p) : parent(p) {
 
 void MeshRenderer::post_init(ovk::Buffer* mb) {
 	materials_buffer = mb;
+	ovk::DescriptorWriter writer;
 	for (auto i = 0; i < parent->swapchain->image_count; i++) {
-	 	dynamic.descriptor_sets[i].write(*materials_buffer, 0, 2, true);
+		writer.write_buffer(dynamic.descriptor_sets[i], 2, *materials_buffer, vk::DescriptorType::eStorageBuffer);
 	}
+	writer.flush();
 }
 
 void MeshRenderer::draw(Model *m, Transform transform) {
@@ -987,25 +1081,26 @@ void MeshRenderer::on_inline_render(int index, ovk::RenderCommand &cmd) {
 	
 	// Bind Pipeline
 	cmd.bind_graphics_pipeline(*dynamic.pipeline);
+	// All materials are in one storage buffer, so the set is bound once and every mesh only pushes its material index
+	cmd.bind_descriptor_sets(*dynamic.pipeline, 0, { dynamic.descriptor_sets[index] });
+
+	// Both stages share the push constant range (model matrix for the vertex, material index for the fragment shader)
+	const auto push_stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
 	// Terrain Rendering
 	// cmd.annotate("Render Meshes!", glm::vec4(0.75f, 0.17f, 0.57f, 1.00f));
 	for (auto& entity : render_jobs) {
 
-		// dynamic.descriptor_sets[index].write<Material>(model.mesh->material, 0, 2);
-
 		glm::mat4 model_matrix = glm::mat4(1.0f);
 		model_matrix = glm::translate(model_matrix, entity.transform.pos);
 		model_matrix = glm::rotate(model_matrix, glm::radians(entity.transform.rotation), glm::vec3(0.0f, 1.0f, 0.0f));
 		model_matrix = glm::scale(model_matrix, entity.transform.scale);
 
-		cmd.push_constant(model_matrix, *dynamic.pipeline, vk::ShaderStageFlagBits::eVertex, 0);
+		cmd.push_constant(model_matrix, *dynamic.pipeline, push_stages, 0);
 		// cmd.push_constant(model.transform.scale, *dynamic.pipeline, vk::ShaderStageFlagBits::eVertex, sizeof(glm::vec4));
 
 		for (auto& mesh : entity.model->meshes) {
 
-			// TODO: This will need to be a copy
-			// cmd.copy(*mesh->material, mesh->dynamic_offset, dynamic.material_buffers[index], 0, sizeof(Material));
-			cmd.bind_descriptor_sets(*dynamic.pipeline, 0, { dynamic.descriptor_sets[index] }, { mesh->dynamic_offset });
+			cmd.push_constant(mesh->material_index, *dynamic.pipeline, push_stages, sizeof(glm::mat4));
 			
 			cmd.bind_vertex_buffers( 0, { ovk::RenderCommand::BufferDescription{ std::ref(mesh->vertex), 0}});
 			// cmd.bind_index_buffer(mesh->index, 0, vk::IndexType::eUint16);
@@ -1025,16 +1120,15 @@ void MeshRenderer::create_const_objects() {
 	descriptor_template = ovk::make_unique(parent->device->build_descriptor_template()
 		.add_uniform_buffer(0, vk::ShaderStageFlagBits::eVertex)
 		.add_uniform_buffer(1, vk::ShaderStageFlagBits::eFragment)
-		.add_dynamic_uniform_buffer(2, vk::ShaderStageFlagBits::eFragment)
+		.add_storage_buffer(2, vk::ShaderStageFlagBits::eFragment)
 		.build());
 
-	shadow.pipeline = ovk::make_unique(
-		parent->device->build_pipeline()
+	shadow.pipeline = parent->device->build_pipeline()
 		.set_render_pass(*parent->shadow.renderpass, 0)
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/shadow.vert.spv")
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/shadow.frag.spv")
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/shadow.vert", true)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/shadow.frag", true)
 		.set_vertex_layout<MeshVertex>()
-		.add_descriptor_set_layouts({ parent->shadow.descriptor_template->handle.get() })
+		.add_descriptor_templates({ parent->shadow.descriptor_template.get() })
 		.set_rasterizer(
 			vk::PipelineRasterizationStateCreateInfo(
 				{},
@@ -1048,12 +1142,11 @@ void MeshRenderer::create_const_objects() {
 				1.0f)
 		)
 		.set_depth_stencil()
-		.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
+		.use_reflection()
 		// TODO: Dynamic State (duh.)
 		.add_viewport(glm::vec2(0, 0), glm::vec2(shadow_extent.width, shadow_extent.height), 0.0f, 1.0f)
 		.add_scissor(vk::Offset2D(0, 0), shadow_extent)
-		.build()
-	);
+		.build_async();
 
 }
 
@@ -1061,13 +1154,12 @@ void MeshRenderer::create_dynamic_objects() {
 
 	auto& swapchain = parent->swapchain;
 	
-	dynamic.pipeline = ovk::make_unique(
-		parent->device->build_pipeline()
+	dynamic.pipeline = parent->device->build_pipeline()
 		.set_render_pass(*parent->render_pass, 0)
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/mesh.vert.spv")
-		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/mesh.frag.spv")
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eVertex, "res/shader/mesh.vert", true)
+		.add_shader_stage_from_file(vk::ShaderStageFlagBits::eFragment, "res/shader/mesh.frag", true)
 		.set_vertex_layout<MeshVertex>()
-		.add_descriptor_set_layouts({ descriptor_template->handle.get() })
+		.add_descriptor_templates({ descriptor_template.get() })
 		.set_rasterizer(
 			vk::PipelineRasterizationStateCreateInfo(
 				{},
@@ -1081,12 +1173,9 @@ void MeshRenderer::create_dynamic_objects() {
 				1.0f)
 		)
 		.set_depth_stencil()
-		.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
-		// TODO: Dynamic State (duh.)
-		.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-		.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-		.build()
-	);
+		.use_reflection()
+		.set_dynamic_viewport_scissor()
+		.build_async();
 
 	// dynamic.material_buffers.clear();
 	// Material m;
@@ -1098,10 +1187,12 @@ void MeshRenderer::create_dynamic_objects() {
 
 	dynamic.descriptor_sets = parent->device->make_descriptor_sets(*dynamic.descriptor_pool, swapchain->image_count, *descriptor_template);
 	
+	ovk::DescriptorWriter writer;
 	for (auto i = 0; i < swapchain->image_count; i++) {
-		dynamic.descriptor_sets[i].write(parent->dynamic.camera_uniform_buffers[i], 0, 0);
-		dynamic.descriptor_sets[i].write(parent->dynamic.light_uniform_buffers[i], 0, 1);
-		if (materials_buffer) dynamic.descriptor_sets[i].write(*materials_buffer, 0, 2, true);
+		writer.write_buffer(dynamic.descriptor_sets[i], 0, parent->dynamic.camera_uniform_buffers[i])
+			.write_buffer(dynamic.descriptor_sets[i], 1, parent->dynamic.light_uniform_buffers[i]);
+		if (materials_buffer) writer.write_buffer(dynamic.descriptor_sets[i], 2, *materials_buffer, vk::DescriptorType::eStorageBuffer);
 	}
+	writer.flush();
 	
 }
@@ -1,6 +1,8 @@
 #pragma once
 #include "mesh.h"
 #include <base/device.h>
+#include <base/frame_pacer.h>
+#include <base/frame_scheduler.h>
 #include "app/camera.h"
 
 #include "ui/renderer.h"
@@ -99,6 +101,8 @@ private:
 
 	void create_const_objects();
 	void create_dynamic_objects();
+	// Attachments and framebuffers that depend on the swapchain extent, the only thing a resize rebuilds
+	void create_extent_objects();
 	void create_renderer();
 
 	void create_objects();
@@ -120,10 +124,19 @@ private:
 	// Const objects
 	uint32_t swapchain_index;
 	std::unique_ptr<ovk::RenderPass> render_pass;
+	std::unique_ptr<ovk::GpuProfiler> gpu_profiler;
+	// Descriptions of the render pass attachments, the render graph derives the layouts from them
 	struct {
-		std::vector<ovk::Semaphore> image_available, render_finished;
-		std::vector<ovk::Fence> in_flight_fences;
-		uint32_t current_frame = 0;
+		vk::AttachmentDescription color, depth, shadow_depth, picker_color;
+	} attachments;
+#ifdef DEBUG
+	std::unique_ptr<ovk::ShaderWatcher> shader_watcher;
+#endif
+	struct {
+		// Per frame resources are indexed with pacer->get_frame() and created ovk::FramePacer::max_frames_in_flight times
+		std::unique_ptr<ovk::FramePacer> pacer;
+		// Compute work of a frame goes here too, with a dependency from the graphics work that consumes it
+		std::unique_ptr<ovk::FrameScheduler> scheduler;
 	} sync;
 	struct {
 		std::vector<ovk::Image> depth_targets;
@@ -176,6 +189,9 @@ struct TerrainRenderer {
 	void create_dynamic_objects();
 	
 	void recreate_swapchain();
+
+	// Shadow quality, (2 * range + 1)^2 shadow map samples per fragment
+	void set_pcf_range(int range);
 	
 	void draw(Chunk* mesh);
 
@@ -193,16 +209,19 @@ struct TerrainRenderer {
 	std::vector<Chunk*> jobs;
 	std::unique_ptr<ovk::DescriptorTemplate> descriptor_template;
 
+	int pcf_range = 2;
+	ovk::PipelineFuture create_pipeline();
+
 	// Dynamic
 	struct {
-		std::unique_ptr<ovk::GraphicsPipeline> pipeline, picker_pipeline;
+		ovk::PipelineFuture pipeline, picker_pipeline;
 		std::unique_ptr<ovk::DescriptorPool> descriptor_pool;
 		std::vector<ovk::DescriptorSet> descriptor_sets;
 	} dynamic;
 
 	struct {
 
-		std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+		ovk::PipelineFuture pipeline;
 
 	} shadow;
 	
@@ -241,14 +260,14 @@ private:
 	ovk::Buffer* materials_buffer = nullptr;
 	
 	struct {
-		std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+		ovk::PipelineFuture pipeline;
 		std::unique_ptr<ovk::DescriptorPool> descriptor_pool;
 		std::vector<ovk::DescriptorSet> descriptor_sets;
 		// std::vector<ovk::Buffer> material_buffers;
 	} dynamic;
 
 	struct {
-		std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+		ovk::PipelineFuture pipeline;
 	} shadow;
 
 };
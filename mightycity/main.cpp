@@ -5,6 +5,7 @@
 #include <gui/gui_renderer.h>
 #include "game.h"
 #include "graphics/renderer.h"
+#include <util/profiler.h>
 #include <filesystem>
 
 
@@ -51,22 +52,52 @@ struct Application {
 
 
 
+// Startup time is logged, so runs with a cold and a warm pipeline cache can be compared
+static const auto startup_begin = std::chrono::high_resolution_clock::now();
+
+std::shared_ptr<ovk::Device> create_device(ovk::Instance& instance, ovk::Surface& surface) {
+	// Per pass shader invocation and sample counts in the GPU profiler. Both are optional and a requested feature rules
+	// out every device without it, so they are only requested if all devices have them (GpuProfiler checks what the
+	// device was created with and only measures time otherwise)
+	bool statistics = true, occlusion = true;
+	for (const auto& physical_device : instance.get_physical_devices()) {
+		const auto supported = physical_device.getFeatures();
+		statistics = statistics && supported.pipelineStatisticsQuery;
+		occlusion = occlusion && supported.occlusionQueryPrecise;
+	}
+	if (!statistics)
+		spdlog::info("pipelineStatisticsQuery is not supported, the GPU profiler only measures time");
+
+	auto device = ovk::make_shared(instance.create_device(
+		{ VK_KHR_SWAPCHAIN_EXTENSION_NAME },
+		vk::PhysicalDeviceFeatures()
+			.setFillModeNonSolid(true)
+			.setSamplerAnisotropy(true)
+			.setPipelineStatisticsQuery(statistics)
+			.setOcclusionQueryPrecise(occlusion),
+		surface));
+	// Must happen before the renderer builds its pipelines
+	device->load_pipeline_cache();
+	return device;
+}
+
 Application::Application()
 	: instance(ovk::AppInfo{ "MightCity", 0, 0, 1 }, {}),
 		surface(ovk::make_shared(instance.create_surface(2600, 1600, "Mighty City", true))),
-		device(ovk::make_shared(instance.create_device(
-			{ VK_KHR_SWAPCHAIN_EXTENSION_NAME}, 
-			vk::PhysicalDeviceFeatures().setFillModeNonSolid(true).setSamplerAnisotropy(true),
-			*surface))),
+		device(create_device(instance, *surface)),
 		swapchain(ovk::make_shared(device->create_swapchain(*surface))),
 		renderer(std::make_shared<MasterRenderer>(device, swapchain, surface)) {	
 
 	game = std::make_unique<Game>(device, swapchain, renderer);
-	
+
+	const auto startup_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startup_begin).count();
+	spdlog::info("startup took {:.1f} ms", startup_ms);
 }
 
 void Application::run() {
+	ovk::util::profiler::set_thread_name("Main Thread");
 	while(surface->update()) {
+		OVK_PROFILE_FRAME();
 
 		// Figure out delta time
 		static int fps = 0;
@@ -104,6 +135,7 @@ void Application::run() {
 
 		ImGui::Begin("Stats");
 		ImGui::Text("fps: %i", fps);
+		if (ImGui::Button("Export CPU Trace")) ovk::util::profiler::export_chrome_trace("cpu_trace.json");
 		ImGui::End();
 		
 		game->render();
@@ -111,6 +143,7 @@ void Application::run() {
 	}
 
 	device->wait_idle();
+	device->save_pipeline_cache();
 }
 
 //void Application::run() {
@@ -9,18 +9,28 @@
 	vec3 view_pos;
  } light;
 
- layout (binding = 2) uniform Material {
+ struct Material {
 	vec3 ambient;
 	vec3 diffuse;
 	vec3 specular;
 	float shininess;
- } material;
+ };
+
+ layout (std430, binding = 2) readonly buffer Materials {
+	Material materials[];
+ };
+
+ layout (push_constant) uniform PushConstant {
+	layout (offset = 64) uint material_index;
+ } pc;
 
  layout (location = 0) out vec4 color;
 
  const vec3 light_color = vec3(1.0f, 1.0f, 1.0f);
 
  void main() {
+	Material material = materials[pc.material_index];
+
 	// vec3 sampled_color =  vec3(155.f / 255.f, 116.f / 255.f, 82.f / 255.f);
 
 	// vec4 sampled_color = texture(tex_sampler, pass_tex);
@@ -18,6 +18,9 @@ layout (binding = 3) uniform sampler2D shadow_depth;
 
 layout (location = 0) out vec4 color;
 
+// PCF kernel is (2 * pcf_range + 1)^2 samples, set by the renderer (shadow quality)
+layout (constant_id = 0) const int pcf_range = 2;
+
 const vec3 light_color = vec3(1.0f, 1.0f, 1.0f);
 
 #define ambient_strength 0.15f
@@ -46,10 +49,9 @@ float calculate_shadow(vec4 shadow_coord, float bias) {
 
 	float shadow_factor = 0.0f;
 	int count = 0;
-	int range = 2;
 
-	for (int x = -range; x <= range; x++) {
-		for (int y = -range; y <= range; y++) {
+	for (int x = -pcf_range; x <= pcf_range; x++) {
+		for (int y = -pcf_range; y <= pcf_range; y++) {
 			shadow_factor += sample_shadow(shadow_coord, vec2(dx * x, dy * y), bias);
 			count++;
 		}
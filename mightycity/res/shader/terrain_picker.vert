@@ -17,10 +17,9 @@ layout (push_constant) uniform PushConstant {
 
 layout (location = 0) out vec3 encoded_color;
 
-// TODO: Should be uniform
-// NOTE: Totally random limit in one direction
-const int max_chunks_1D = 32;
-const int chunk_size = 8;
+// Set by the renderer, which decodes the color again
+layout (constant_id = 0) const int max_chunks_1D = 32;
+layout (constant_id = 1) const int chunk_size = 8;
 const int num_of_triangles = chunk_size * chunk_size * 2;
 
 ////layout (location = 0) out vec2 pass_tex;
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "bindless.h"
+
+#include "device.h"
+
+#include <algorithm>
+
+namespace ovk {
+
+	BindlessTextures::BindlessTextures(Device &device, uint32_t requested_capacity, vk::ShaderStageFlags stages) {
+		ovk_asserts(device.has_bindless(), "[BindlessTextures] device was created without descriptor indexing");
+
+		const auto chain = device.physical_device.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+		const auto& limits = chain.get<vk::PhysicalDeviceDescriptorIndexingPropertiesEXT>();
+		capacity = std::min({
+			requested_capacity,
+			limits.maxDescriptorSetUpdateAfterBindSampledImages,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			limits.maxPerStageDescriptorUpdateAfterBindSamplers
+		});
+		if (capacity < requested_capacity)
+			spdlog::warn("[BindlessTextures] capacity clamped to {} (requested {})", capacity, requested_capacity);
+
+		descriptor_template = ovk::make_unique(device.build_descriptor_template()
+			.add_bindless_array(binding, vk::DescriptorType::eCombinedImageSampler, stages, capacity)
+			.build());
+
+		pool = ovk::make_unique(device.create_descriptor_pool({ descriptor_template.get() }, { 1 }));
+		set = ovk::make_unique(std::move(device.make_descriptor_sets(*pool, 1, *descriptor_template).front()));
+	}
+
+	std::optional<uint32_t> BindlessTextures::add(vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout) {
+		uint32_t index;
+		if (!free_slots.empty()) {
+			index = free_slots.back();
+			free_slots.pop_back();
+		} else if (next < capacity) {
+			index = next++;
+		} else {
+			spdlog::error("[BindlessTextures] (add) all {} slots are taken", capacity);
+			return std::nullopt;
+		}
+
+		const vk::DescriptorImageInfo image_info{ sampler, view, layout };
+		const vk::WriteDescriptorSet write_descriptor{
+			set->set,
+			binding,
+			index,
+			1,
+			vk::DescriptorType::eCombinedImageSampler,
+			&image_info
+		};
+		set->device.updateDescriptorSets({ write_descriptor }, {});
+
+		return index;
+	}
+
+	void BindlessTextures::remove(uint32_t index) {
+		ovk_asserts(index < next, "[BindlessTextures] (remove) index {} was never handed out", index);
+		// The old descriptor stays in the slot, the array is partially bound so it is never read again
+		free_slots.push_back(index);
+	}
+
+	const DescriptorTemplate &BindlessTextures::get_template() const { return *descriptor_template; }
+
+	const DescriptorSet &BindlessTextures::get_set() const { return *set; }
+
+	uint32_t BindlessTextures::get_capacity() const { return capacity; }
+
+	uint32_t BindlessTextures::size() const { return next - static_cast<uint32_t>(free_slots.size()); }
+
+}
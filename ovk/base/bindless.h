@@ -0,0 +1,52 @@
+#pragma once
+
+#include "handle.h"
+
+#include "descriptor.h"
+
+namespace ovk {
+	class Device;
+
+	/**
+	 * \brief One global descriptor set with a partially bound array of combined image samplers (VK_EXT_descriptor_indexing)
+	 *				Textures are added once and referenced by their index (eg. through a push constant), so a renderer binds this
+	 *				set once per frame instead of a set per texture. Slots are written with update after bind, adding a
+	 *				texture while frames in flight use the set is fine as long as they do not read that slot.
+	 *				Only available if Device::has_bindless
+	 */
+	class OVK_API BindlessTextures {
+	public:
+		// In GLSL: layout (set = N, binding = 0) uniform sampler2D textures[];
+		static constexpr uint32_t binding = 0;
+
+		// capacity is clamped to the update after bind limits of the device
+		explicit BindlessTextures(Device& device, uint32_t capacity = 4096, vk::ShaderStageFlags stages = vk::ShaderStageFlagBits::eFragment);
+
+		BindlessTextures(const BindlessTextures& other) = delete;
+		BindlessTextures& operator=(const BindlessTextures& other) = delete;
+
+		// Returns the index of the texture in the array, std::nullopt if all slots are taken
+		std::optional<uint32_t> add(vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout);
+
+		// The slot is handed out again by the next add, so no frame in flight may still read it
+		void remove(uint32_t index);
+
+		[[nodiscard]] const DescriptorTemplate& get_template() const;
+		[[nodiscard]] const DescriptorSet& get_set() const;
+
+		[[nodiscard]] uint32_t get_capacity() const;
+		// Number of textures currently in the table
+		[[nodiscard]] uint32_t size() const;
+
+	private:
+		std::unique_ptr<DescriptorTemplate> descriptor_template;
+		std::unique_ptr<DescriptorPool> pool;
+		std::unique_ptr<DescriptorSet> set;
+
+		uint32_t capacity;
+		// Slots below next were handed out at least once
+		uint32_t next = 0;
+		std::vector<uint32_t> free_slots;
+	};
+
+}
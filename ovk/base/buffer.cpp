@@ -2,6 +2,9 @@
 #include "buffer.h"
 
 #include "device.h"
+#include "util/profiler.h"
+
+#include <algorithm>
 
 namespace ovk {
 
@@ -18,15 +21,19 @@ namespace ovk {
 			size(size), memory_type(mem_type) {
 		{
 			// Create Buffer Handle
-			std::vector<uint32_t> q(types.size());
-			for (auto i = 0; i < types.size(); i++) {
-				q[i] = device.families.get_family(types[i]);
-			}
+			// Queue types can share a family (eg. async_compute without a dedicated family), concurrent sharing needs unique families
+			std::vector<uint32_t> q;
+			const auto add_family = [&](QueueType type) {
+				const auto family = device.families.get_family(type);
+				if (std::find(q.begin(), q.end(), family) == q.end())
+					q.push_back(family);
+			};
+			for (const auto type : types)
+				add_family(type);
 
 			if (mem_type == mem::MemoryType::device_local) {
 				usage |= vk::BufferUsageFlagBits::eTransferDst;
-				if (const auto transfer_family = device.families.get_family(QueueType::transfer); transfer_family != q[0])
-					q.push_back(transfer_family);
+				add_family(QueueType::transfer);
 			}
 
 			vk::BufferCreateInfo create_info{
@@ -60,6 +67,7 @@ namespace ovk {
 	}
 
 	void Buffer::upload(vk::DeviceSize size, void *data, Device& device) {
+		OVK_PROFILE_SCOPE("Buffer::upload");
 
 		using mem_prop = vk::MemoryPropertyFlagBits;
 
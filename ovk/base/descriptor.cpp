@@ -3,6 +3,9 @@
 
 #include "device.h"
 
+#include <algorithm>
+#include <utility>
+
 namespace ovk {
 
 
@@ -24,10 +27,42 @@ namespace ovk {
 		return *this;
 	}
 
+	DescriptorTemplateBuilder & DescriptorTemplateBuilder::add_storage_buffer(uint32_t binding, vk::ShaderStageFlags stage) {
+		infos.push_back(descriptor::Info{ binding, vk::DescriptorType::eStorageBuffer, stage });
+		return *this;
+	}
+
+	DescriptorTemplateBuilder & DescriptorTemplateBuilder::add_storage_image(uint32_t binding, vk::ShaderStageFlags stage) {
+		infos.push_back(descriptor::Info{ binding, vk::DescriptorType::eStorageImage, stage });
+		return *this;
+	}
+
+	DescriptorTemplateBuilder & DescriptorTemplateBuilder::add_input_attachment(uint32_t binding) {
+		infos.push_back(descriptor::Info{ binding, vk::DescriptorType::eInputAttachment, vk::ShaderStageFlagBits::eFragment });
+		return *this;
+	}
+
+	DescriptorTemplateBuilder & DescriptorTemplateBuilder::add_binding(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stage, uint32_t count) {
+		infos.push_back(descriptor::Info{ binding, type, stage, count });
+		return *this;
+	}
+
+	DescriptorTemplateBuilder & DescriptorTemplateBuilder::add_bindless_array(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stage, uint32_t count) {
+		infos.push_back(descriptor::Info{
+			binding, type, stage, count,
+			vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending
+		});
+		return *this;
+	}
+
 	DescriptorTemplate DescriptorTemplateBuilder::build() {
 
 		std::vector<vk::DescriptorSetLayoutBinding> layout_bindings;
-		for (auto& info : infos) layout_bindings.emplace_back(info.binding, info.type, 1, info.stage, nullptr);
+		std::vector<vk::DescriptorBindingFlags> binding_flags;
+		for (auto& info : infos) {
+			layout_bindings.emplace_back(info.binding, info.type, info.count, info.stage, nullptr);
+			binding_flags.push_back(info.flags);
+		}
 
 		vk::DescriptorSetLayoutCreateInfo create_info{
 			{},
@@ -35,6 +70,14 @@ namespace ovk {
 			layout_bindings.data()
 		};
 
+		// Only chained for bindless templates, so everything else works without VK_EXT_descriptor_indexing
+		const vk::DescriptorSetLayoutBindingFlagsCreateInfo flags_info{ static_cast<uint32_t>(binding_flags.size()), binding_flags.data() };
+		if (std::any_of(infos.begin(), infos.end(), [](auto& info) { return static_cast<bool>(info.flags); })) {
+			create_info.pNext = &flags_info;
+			if (std::any_of(infos.begin(), infos.end(), [](auto& info) { return static_cast<bool>(info.flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind); }))
+				create_info.flags |= vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+		}
+
 		auto raw_handle = VK_CREATE(device.createDescriptorSetLayout(create_info), "Failed to create Descriptor Set Layout");
 
 		return DescriptorTemplate(raw_handle, infos, device);
@@ -47,6 +90,43 @@ namespace ovk {
 		: DeviceObject<vk::DescriptorSetLayout>(device, raw),
 			infos(infos) {}
 
+	descriptor::Data descriptor::Data::from_buffer(Buffer &buffer, vk::DeviceSize offset, vk::DeviceSize range) {
+		Data data{};
+		data.buffer = VkDescriptorBufferInfo{ static_cast<VkBuffer>(buffer.handle.get()), offset, range };
+		return data;
+	}
+
+	descriptor::Data descriptor::Data::from_image(vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout) {
+		Data data{};
+		data.image = VkDescriptorImageInfo{ static_cast<VkSampler>(sampler), static_cast<VkImageView>(view), static_cast<VkImageLayout>(layout) };
+		return data;
+	}
+
+	DescriptorUpdateTemplate::DescriptorUpdateTemplate(const DescriptorTemplate &descriptor_template, vk::Device device)
+		: DeviceObject<vk::DescriptorUpdateTemplate>(device) {
+
+		std::vector<vk::DescriptorUpdateTemplateEntry> entries;
+		entries.reserve(descriptor_template.infos.size());
+		for (auto& info : descriptor_template.infos) {
+			entries.emplace_back(info.binding, 0, info.count, info.type, descriptor_count * sizeof(descriptor::Data), sizeof(descriptor::Data));
+			descriptor_count += info.count;
+		}
+
+		const vk::DescriptorUpdateTemplateCreateInfo create_info{
+			{},
+			static_cast<uint32_t>(entries.size()),
+			entries.data(),
+			vk::DescriptorUpdateTemplateType::eDescriptorSet,
+			descriptor_template.handle.get()
+		};
+
+		handle.set(VK_CREATE(device.createDescriptorUpdateTemplate(create_info), "[DescriptorUpdateTemplate] Failed to create update template"));
+	}
+
+	bool DescriptorTemplate::update_after_bind() const {
+		return std::any_of(infos.begin(), infos.end(), [](auto& info) { return static_cast<bool>(info.flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind); });
+	}
+
 	DescriptorPool::DescriptorPool(vk::DescriptorPool raw, vk::Device device) : DeviceObject<vk::DescriptorPool>(device, raw) {}
 
 	DescriptorSet::DescriptorSet(vk::DescriptorSet raw, vk::Device device) : set(raw), device(device) {}
@@ -88,8 +168,167 @@ namespace ovk {
 		device.updateDescriptorSets({ write_descriptor }, {});
 	}
 
+	void DescriptorSet::write_storage_buffer(Buffer &buffer, uint32_t binding, vk::DeviceSize offset, vk::DeviceSize range) const {
+		vk::DescriptorBufferInfo buffer_info{ buffer.handle.get(), offset, range };
+
+		const vk::WriteDescriptorSet write_descriptor{
+			set,
+			binding,
+			0,
+			1,
+			vk::DescriptorType::eStorageBuffer,
+			nullptr,
+			&buffer_info
+		};
+
+		device.updateDescriptorSets({ write_descriptor }, {});
+	}
+
+	void DescriptorSet::write_storage_image(vk::ImageView view, uint32_t binding, vk::ImageLayout layout) const {
+		vk::DescriptorImageInfo image_info{ vk::Sampler(), view, layout };
+
+		const vk::WriteDescriptorSet write_descriptor{
+			set,
+			binding,
+			0,
+			1,
+			vk::DescriptorType::eStorageImage,
+			&image_info,
+		};
+
+		device.updateDescriptorSets({ write_descriptor }, {});
+	}
+
+	void DescriptorSet::update(const DescriptorUpdateTemplate &update_template, const std::vector<descriptor::Data> &data) const {
+		ovk_asserts(data.size() == update_template.descriptor_count, "[DescriptorSet] (update) expected {} descriptors, got {}", update_template.descriptor_count, data.size());
+		device.updateDescriptorSetWithTemplate(set, update_template.handle.get(), data.data());
+	}
+
 	DescriptorSet::operator vk::DescriptorSet() const { return set; }
 
+	DescriptorWriter &DescriptorWriter::write_buffer(const DescriptorSet &set, uint32_t binding, Buffer &buffer, vk::DescriptorType type, vk::DeviceSize offset, vk::DeviceSize range) {
+		device = set.device;
+		buffer_infos.emplace_back(buffer.handle.get(), offset, range);
+		writes.emplace_back(set.set, binding, 0, 1, type);
+		return *this;
+	}
+
+	DescriptorWriter &DescriptorWriter::write_image(const DescriptorSet &set, uint32_t binding, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout, vk::DescriptorType type) {
+		device = set.device;
+		image_infos.emplace_back(sampler, view, layout);
+		// pImageInfo only marks the kind of the write until flush
+		writes.emplace_back(set.set, binding, 0, 1, type).pImageInfo = image_infos.data();
+		return *this;
+	}
+
+	void DescriptorWriter::flush() {
+		if (writes.empty()) return;
+
+		size_t next_buffer = 0, next_image = 0;
+		for (auto& write : writes) {
+			if (write.pImageInfo) write.pImageInfo = &image_infos[next_image++];
+			else write.pBufferInfo = &buffer_infos[next_buffer++];
+		}
+
+		device.updateDescriptorSets(writes, {});
+
+		writes.clear();
+		buffer_infos.clear();
+		image_infos.clear();
+	}
+
+	size_t DescriptorWriter::pending() const { return writes.size(); }
+
+	DescriptorAllocator::DescriptorAllocator(Device &d, uint32_t frame_count, uint32_t sets_per_pool)
+		: device(d.device.get()), next_pool_sets(std::max(sets_per_pool, 1u)), frames(std::max(frame_count, 1u)) {}
+
+	DescriptorSet DescriptorAllocator::allocate(const DescriptorTemplate &descriptor_template) {
+		if (auto it = recycled.find(descriptor_template.handle.get()); it != recycled.end() && !it->second.empty()) {
+			const auto raw = it->second.back();
+			it->second.pop_back();
+			return DescriptorSet(raw, device);
+		}
+
+		persistent_sets++;
+		return allocate_from(persistent, descriptor_template);
+	}
+
+	std::vector<DescriptorSet> DescriptorAllocator::allocate(const DescriptorTemplate &descriptor_template, uint32_t count) {
+		std::vector<DescriptorSet> sets;
+		sets.reserve(count);
+		for (uint32_t i = 0; i < count; i++) sets.push_back(allocate(descriptor_template));
+		return sets;
+	}
+
+	void DescriptorAllocator::free(const DescriptorTemplate &descriptor_template, DescriptorSet &&set) {
+		if (!set.set) return;
+		recycled[descriptor_template.handle.get()].push_back(std::exchange(set.set, vk::DescriptorSet()));
+	}
+
+	DescriptorSet DescriptorAllocator::allocate_transient(const DescriptorTemplate &descriptor_template) {
+		return allocate_from(frames[current_frame], descriptor_template);
+	}
+
+	void DescriptorAllocator::begin_frame(uint32_t frame) {
+		ovk_asserts(frame < frames.size(), "[DescriptorAllocator] (begin_frame) frame {} out of range, allocator has {} frames", frame, frames.size());
+		current_frame = frame;
+
+		auto& chain = frames[frame];
+		for (auto& pool : chain.pools)
+			VK_ASSERT(device.resetDescriptorPool(pool.get()), "[DescriptorAllocator] (begin_frame) Failed to reset Descriptor Pool");
+		chain.current = 0;
+	}
+
+	size_t DescriptorAllocator::pool_count() const {
+		size_t count = persistent.pools.size();
+		for (auto& chain : frames) count += chain.pools.size();
+		return count;
+	}
+
+	size_t DescriptorAllocator::persistent_set_count() const { return persistent_sets; }
+
+	DescriptorSet DescriptorAllocator::allocate_from(PoolChain &chain, const DescriptorTemplate &descriptor_template) {
+		ovk_asserts(!descriptor_template.update_after_bind(), "[DescriptorAllocator] (allocate) bindless templates need a pool from Device::create_descriptor_pool");
+
+		std::map<vk::DescriptorType, uint32_t> counts;
+		for (auto& info : descriptor_template.infos) counts[info.type] += info.count;
+		for (auto& [type, count] : counts) descriptors_per_set[type] = std::max(descriptors_per_set[type], count);
+
+		const auto layout = descriptor_template.handle.get();
+		while (true) {
+			const bool fresh = chain.current == chain.pools.size();
+			if (fresh) chain.pools.push_back(create_pool());
+
+			const vk::DescriptorSetAllocateInfo alloc_info{ chain.pools[chain.current].get(), 1, &layout };
+			vk::DescriptorSet raw;
+			const auto result = device.allocateDescriptorSets(&alloc_info, &raw);
+			if (result == vk::Result::eSuccess) return DescriptorSet(raw, device);
+
+			// A new pool is sized for the template, so it can only fail for other reasons
+			if (fresh || (result != vk::Result::eErrorOutOfPoolMemory && result != vk::Result::eErrorFragmentedPool)) {
+				panic("[DescriptorAllocator] (allocate) Failed to allocate Descriptor Set: {}", vk::to_string(result));
+				return DescriptorSet(vk::DescriptorSet(), device);
+			}
+
+			chain.current++;
+		}
+	}
+
+	UniqueHandle<vk::DescriptorPool> DescriptorAllocator::create_pool() {
+		constexpr uint32_t max_pool_sets = 4096;
+
+		const auto sets = next_pool_sets;
+		next_pool_sets = std::min(next_pool_sets * 2, max_pool_sets);
+
+		std::vector<vk::DescriptorPoolSize> sizes;
+		for (auto& [type, count] : descriptors_per_set) sizes.emplace_back(type, count * sets);
+
+		const vk::DescriptorPoolCreateInfo create_info{ {}, sets, static_cast<uint32_t>(sizes.size()), sizes.data() };
+		auto raw = VK_CREATE(device.createDescriptorPool(create_info), "[DescriptorAllocator] (create_pool) Failed to create Descriptor Pool");
+
+		return UniqueHandle(std::move(raw), ObjectDestroy<vk::DescriptorPool>(device));
+	}
+
 
 
 }
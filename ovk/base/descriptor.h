@@ -4,6 +4,8 @@
 
 #include "buffer.h"
 
+#include <map>
+
 namespace ovk {
 	class Buffer;
 
@@ -15,6 +17,18 @@ namespace ovk {
 			uint32_t binding;
 			vk::DescriptorType type;
 			vk::ShaderStageFlags stage;
+			uint32_t count = 1;
+			vk::DescriptorBindingFlags flags = {};
+		};
+
+		// One descriptor of the data passed to DescriptorSet::update, the member that is read depends on the descriptor type
+		union OVK_API Data {
+			VkDescriptorBufferInfo buffer;
+			VkDescriptorImageInfo image;
+			VkBufferView texel_buffer;
+
+			static Data from_buffer(Buffer& buffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+			static Data from_image(vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout);
 		};
 	}
 
@@ -25,6 +39,19 @@ namespace ovk {
 		DescriptorTemplateBuilder& add_dynamic_uniform_buffer(uint32_t binding, vk::ShaderStageFlags stage);
 		
 		DescriptorTemplateBuilder& add_sampler(uint32_t binding, vk::ShaderStageFlags stage);
+
+		DescriptorTemplateBuilder& add_storage_buffer(uint32_t binding, vk::ShaderStageFlags stage);
+		
+		DescriptorTemplateBuilder& add_storage_image(uint32_t binding, vk::ShaderStageFlags stage);
+
+		// Attachment of an earlier subpass (subpassInput in GLSL), only fragment shaders can read them
+		DescriptorTemplateBuilder& add_input_attachment(uint32_t binding);
+
+		DescriptorTemplateBuilder& add_binding(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stage, uint32_t count = 1);
+
+		// Partially bound array that can be updated after the set is bound (needs Device::has_bindless),
+		// count is the upper bound. Sets of such a template need a pool from Device::create_descriptor_pool
+		DescriptorTemplateBuilder& add_bindless_array(uint32_t binding, vk::DescriptorType type, vk::ShaderStageFlags stage, uint32_t count);
 		
 		DescriptorTemplate build();
 		
@@ -43,10 +70,25 @@ namespace ovk {
 		DescriptorTemplate(vk::DescriptorSetLayout raw, std::vector<descriptor::Info>& infos, vk::Device device);
 
 	public:
+		[[nodiscard]] bool update_after_bind() const;
+
 		std::vector<descriptor::Info> infos;
 		
 	};
 
+	/**
+	 * \brief Update template for every binding of a DescriptorTemplate (vkUpdateDescriptorSetWithTemplate)
+	 *				The driver knows the layout of the data up front, so rewriting a whole set is a single call without
+	 *				building VkWriteDescriptorSets. The data is one descriptor::Data per descriptor, in the order of
+	 *				DescriptorTemplate::infos (arrays take count consecutive elements)
+	 */
+	class OVK_API DescriptorUpdateTemplate : public DeviceObject<vk::DescriptorUpdateTemplate> {
+		friend Device;
+		DescriptorUpdateTemplate(const DescriptorTemplate& descriptor_template, vk::Device device);
+	public:
+		uint32_t descriptor_count = 0;
+	};
+
 	class OVK_API DescriptorPool : public DeviceObject<vk::DescriptorPool> {
 		friend Device;
 		DescriptorPool(vk::DescriptorPool raw, vk::Device device);
@@ -54,12 +96,21 @@ namespace ovk {
 
 	class OVK_API DescriptorSet {
 		friend Device;
+		friend class DescriptorAllocator;
 		DescriptorSet(vk::DescriptorSet raw, vk::Device device);
 	public:
 
 		void write(Buffer& buffer, uint32_t offset, uint32_t binding, bool dynamic = false) const;
 
 		void write(vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout, uint32_t binding);
+
+		void write_storage_buffer(Buffer& buffer, uint32_t binding, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE) const;
+
+		// Storage images are accessed in the general layout
+		void write_storage_image(vk::ImageView view, uint32_t binding, vk::ImageLayout layout = vk::ImageLayout::eGeneral) const;
+
+		// Rewrites all bindings at once, data.size() has to match update_template.descriptor_count
+		void update(const DescriptorUpdateTemplate& update_template, const std::vector<descriptor::Data>& data) const;
 		
 		OVK_CONVERSION operator vk::DescriptorSet() const;
 
@@ -67,4 +118,89 @@ namespace ovk {
 		vk::Device device;
 	};
 
+	/**
+	 * \brief Collects descriptor writes (for any number of sets) and submits them with a single vkUpdateDescriptorSets
+	 *				Nothing is written before flush, so the sets must not be in use by then (same as DescriptorSet::write)
+	 */
+	class OVK_API DescriptorWriter {
+	public:
+		DescriptorWriter& write_buffer(const DescriptorSet& set, uint32_t binding, Buffer& buffer,
+			vk::DescriptorType type = vk::DescriptorType::eUniformBuffer, vk::DeviceSize offset = 0, vk::DeviceSize range = VK_WHOLE_SIZE);
+
+		DescriptorWriter& write_image(const DescriptorSet& set, uint32_t binding, vk::Sampler sampler, vk::ImageView view, vk::ImageLayout layout,
+			vk::DescriptorType type = vk::DescriptorType::eCombinedImageSampler);
+
+		// Submits all pending writes, the writer can be reused afterwards
+		void flush();
+
+		[[nodiscard]] size_t pending() const;
+
+	private:
+		vk::Device device;
+		std::vector<vk::WriteDescriptorSet> writes;
+		// The infos are only linked to the writes in flush, growing the vectors would invalidate the pointers
+		std::vector<vk::DescriptorBufferInfo> buffer_infos;
+		std::vector<vk::DescriptorImageInfo> image_infos;
+	};
+
+	/**
+	 * \brief Allocates descriptor sets for any template from a chain of pools, a new pool is added when one is exhausted
+	 *				The pools reserve room for every descriptor type (and array count) of the templates seen so far and
+	 *				grow with every pool that is added.
+	 *				Sets from allocate live until they are handed back with free (or as long as the allocator), sets from
+	 *				allocate_transient only until the same frame begins again (begin_frame resets all pools of the frame at once)
+	 */
+	class OVK_API DescriptorAllocator {
+	public:
+		// frame_count: frames that can use transient sets at the same time (usually the frames in flight)
+		// sets_per_pool: sets of the first pool
+		explicit DescriptorAllocator(Device& device, uint32_t frame_count = 1, uint32_t sets_per_pool = 32);
+
+		DescriptorAllocator(const DescriptorAllocator& other) = delete;
+		DescriptorAllocator& operator=(const DescriptorAllocator& other) = delete;
+
+		DescriptorSet allocate(const DescriptorTemplate& descriptor_template);
+		std::vector<DescriptorSet> allocate(const DescriptorTemplate& descriptor_template, uint32_t count);
+
+		// Hands a set from allocate back, the next allocate of the same template reuses it instead of taking room in the
+		// pools (which have no eFreeDescriptorSet). The set must no longer be used by a command buffer in flight, and the
+		// template must outlive the allocator since freed sets are kept by its layout handle
+		void free(const DescriptorTemplate& descriptor_template, DescriptorSet&& set);
+
+		// Valid until begin_frame is called with the current frame again
+		DescriptorSet allocate_transient(const DescriptorTemplate& descriptor_template);
+
+		// Call once the command buffers of this frame are no longer in flight (eg. after waiting on its fence),
+		// frees all transient sets of the frame
+		void begin_frame(uint32_t frame);
+
+		[[nodiscard]] size_t pool_count() const;
+		// Sets allocate took from the pools (not reused from free), for leak checks and benchmarks
+		[[nodiscard]] size_t persistent_set_count() const;
+
+	private:
+		struct PoolChain {
+			std::vector<UniqueHandle<vk::DescriptorPool>> pools;
+			// Pools before current are exhausted
+			size_t current = 0;
+		};
+
+		DescriptorSet allocate_from(PoolChain& chain, const DescriptorTemplate& descriptor_template);
+		UniqueHandle<vk::DescriptorPool> create_pool();
+
+		vk::Device device;
+
+		// Most descriptors of each type a single template needs
+		std::map<vk::DescriptorType, uint32_t> descriptors_per_set;
+		uint32_t next_pool_sets;
+
+		PoolChain persistent;
+		size_t persistent_sets = 0;
+		// Freed sets by layout, the pools can not take them back
+		std::map<vk::DescriptorSetLayout, std::vector<vk::DescriptorSet>> recycled;
+
+		std::vector<PoolChain> frames;
+		uint32_t current_frame = 0;
+	};
+
 }
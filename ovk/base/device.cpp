@@ -8,7 +8,11 @@
 
 #include "instance.h"
 #include "swapchain.h"
+#include "util/profiler.h"
 #include "vulkan/vulkan_core.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <numeric>
 
 namespace ovk {
@@ -36,6 +40,8 @@ bool QueueFamilies::is_complete() const {
 QueueFamilies QueueFamilies::find(vk::PhysicalDevice ph,
                                   vk::SurfaceKHR surface) {
   QueueFamilies families;
+  // A compute family without graphics runs in parallel to rendering
+  auto dedicated_compute = false;
 
   auto available_families = ph.getQueueFamilyProperties();
   auto i = 0;
@@ -43,19 +49,28 @@ QueueFamilies QueueFamilies::find(vk::PhysicalDevice ph,
 
     if (available.queueCount > 0) {
 
-      const auto present_support = VK_DCREATE(
-          ph.getSurfaceSupportKHR(i, surface), "failed to get surface support");
+      // Without a surface nothing is presented, the graphics family stands in
+      const auto present_support =
+          surface ? VK_DCREATE(ph.getSurfaceSupportKHR(i, surface),
+                               "failed to get surface support")
+                  : static_cast<vk::Bool32>(
+                        available.queueFlags & vk::QueueFlagBits::eGraphics);
 
-      if (available.queueFlags & vk::QueueFlagBits::eGraphics)
+      // The search continues after a complete set to look for a dedicated compute
+      // family, so keep the first match of the others
+      if (available.queueFlags & vk::QueueFlagBits::eGraphics && !families.graphics)
         families.graphics = i;
-      if (available.queueFlags & vk::QueueFlagBits::eTransfer)
+      if (available.queueFlags & vk::QueueFlagBits::eTransfer && !families.transfer)
         families.transfer = i;
-      if (available.queueFlags & vk::QueueFlagBits::eCompute)
+      if (available.queueFlags & vk::QueueFlagBits::eCompute && !dedicated_compute) {
         families.async_compute = i;
-      if (present_support)
+        dedicated_compute =
+            !(available.queueFlags & vk::QueueFlagBits::eGraphics);
+      }
+      if (present_support && !families.present)
         families.present = i;
 
-      if (families.is_complete())
+      if (families.is_complete() && dedicated_compute)
         break;
     }
     i++;
@@ -81,9 +96,9 @@ uint32_t QueueFamilies::get_family(QueueType queue_type) {
 }
 
 Device::Device(std::vector<const char *> &&requested_extensions,
-               vk::PhysicalDeviceFeatures features, Surface &s,
+               vk::PhysicalDeviceFeatures features, Surface *s,
                vk::Instance *instance)
-	: device(ObjectDestroy<vk::Device>()) {
+	: device(ObjectDestroy<vk::Device>()), headless(!s) {
   pick_physical(std::forward<std::vector<const char *>>(requested_extensions),
                 features, s, instance);
 
@@ -93,7 +108,8 @@ Device::Device(std::vector<const char *> &&requested_extensions,
   std::vector<vk::DeviceQueueCreateInfo> queue_create_infos;
   std::set<uint32_t> unique_families = {families.graphics.value(),
                                         families.present.value(),
-                                        families.transfer.value()};
+                                        families.transfer.value(),
+                                        families.async_compute.value()};
   auto queue_priority = 1.0f;
   queue_create_infos.reserve(unique_families.size());
   for (auto &&family : unique_families) {
@@ -117,6 +133,44 @@ Device::Device(std::vector<const char *> &&requested_extensions,
   }
 #endif
 
+  // Bindless descriptors are optional, enable them if the device supports
+  // everything we need (partially bound arrays that can be updated while in use)
+  {
+    const auto available =
+        VK_GET(physical_device.enumerateDeviceExtensionProperties());
+    const auto has_extension =
+        std::any_of(available.begin(), available.end(), [](auto &ex) {
+          return !strcmp(ex.extensionName,
+                         VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        });
+
+    if (has_extension) {
+      const auto chain = physical_device.getFeatures2<
+          vk::PhysicalDeviceFeatures2,
+          vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+      const auto &supported =
+          chain.get<vk::PhysicalDeviceDescriptorIndexingFeaturesEXT>();
+
+      if (supported.runtimeDescriptorArray &&
+          supported.descriptorBindingPartiallyBound &&
+          supported.descriptorBindingSampledImageUpdateAfterBind &&
+          supported.descriptorBindingUpdateUnusedWhilePending &&
+          supported.shaderSampledImageArrayNonUniformIndexing) {
+        enabled_descriptor_indexing.runtimeDescriptorArray = true;
+        enabled_descriptor_indexing.descriptorBindingPartiallyBound = true;
+        enabled_descriptor_indexing
+            .descriptorBindingSampledImageUpdateAfterBind = true;
+        enabled_descriptor_indexing.descriptorBindingUpdateUnusedWhilePending =
+            true;
+        enabled_descriptor_indexing.shaderSampledImageArrayNonUniformIndexing =
+            true;
+        requested_extensions.push_back(
+            VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        spdlog::debug("adding descriptor indexing extension");
+      }
+    }
+  }
+
   vk::DeviceCreateInfo create_info{
       {},
       static_cast<uint32_t>(queue_create_infos.size()),
@@ -131,9 +185,12 @@ Device::Device(std::vector<const char *> &&requested_extensions,
       static_cast<uint32_t>(requested_extensions.size()),
       requested_extensions.data(),
       &features};
+  if (has_bindless())
+    create_info.pNext = &enabled_descriptor_indexing;
 
   device.set(VK_CREATE(physical_device.createDevice(create_info),
                        "failed to create device"));
+  enabled_features = features;
 
   // Get Queues
   present = device->getQueue(families.present.value(), 0);
@@ -161,6 +218,11 @@ Device::Device(std::vector<const char *> &&requested_extensions,
 
   default_allocator = std::make_unique<mem::DefaultAllocator>(*this);
 
+  pipeline_cache = UniqueHandle(
+      VK_CREATE(device->createPipelineCache({}),
+                "Failed to create Pipeline Cache"),
+      ObjectDestroy<vk::PipelineCache>(device.get()));
+
 #if defined(OVK_RENDERDOC_COMPAT)
   // Load the debug marker ext functions
   if (found_debug_marker_extension) {
@@ -185,7 +247,8 @@ Device::Device(std::vector<const char *> &&requested_extensions,
 
 void Device::pick_physical(std::vector<const char *> &&extensions,
                            vk::PhysicalDeviceFeatures requested_features,
-                           Surface &s, vk::Instance *instance) {
+                           Surface *s, vk::Instance *instance) {
+  const vk::SurfaceKHR surface = s ? s->surface.get() : vk::SurfaceKHR{};
 
   auto [result, devices] = instance->enumeratePhysicalDevices();
   if (devices.empty())
@@ -202,7 +265,7 @@ void Device::pick_physical(std::vector<const char *> &&extensions,
     }
 
     const auto found_extensions = requested.empty();
-    auto indices = QueueFamilies::find(pd, s.surface);
+    auto indices = QueueFamilies::find(pd, surface);
 
     auto features = pd.getFeatures();
     auto properties = pd.getProperties();
@@ -352,7 +415,7 @@ void Device::pick_physical(std::vector<const char *> &&extensions,
                  "Extensions and Features");
   // panic! ?
   physical_device = (--scores.end())->second;
-  families = QueueFamilies::find(physical_device, s.surface);
+  families = QueueFamilies::find(physical_device, surface);
 #ifdef DEBUG
   auto properties = physical_device.getProperties();
   spdlog::debug("{:=^80}", "[ Device Information ]");
@@ -401,12 +464,38 @@ std::optional<vk::Format> Device::default_depth_format() const {
   return depth_format;
 }
 
-SwapChain Device::create_swapchain(Surface &s) { return SwapChain(s, *this); }
+SwapChain Device::create_swapchain(Surface &s, vk::PresentModeKHR present_mode,
+                                   const SwapChain *old_swapchain) {
+  ovk_asserts(!headless, "[Device] (create_swapchain) headless devices can only "
+                         "create offscreen swapchains");
+  return SwapChain(s, *this, present_mode, old_swapchain);
+}
+
+SwapChain Device::create_offscreen_swapchain(vk::Extent2D extent,
+                                             vk::Format format,
+                                             uint32_t image_count) {
+  return SwapChain(*this, extent, format, image_count);
+}
+
+bool Device::is_headless() const { return headless; }
 
 std::pair<bool, uint32_t> Device::acquire_image(SwapChain &swap_chain,
                                                 vk::Semaphore signal_semaphore,
                                                 vk::Fence signal_fence,
                                                 uint64_t timeout) {
+  if (swap_chain.is_offscreen()) {
+    // Images are handed out in order, an empty submit signals the
+    // semaphore and fence like the presentation engine would
+    const auto index = swap_chain.next_image;
+    swap_chain.next_image = (index + 1) % swap_chain.image_count;
+
+    std::vector<vk::Semaphore> signal_semaphores;
+    if (signal_semaphore)
+      signal_semaphores.push_back(signal_semaphore);
+    submit({}, {}, std::move(signal_semaphores), signal_fence);
+    return std::make_pair(false, index);
+  }
+
   uint32_t index;
   const auto result = device->acquireNextImageKHR(
       swap_chain.handle.get(), timeout, signal_semaphore, signal_fence, &index);
@@ -425,6 +514,14 @@ void Device::submit(std::vector<WaitInfo> wait_semaphores,
                     std::vector<vk::CommandBuffer> cmds,
                     std::vector<vk::Semaphore> signal_semaphores,
                     vk::Fence fence) {
+  submit(QueueType::graphics, std::move(wait_semaphores), std::move(cmds),
+         std::move(signal_semaphores), fence);
+}
+
+void Device::submit(QueueType queue, std::vector<WaitInfo> wait_semaphores,
+                    std::vector<vk::CommandBuffer> cmds,
+                    std::vector<vk::Semaphore> signal_semaphores,
+                    vk::Fence fence) {
 
   std::vector<vk::Semaphore> wait_raw_semaphores;
   std::vector<vk::PipelineStageFlags> wait_stages;
@@ -446,12 +543,24 @@ void Device::submit(std::vector<WaitInfo> wait_semaphores,
       signal_semaphores.data(),
   };
 
-  VK_ASSERT(graphics.submit(1, &submit_info, fence),
+  VK_ASSERT(get_queue(queue).submit(1, &submit_info, fence),
             "Failed to submit Command Buffer");
 }
 
 bool Device::present_image(SwapChain &swap_chain, uint32_t index,
                            std::vector<vk::Semaphore> wait_semaphores) {
+  if (swap_chain.is_offscreen()) {
+    // Nothing to present, but the semaphores still have to be waited on
+    // (unsignaled) before they are signaled again
+    std::vector<WaitInfo> waits;
+    for (auto semaphore : wait_semaphores)
+      waits.push_back(
+          WaitInfo{semaphore, vk::PipelineStageFlagBits::eBottomOfPipe});
+    if (!waits.empty())
+      submit(std::move(waits), {}, {});
+    return false;
+  }
+
   vk::PresentInfoKHR present_info{static_cast<uint32_t>(wait_semaphores.size()),
                                   wait_semaphores.data(), 1,
                                   &swap_chain.handle.get(), &index};
@@ -479,6 +588,114 @@ GraphicsPipelineBuilder Device::build_pipeline() {
   return GraphicsPipelineBuilder(this);
 }
 
+ComputePipelineBuilder Device::build_compute_pipeline() {
+  return ComputePipelineBuilder(this);
+}
+
+std::string Device::pipeline_cache_file_name() const {
+  const auto properties = physical_device.getProperties();
+  std::string uuid;
+  for (auto byte : properties.pipelineCacheUUID)
+    uuid += fmt::format("{:02x}", byte);
+  return fmt::format("pipeline_cache_{:04x}_{:04x}_{}.bin",
+                     properties.vendorID, properties.deviceID, uuid);
+}
+
+bool Device::load_pipeline_cache(const std::string &directory) {
+  const auto path = std::filesystem::path(directory) / pipeline_cache_file_name();
+
+  std::ifstream file(path, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    spdlog::info("[Device] (load_pipeline_cache) no cache at {}, starting cold",
+                 path.string());
+    return false;
+  }
+
+  std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(data.data()), data.size());
+
+  // Drivers should reject foreign data themselves, but not all of them do
+  // (VkPipelineCacheHeaderVersionOne: size, version, vendor, device, uuid)
+  const auto properties = physical_device.getProperties();
+  const auto header_size = 16 + VK_UUID_SIZE;
+  uint32_t header[4];
+  if (data.size() < header_size) {
+    spdlog::warn("[Device] (load_pipeline_cache) {} is truncated",
+                 path.string());
+    return false;
+  }
+  memcpy(header, data.data(), sizeof(header));
+
+  if (header[0] < header_size ||
+      header[1] != static_cast<uint32_t>(
+                       vk::PipelineCacheHeaderVersion::eOne) ||
+      header[2] != properties.vendorID || header[3] != properties.deviceID ||
+      memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) !=
+          0) {
+    spdlog::warn("[Device] (load_pipeline_cache) {} was created by another "
+                 "device or driver, ignoring it",
+                 path.string());
+    return false;
+  }
+
+  auto loaded = VK_CREATE(
+      device->createPipelineCache({{}, data.size(), data.data()}),
+      "Failed to create Pipeline Cache from file");
+  VK_ASSERT(device->mergePipelineCaches(pipeline_cache->get(), {loaded}),
+            "Failed to merge Pipeline Caches");
+  device->destroyPipelineCache(loaded);
+
+  spdlog::info("[Device] (load_pipeline_cache) loaded {} bytes from {}",
+               data.size(), path.string());
+  return true;
+}
+
+bool Device::save_pipeline_cache(const std::string &directory) const {
+  const auto path = std::filesystem::path(directory) / pipeline_cache_file_name();
+
+  auto [result, data] = device->getPipelineCacheData(pipeline_cache->get());
+  if (result != vk::Result::eSuccess) {
+    spdlog::error("[Device] (save_pipeline_cache) failed to get cache data");
+    return false;
+  }
+
+  // Write to a temporary file first, so a crash can't leave a torn cache behind
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::error("[Device] (save_pipeline_cache) failed to open {}",
+                    tmp_path.string());
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tmp_path, path, error);
+  if (error) {
+    spdlog::error("[Device] (save_pipeline_cache) failed to write {}: {}",
+                  path.string(), error.message());
+    return false;
+  }
+
+  spdlog::info("[Device] (save_pipeline_cache) saved {} bytes to {}",
+               data.size(), path.string());
+  return true;
+}
+
+vk::PipelineCache Device::get_pipeline_cache() const {
+  return pipeline_cache->get();
+}
+
+PipelineRegistry &Device::get_pipeline_registry() { return *pipeline_registry; }
+
+ShaderCompiler &Device::get_shader_compiler() { return *shader_compiler; }
+
+util::ThreadPool &Device::get_thread_pool() { return *thread_pool; }
+
 Framebuffer Device::create_framebuffer(RenderPass &render_pass,
                                        vk::Extent3D extent,
                                        std::vector<vk::ImageView> attachments) {
@@ -528,6 +745,22 @@ Image Device::create_image(vk::ImageType type, vk::Format format,
   return Image(type, format, extent, flags, tiling, mem_type, allocator, *this);
 }
 
+Image Device::create_transient_attachment(vk::Format format,
+                                          vk::Extent2D extent,
+                                          vk::ImageUsageFlags usage) {
+  const auto mem_type =
+      mem::find_memory_type(physical_device,
+                            mem::mem_type_to_flags(
+                                mem::MemoryType::lazily_allocated))
+          ? mem::MemoryType::lazily_allocated
+          : mem::MemoryType::device_local;
+
+  return create_image(vk::ImageType::e2D, format,
+                      vk::Extent3D(extent.width, extent.height, 1),
+                      usage | vk::ImageUsageFlagBits::eTransientAttachment,
+                      vk::ImageTiling::eOptimal, mem_type);
+}
+
 ImageView Device::view_from_image(const Image &image,
                                   vk::ImageAspectFlags image_aspect,
                                   std::string swizzle) {
@@ -613,6 +846,7 @@ vk::CommandBuffer Device::create_single_submit_cmd(QueueType queue_type,
 
 void Device::flush(vk::CommandBuffer cmd, QueueType queue, bool end,
                    bool wait) {
+  OVK_PROFILE_SCOPE("Device::flush");
 
   if (end) {
     VK_ASSERT(cmd.end(), "Failed to end Command Buffer");
@@ -651,6 +885,14 @@ vk::Queue Device::get_queue(QueueType type) const {
   }
 }
 
+bool Device::has_async_compute() const {
+  return families.async_compute != families.graphics;
+}
+
+bool Device::has_bindless() const {
+  return enabled_descriptor_indexing.runtimeDescriptorArray;
+}
+
 void Device::free_commands(QueueType type,
                            std::vector<vk::CommandBuffer> &cmds) {
   device->freeCommandBuffers(get_command_pool(type), cmds);
@@ -676,26 +918,25 @@ Device::create_descriptor_pool(std::vector<DescriptorTemplate *> sets,
     spdlog::error("[Device] (create_descriptor_pool) For every template u need "
                   "to specify a number");
 
-  std::vector<vk::DescriptorPoolSize> sizes;
-
-  uint32_t buffer_size = 0, combined_sampler_size = 0;
+  // Every descriptor type (and array element) of the templates needs room
+  std::map<vk::DescriptorType, uint32_t> type_counts;
   for (auto i = 0; i < sets.size(); i++) {
-    for (auto &info : sets[i]->infos) {
-      if (info.type == vk::DescriptorType::eUniformBuffer)
-        buffer_size += num_sets[i];
-      if (info.type == vk::DescriptorType::eCombinedImageSampler)
-        combined_sampler_size += num_sets[i];
-    }
+    for (auto &info : sets[i]->infos)
+      type_counts[info.type] += info.count * num_sets[i];
   }
 
-  if (buffer_size > 0)
-    sizes.emplace_back(vk::DescriptorType::eUniformBuffer, buffer_size);
-  if (combined_sampler_size > 0)
-    sizes.emplace_back(vk::DescriptorType::eCombinedImageSampler,
-                       combined_sampler_size);
+  std::vector<vk::DescriptorPoolSize> sizes;
+  for (auto &[type, count] : type_counts)
+    sizes.emplace_back(type, count);
+
+  // Sets with update after bind bindings can only come from such a pool
+  const auto update_after_bind =
+      std::any_of(sets.begin(), sets.end(),
+                  [](auto *set) { return set->update_after_bind(); });
 
   vk::DescriptorPoolCreateInfo create_info{
-      {},
+      update_after_bind ? vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind
+                        : vk::DescriptorPoolCreateFlags{},
       std::accumulate(num_sets.begin(), num_sets.end(),
                       static_cast<uint32_t>(0)),
       static_cast<uint32_t>(sizes.size()),
@@ -724,6 +965,11 @@ Device::make_descriptor_sets(DescriptorPool &pool, uint32_t count,
   return sets;
 }
 
+DescriptorUpdateTemplate Device::create_descriptor_update_template(
+    const DescriptorTemplate &descriptor_template) {
+  return DescriptorUpdateTemplate(descriptor_template, device.get());
+}
+
 std::vector<Fence> Device::create_fences(uint32_t count,
                                          vk::FenceCreateFlags flags) {
   std::vector<Fence> result;
@@ -755,4 +1001,9 @@ void Device::reset_fences(std::vector<vk::Fence> fences) {
   device->resetFences(fences);
 }
 
+GpuProfiler Device::create_gpu_profiler(uint32_t frames_in_flight,
+                                        uint32_t max_regions) {
+  return GpuProfiler(frames_in_flight, max_regions, *this);
+}
+
 } // namespace ovk
@@ -12,6 +12,10 @@
 #include "debug.h"
 #include "sync.h"
 #include "image.h"
+#include "gpu_profiler.h"
+#include "shader_compiler.h"
+#include "bindless.h"
+#include "util/thread_pool.h"
 
 namespace ovk {
 	class Surface;
@@ -41,9 +45,10 @@ namespace ovk {
 	 */
 	class OVK_API Device {
 	private:
-		Device(std::vector<const char*>&& requested_extensions, vk::PhysicalDeviceFeatures requested_features, Surface& s, vk::Instance* instance);
+		// Without a surface (s == nullptr) the device is headless
+		Device(std::vector<const char*>&& requested_extensions, vk::PhysicalDeviceFeatures requested_features, Surface* s, vk::Instance* instance);
 		friend class Instance;
-		void pick_physical(std::vector<const char*>&& extensions, vk::PhysicalDeviceFeatures requested_features, Surface& s, vk::Instance* instance);
+		void pick_physical(std::vector<const char*>&& extensions, vk::PhysicalDeviceFeatures requested_features, Surface* s, vk::Instance* instance);
 	public:
 
 		Device(Device&& other) = default;
@@ -54,16 +59,30 @@ namespace ovk {
 
 		void wait_idle();
 		std::optional<vk::Format> default_depth_format() const;
+
+		// Workers for background jobs of the device (eg. GraphicsPipelineBuilder::build_async)
+		[[nodiscard]] util::ThreadPool& get_thread_pool();
 		
 		// ***************************************************************************************************************************************************************
 		// Swapchain
 		
-		SwapChain create_swapchain(Surface& s);
+		// present_mode is used if the surface supports it, otherwise the swapchain falls back to Fifo (see SwapChain::present_mode)
+		// With old_swapchain the new one is created through the oldSwapchain handoff, so presentation continues during a resize.
+		// The old swapchain is retired and has to stay alive until the frames that use it are finished (eg. FramePacer::retire)
+		SwapChain create_swapchain(Surface& s, vk::PresentModeKHR present_mode = vk::PresentModeKHR::eFifo, const SwapChain* old_swapchain = nullptr);
+		// Swapchain of offscreen images that works without a surface (eg. headless devices), acquire_image hands the
+		// images out in order and present_image only waits for the semaphores. Rendered images end up in eTransferSrcOptimal
+		SwapChain create_offscreen_swapchain(vk::Extent2D extent, vk::Format format = vk::Format::eB8G8R8A8Unorm, uint32_t image_count = 3);
+		// Created without a surface, there is no present queue (QueueType::present is the graphics queue)
+		[[nodiscard]] bool is_headless() const;
 
 		std::pair<bool, uint32_t> acquire_image(SwapChain& swap_chain, vk::Semaphore signal_semaphore = {}, vk::Fence signal_fence = {}, uint64_t timeout = VK_STD_TIMEOUT);
 		void submit(std::vector<WaitInfo> wait_semaphores, std::vector<vk::CommandBuffer> cmds, std::vector<vk::Semaphore> signal_semaphores, vk::Fence fence = {});
 
 		bool present_image(SwapChain& swap_chain, uint32_t index, std::vector<vk::Semaphore> wait_semaphores);
+
+		// Same as submit, but on any queue (eg. async_compute, signal a semaphore the graphics submit waits on)
+		void submit(QueueType queue, std::vector<WaitInfo> wait_semaphores, std::vector<vk::CommandBuffer> cmds, std::vector<vk::Semaphore> signal_semaphores, vk::Fence fence = {});
 		
 		// ***************************************************************************************************************************************************************
 		// Render Pass
@@ -74,6 +93,19 @@ namespace ovk {
 		// Pipelines
 
 		GraphicsPipelineBuilder build_pipeline();
+		ComputePipelineBuilder build_compute_pipeline();
+
+		// The cache file is named after vendor, device and cache uuid, so multiple gpus can share one directory
+		// Loaded data is merged into the device cache, so this may also be called after pipelines have been built
+		bool load_pipeline_cache(const std::string& directory = ".");
+		bool save_pipeline_cache(const std::string& directory = ".") const;
+		[[nodiscard]] vk::PipelineCache get_pipeline_cache() const;
+
+		// Pipelines built with GraphicsPipelineBuilder::build_cached
+		[[nodiscard]] PipelineRegistry& get_pipeline_registry();
+
+		// Used by GraphicsPipelineBuilder::add_shader_stage_from_file with compile_shader
+		[[nodiscard]] ShaderCompiler& get_shader_compiler();
 
 		// ***************************************************************************************************************************************************************
 		// Framebuffers
@@ -113,6 +145,9 @@ namespace ovk {
 		Image create_image_2d(vk::Format data, uint8_t* pixels, int channels, vk::Extent3D extent, vk::ImageUsageFlags image_usage);
 
 		Image create_image(vk::ImageType type, vk::Format format, vk::Extent3D extent, vk::ImageUsageFlags flags, vk::ImageTiling tiling, mem::MemoryType mem_type, mem::Allocator* allocator = nullptr);
+		// Attachment that never leaves the render pass (eg. a G-buffer read as input attachment), so usage may only contain
+		// attachment usages. Lazily allocated if the device supports it (tilers keep it in tile memory), device local otherwise
+		Image create_transient_attachment(vk::Format format, vk::Extent2D extent, vk::ImageUsageFlags usage);
 		
 		ImageView view_from_image(const Image& image, vk::ImageAspectFlags image_aspect = vk::ImageAspectFlagBits::eColor, std::string swizzle = "");
 
@@ -122,8 +157,9 @@ namespace ovk {
 		// ***************************************************************************************************************************************************************
 		// Command Buffers
 
+		// The commands are allocated from the pool of queue, so they can only be submitted there
 		template <typename Lambda>
-		std::vector<RenderCommand> create_render_commands(size_t count, Lambda&& init_capture);
+		std::vector<RenderCommand> create_render_commands(size_t count, Lambda&& init_capture, QueueType queue = QueueType::graphics);
 
 		vk::CommandBuffer create_single_submit_cmd(QueueType queue_type, bool start_cmd = true);
 		void flush(vk::CommandBuffer cmd, QueueType queue, bool end, bool wait);
@@ -137,6 +173,8 @@ namespace ovk {
 		// Queue
 		
 		[[nodiscard]] vk::Queue get_queue(QueueType type) const;
+		// True if async_compute is a different queue family than graphics (otherwise compute work is serialized with rendering)
+		[[nodiscard]] bool has_async_compute() const;
 		
 
 		// ***************************************************************************************************************************************************************
@@ -146,6 +184,12 @@ namespace ovk {
 
 		std::vector<DescriptorSet> make_descriptor_sets(DescriptorPool& pool, uint32_t count, const DescriptorTemplate& descriptor_template);
 
+		// For sets of this template that are rewritten often (see DescriptorSet::update)
+		DescriptorUpdateTemplate create_descriptor_update_template(const DescriptorTemplate& descriptor_template);
+
+		// True if VK_EXT_descriptor_indexing is enabled with everything BindlessTextures needs
+		[[nodiscard]] bool has_bindless() const;
+
 		// ***************************************************************************************************************************************************************
 		// Sync Functions
 		std::vector<Fence> create_fences(uint32_t count, vk::FenceCreateFlags flags = {});
@@ -155,20 +199,40 @@ namespace ovk {
 		void reset_fences(std::vector<vk::Fence> fences);
 
 
+		// ***************************************************************************************************************************************************************
+		// Queries
+
+		GpuProfiler create_gpu_profiler(uint32_t frames_in_flight, uint32_t max_regions = 64);
+
 		// ***************************************************************************************************************************************************************
 		// Fields
 		UniqueHandle<vk::Device> device;
 		vk::PhysicalDevice physical_device;
+		// Features the logical device was created with (eg. to check for optional query support)
+		vk::PhysicalDeviceFeatures enabled_features;
+		// Only the features needed for bindless descriptors are requested
+		vk::PhysicalDeviceDescriptorIndexingFeaturesEXT enabled_descriptor_indexing;
 		QueueFamilies families;
 
 		vk::Queue present, transfer, graphics, async_compute;
 		std::unordered_map<uint32_t, UniqueHandle<vk::CommandPool>> command_pools;
 		
 	private:
+		bool headless;
+
 		std::unique_ptr<Sampler> default_linear_sampler = nullptr;
 		std::unique_ptr<Sampler> default_nearest_sampler = nullptr;
 
 		std::unique_ptr<mem::DefaultAllocator> default_allocator = nullptr;
+
+		std::optional<UniqueHandle<vk::PipelineCache>> pipeline_cache = std::nullopt;
+		std::string pipeline_cache_file_name() const;
+
+		std::unique_ptr<PipelineRegistry> pipeline_registry = std::make_unique<PipelineRegistry>();
+		std::unique_ptr<ShaderCompiler> shader_compiler = std::make_unique<ShaderCompiler>();
+
+		// Declared last, so queued jobs are finished before anything they use is destroyed
+		std::unique_ptr<util::ThreadPool> thread_pool = std::make_unique<util::ThreadPool>(0, "Device Worker");
 	public:
 		// ***************************************************************************************************************************************************************
 		// Debug Marker
@@ -233,12 +297,12 @@ namespace ovk {
 
 
 	template <typename Lambda>
-	std::vector<RenderCommand> Device::create_render_commands(size_t count, Lambda &&init_capture) {
+	std::vector<RenderCommand> Device::create_render_commands(size_t count, Lambda &&init_capture, QueueType queue) {
 
 		static_assert(std::is_invocable_v<Lambda, RenderCommand&, int>, "Lambda must be invocable with (RenderCommand&, int)");
 
 		vk::CommandBufferAllocateInfo alloc_info{
-		get_command_pool(ovk::QueueType::graphics),
+		get_command_pool(queue),
 		vk::CommandBufferLevel::ePrimary,
 		static_cast<uint32_t>(count)
 		};
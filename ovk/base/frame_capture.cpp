@@ -0,0 +1,327 @@
+#include "pch.h"
+#include "frame_capture.h"
+
+#include "device.h"
+#include "image.h"
+#include "util/profiler.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace ovk {
+
+	using namespace std::chrono_literals;
+
+	static double to_ms(FrameCapture::Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	static double smooth(double average, double sample) {
+		return average == 0.0 ? sample : average + (sample - average) * 0.1;
+	}
+
+	// Bytes of one pixel in the readback buffer, 0 if we can not encode the format
+	static uint32_t pixel_size(vk::Format format) {
+		switch (format) {
+		case vk::Format::eR8G8B8A8Unorm:
+		case vk::Format::eR8G8B8A8Srgb:
+		case vk::Format::eB8G8R8A8Unorm:
+		case vk::Format::eB8G8R8A8Srgb:
+			return 4;
+		case vk::Format::eR16G16B16A16Sfloat:
+			return 8;
+		case vk::Format::eR32G32B32A32Sfloat:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	static bool write_png(const std::string& path, vk::Extent2D extent, const uint8_t* data, bool bgra) {
+		const auto pixels = static_cast<size_t>(extent.width) * extent.height;
+
+		std::vector<uint8_t> swizzled;
+		if (bgra) {
+			swizzled.assign(data, data + pixels * 4);
+			for (size_t i = 0; i < pixels; i++)
+				std::swap(swizzled[i * 4], swizzled[i * 4 + 2]);
+			data = swizzled.data();
+		}
+
+		return stbi_write_png(path.c_str(), static_cast<int>(extent.width), static_cast<int>(extent.height), 4, data, static_cast<int>(extent.width * 4)) != 0;
+	}
+
+	// Scanline exr without compression and one line per block, simple enough that we do not need another dependency
+	// component_size 2 writes half, 4 float channels
+	static bool write_exr(const std::string& path, vk::Extent2D extent, const uint8_t* data, uint32_t component_size) {
+		std::ofstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+
+		std::vector<char> header;
+		const auto put = [&](const void* value, size_t size) {
+			const auto bytes = static_cast<const char*>(value);
+			header.insert(header.end(), bytes, bytes + size);
+		};
+		const auto put_int = [&](int32_t value) { put(&value, sizeof(value)); };
+		const auto put_attribute = [&](const char* name, const char* type, int32_t size) {
+			put(name, std::strlen(name) + 1);
+			put(type, std::strlen(type) + 1);
+			put_int(size);
+		};
+
+		// Magic number and version 2, single part scanline
+		put_int(20000630);
+		put_int(2);
+
+		// Channels have to be sorted by name, the readback buffer is rgba
+		const char* channel_names[] = { "A", "B", "G", "R" };
+		const uint32_t channel_components[] = { 3, 2, 1, 0 };
+		const int32_t pixel_type = component_size == 2 ? 1 : 2;
+		put_attribute("channels", "chlist", 4 * (2 + 16) + 1);
+		for (const auto name : channel_names) {
+			put(name, 2);
+			put_int(pixel_type);
+			// pLinear and reserved
+			const uint8_t linear[4] = {};
+			put(linear, sizeof(linear));
+			// x and y sampling
+			put_int(1);
+			put_int(1);
+		}
+		header.push_back(0);
+
+		const int32_t window[] = { 0, 0, static_cast<int32_t>(extent.width) - 1, static_cast<int32_t>(extent.height) - 1 };
+		const float one = 1.0f;
+		const float center[] = { 0.0f, 0.0f };
+		put_attribute("compression", "compression", 1);
+		header.push_back(0);
+		put_attribute("dataWindow", "box2i", sizeof(window));
+		put(window, sizeof(window));
+		put_attribute("displayWindow", "box2i", sizeof(window));
+		put(window, sizeof(window));
+		put_attribute("lineOrder", "lineOrder", 1);
+		header.push_back(0);
+		put_attribute("pixelAspectRatio", "float", sizeof(one));
+		put(&one, sizeof(one));
+		put_attribute("screenWindowCenter", "v2f", sizeof(center));
+		put(center, sizeof(center));
+		put_attribute("screenWindowWidth", "float", sizeof(one));
+		put(&one, sizeof(one));
+		header.push_back(0);
+
+		// Offset table, followed by the blocks: y, size and the line of every channel one after another
+		const size_t line_size = static_cast<size_t>(extent.width) * 4 * component_size;
+		std::vector<uint64_t> offsets(extent.height);
+		for (uint32_t y = 0; y < extent.height; y++)
+			offsets[y] = header.size() + offsets.size() * sizeof(uint64_t) + y * (2 * sizeof(int32_t) + line_size);
+
+		file.write(header.data(), header.size());
+		file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+		std::vector<uint8_t> line(line_size);
+		for (uint32_t y = 0; y < extent.height; y++) {
+			const auto source = data + y * line_size;
+			for (uint32_t c = 0; c < 4; c++)
+				for (uint32_t x = 0; x < extent.width; x++)
+					std::memcpy(&line[(c * extent.width + x) * component_size], source + (x * 4 + channel_components[c]) * component_size, component_size);
+
+			const int32_t block[] = { static_cast<int32_t>(y), static_cast<int32_t>(line_size) };
+			file.write(reinterpret_cast<const char*>(block), sizeof(block));
+			file.write(reinterpret_cast<const char*>(line.data()), line_size);
+		}
+
+		return file.good();
+	}
+
+	// Runs on the encoder, returns the time it took in ms or a negative value if writing failed
+	static double encode(const uint8_t* data, vk::Extent2D extent, vk::Format format, const std::string& path) {
+		OVK_PROFILE_SCOPE("FrameCapture::encode");
+		const auto start = FrameCapture::Clock::now();
+
+		bool written;
+		switch (format) {
+		case vk::Format::eR16G16B16A16Sfloat:
+			written = write_exr(path, extent, data, 2);
+			break;
+		case vk::Format::eR32G32B32A32Sfloat:
+			written = write_exr(path, extent, data, 4);
+			break;
+		default:
+			written = write_png(path, extent, data, format == vk::Format::eB8G8R8A8Unorm || format == vk::Format::eB8G8R8A8Srgb);
+			break;
+		}
+
+		return written ? to_ms(FrameCapture::Clock::now() - start) : -1.0;
+	}
+
+	FrameCapture::FrameCapture(Device& device, uint32_t slot_count, uint32_t encoder_threads) : device(device),
+		atom_size(std::max<vk::DeviceSize>(device.physical_device.getProperties().limits.nonCoherentAtomSize, 1)),
+		fences(device.create_fences(slot_count)), slots(slot_count), encoder(std::max(encoder_threads, 1u), "Capture Encoder") {}
+
+	FrameCapture::~FrameCapture() {
+		flush();
+		for (auto& slot : slots)
+			if (slot.buffer) slot.buffer->memory->unmap(device);
+	}
+
+	bool FrameCapture::capture(vk::Image image, vk::ImageLayout layout, vk::Extent2D extent, vk::Format format, std::string path,
+		std::vector<WaitInfo> wait_semaphores, std::vector<vk::Semaphore> signal_semaphores) {
+		OVK_PROFILE_SCOPE("FrameCapture::capture");
+		const auto start = Clock::now();
+
+		const auto pixel = pixel_size(format);
+		if (pixel == 0) {
+			spdlog::error("[FrameCapture] (capture) format {} is not supported", vk::to_string(format));
+			return false;
+		}
+		ovk_asserts(layout != vk::ImageLayout::eUndefined, "[FrameCapture] (capture) {} has undefined contents", path);
+
+		update();
+		const auto slot_it = std::find_if(slots.begin(), slots.end(), [](const Slot& s) { return s.state == State::free; });
+		if (slot_it == slots.end()) {
+			stats.dropped++;
+			spdlog::warn("[FrameCapture] (capture) all {} slots are busy, dropped {}", slots.size(), path);
+			return false;
+		}
+		auto& slot = *slot_it;
+		auto& fence = fences[slot_it - slots.begin()];
+
+		const vk::DeviceSize size = static_cast<vk::DeviceSize>(extent.width) * extent.height * pixel;
+		if (!slot.buffer || slot.buffer->size < size) {
+			if (slot.buffer) slot.buffer->memory->unmap(device);
+			slot.buffer = ovk::make_unique(device.create_buffer(
+				vk::BufferUsageFlagBits::eTransferDst,
+				size,
+				nullptr,
+				{ QueueType::graphics },
+				mem::MemoryType::cpu_cached
+			));
+			slot.data = slot.buffer->memory->map(device);
+		}
+
+		slot.cmd = device.create_single_submit_cmd(QueueType::graphics, true);
+
+		// Barriers also order against the commands of earlier submissions, so this waits for whatever rendered the image
+		const vk::ImageSubresourceRange range{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+		const vk::ImageMemoryBarrier to_transfer{
+			vk::AccessFlagBits::eMemoryWrite, vk::AccessFlagBits::eTransferRead,
+			layout, vk::ImageLayout::eTransferSrcOptimal,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range
+		};
+		slot.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eAllCommands, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, { to_transfer });
+
+		const vk::BufferImageCopy region{
+			0, 0, 0,
+			vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+			vk::Offset3D{ 0, 0, 0 },
+			vk::Extent3D{ extent.width, extent.height, 1 }
+		};
+		slot.cmd.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, slot.buffer->handle.get(), { region });
+
+		if (layout != vk::ImageLayout::eTransferSrcOptimal) {
+			const vk::ImageMemoryBarrier back{
+				{}, vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite,
+				vk::ImageLayout::eTransferSrcOptimal, layout,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, image, range
+			};
+			slot.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eAllCommands, {}, {}, {}, { back });
+		}
+
+		const vk::BufferMemoryBarrier to_host{
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED, slot.buffer->handle.get(), 0, size
+		};
+		slot.cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, { to_host }, {});
+
+		VK_ASSERT(slot.cmd.end(), "[FrameCapture] (capture) failed to end command buffer");
+
+		device.reset_fences({ fence });
+		device.submit(std::move(wait_semaphores), { slot.cmd }, std::move(signal_semaphores), fence);
+
+		slot.state = State::in_flight;
+		slot.extent = extent;
+		slot.format = format;
+		slot.path = std::move(path);
+		slot.submitted = Clock::now();
+
+		stats.record_time = smooth(stats.record_time, to_ms(slot.submitted - start));
+		return true;
+	}
+
+	bool FrameCapture::capture(Image& image, std::string path) {
+		return capture(image.handle.get(), image.layout, vk::Extent2D{ image.extent.width, image.extent.height }, image.format, std::move(path));
+	}
+
+	void FrameCapture::update() {
+		for (size_t i = 0; i < slots.size(); i++) {
+			auto& slot = slots[i];
+			if (slot.state == State::in_flight && device.device->getFenceStatus(fences[i].handle.get()) == vk::Result::eSuccess)
+				readback(slot);
+			if (slot.state == State::encoding && slot.encoded.wait_for(0s) == std::future_status::ready)
+				finish(slot);
+		}
+	}
+
+	void FrameCapture::flush() {
+		OVK_PROFILE_SCOPE("FrameCapture::flush");
+		for (size_t i = 0; i < slots.size(); i++) {
+			auto& slot = slots[i];
+			if (slot.state == State::in_flight) {
+				device.wait_fences({ fences[i] });
+				readback(slot);
+			}
+		}
+		for (auto& slot : slots)
+			if (slot.state == State::encoding) finish(slot);
+	}
+
+	const FrameCapture::Stats& FrameCapture::get_stats() const { return stats; }
+
+	void FrameCapture::debug_draw() {
+		ImGui::Begin("Frame Capture");
+		ImGui::Text("Captured: %llu, dropped: %llu", static_cast<unsigned long long>(stats.captured), static_cast<unsigned long long>(stats.dropped));
+		ImGui::Text("Record: %.3f ms", stats.record_time);
+		ImGui::Text("Readback latency: %.3f ms", stats.readback_latency);
+		ImGui::Text("Encode: %.3f ms", stats.encode_time);
+		ImGui::End();
+	}
+
+	void FrameCapture::readback(Slot& slot) {
+		stats.readback_latency = smooth(stats.readback_latency, to_ms(Clock::now() - slot.submitted));
+		device.device->freeCommandBuffers(device.get_command_pool(QueueType::graphics), { slot.cmd });
+
+		// Host cached memory need not be coherent, without this the cpu may read stale cache lines. The range is widened to
+		// whole atoms, the buffer is only ever written by the gpu, so nothing the cpu wrote can be discarded. A range that
+		// is not a multiple of the atom size is only valid if it ends at the end of the allocation, so it is clamped there
+		auto& memory = *slot.buffer->memory;
+		const auto begin = memory.get_offset() / atom_size * atom_size;
+		const auto end = (memory.get_offset() + memory.get_size() + atom_size - 1) / atom_size * atom_size;
+		const auto size = end <= memory.get_allocation_size() ? end - begin : VK_WHOLE_SIZE;
+		VK_ASSERT(device.device->invalidateMappedMemoryRanges({ vk::MappedMemoryRange{ memory.get(), begin, size } }),
+			"[FrameCapture] (readback) failed to invalidate the readback buffer");
+
+		// The slot is not touched until the job is done, so the worker can read the mapped buffer directly
+		slot.encoded = encoder.submit([data = static_cast<const uint8_t*>(slot.data), extent = slot.extent, format = slot.format, path = slot.path]() {
+			return encode(data, extent, format, path);
+		});
+		slot.state = State::encoding;
+	}
+
+	void FrameCapture::finish(Slot& slot) {
+		const auto ms = slot.encoded.get();
+		if (ms < 0.0) {
+			spdlog::error("[FrameCapture] (finish) failed to write {}", slot.path);
+		} else {
+			stats.captured++;
+			stats.encode_time = smooth(stats.encode_time, ms);
+		}
+		slot.state = State::free;
+	}
+
+}
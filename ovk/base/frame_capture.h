@@ -0,0 +1,104 @@
+#pragma once
+
+#include "handle.h"
+
+#include "buffer.h"
+#include "frame_pacer.h"
+#include "sync.h"
+#include "util/thread_pool.h"
+
+#include <chrono>
+#include <future>
+
+namespace ovk {
+	class Device;
+	class Image;
+
+	/**
+	 * \brief Writes render targets to disk without stalling the frame (eg. golden images of a headless run)
+	 *				Usage, after the frame rendering into the image was submitted:
+	 *					capture.capture(swapchain.images[index], layout, swapchain.swap_extent, format, "frame_42.png");
+	 *					...
+	 *					capture.update();		// once per frame, hands finished readbacks to the encoder
+	 *
+	 *				Every capture takes a slot of the ring: its own command buffer copies the image into a host cached
+	 *				readback buffer and is submitted on the graphics queue with the fence of the slot. Pipeline barriers
+	 *				order it after everything submitted before, so no semaphore is needed. Once update sees the fence
+	 *				signaled, the (possibly non coherent) buffer is invalidated and encoded on a worker thread and the slot is free again after that. With the
+	 *				default of FramePacer::max_frames_in_flight + 1 slots a frame can be captured while later frames are
+	 *				recorded. If all slots are busy the capture is dropped (and counted) instead of waiting for one
+	 *
+	 *				8 bit rgba/bgra formats are written as png, 16 and 32 bit float rgba formats as uncompressed exr.
+	 *				A presented image must not be captured after it was presented, for a window swapchain pass the
+	 *				render finished semaphore as wait and present with the signaled one
+	 */
+	class OVK_API FrameCapture {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Stats {
+			uint64_t captured = 0;
+			uint64_t dropped = 0;
+			// Smoothed, in ms
+			// cpu time of recording and submitting the copy
+			double record_time = 0.0;
+			// From the submit until update saw the fence signaled (an upper bound of the gpu copy)
+			double readback_latency = 0.0;
+			// Encoding and writing the file on the worker
+			double encode_time = 0.0;
+		};
+
+		explicit FrameCapture(Device& device, uint32_t slot_count = FramePacer::max_frames_in_flight + 1, uint32_t encoder_threads = 1);
+		~FrameCapture();
+
+		FrameCapture(const FrameCapture& other) = delete;
+		FrameCapture& operator=(const FrameCapture& other) = delete;
+
+		// layout is the one the image is in when the capture runs, it is in the same layout afterwards
+		// Returns false if the format is not supported or no slot is free
+		bool capture(vk::Image image, vk::ImageLayout layout, vk::Extent2D extent, vk::Format format, std::string path,
+			std::vector<WaitInfo> wait_semaphores = {}, std::vector<vk::Semaphore> signal_semaphores = {});
+		bool capture(Image& image, std::string path);
+
+		// Polls the fences of the slots in flight and the encoder jobs, never blocks
+		void update();
+		// Waits until every capture so far is written to disk
+		void flush();
+
+		[[nodiscard]] const Stats& get_stats() const;
+		void debug_draw();
+
+	private:
+		enum class State { free, in_flight, encoding };
+
+		struct Slot {
+			State state = State::free;
+			std::unique_ptr<Buffer> buffer;
+			// Persistently mapped while the slot has a buffer
+			void* data = nullptr;
+			vk::CommandBuffer cmd;
+
+			vk::Extent2D extent;
+			vk::Format format;
+			std::string path;
+			Clock::time_point submitted;
+			// Encoding time in ms, negative if writing the file failed
+			std::future<double> encoded;
+		};
+
+		// Hands the slot to the encoder, the fence must be signaled
+		void readback(Slot& slot);
+		void finish(Slot& slot);
+
+		Device& device;
+		// Invalidated ranges of the readback buffers have to be aligned to it
+		vk::DeviceSize atom_size;
+		std::vector<Fence> fences;
+		std::vector<Slot> slots;
+		Stats stats;
+
+		// Declared last, so queued jobs are finished before the buffers they read are destroyed
+		util::ThreadPool encoder;
+	};
+
+}
@@ -0,0 +1,280 @@
+#include "pch.h"
+#include "frame_pacer.h"
+
+#include "device.h"
+#include "frame_scheduler.h"
+#include "util/profiler.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <thread>
+
+namespace ovk {
+
+	using namespace std::chrono_literals;
+
+	// A completion observed within this window counts as an exact measurement
+	constexpr auto precise_window = 1ms;
+	// The low latency mode submits this much before the predicted gpu completion, so jitter does not starve the gpu
+	constexpr auto low_latency_slack = 500us;
+	// sleep_until overshoots by up to a few ms on most schedulers, the rest is spun
+	constexpr auto spin_window = 2ms;
+
+	static double to_ms(FramePacer::Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	static FramePacer::Clock::duration from_ms(double ms) {
+		return std::chrono::duration_cast<FramePacer::Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+	}
+
+	static double smooth(double average, double sample) {
+		return average == 0.0 ? sample : average + (sample - average) * 0.1;
+	}
+
+	static FramePacer::Settings sanitize(FramePacer::Settings settings) {
+		settings.frames_in_flight = std::clamp(settings.frames_in_flight, 1u, FramePacer::max_frames_in_flight);
+		settings.target_frame_time = std::max(settings.target_frame_time, 0.0f);
+		return settings;
+	}
+
+	FramePacer::FramePacer(Device& device, Settings s) : device(device),
+		in_flight_fences(device.create_fences(max_frames_in_flight, vk::FenceCreateFlagBits::eSignaled)),
+		image_available(device.create_semaphores(max_frames_in_flight)),
+		render_finished(device.create_semaphores(max_frames_in_flight)),
+		settings(sanitize(s)), pending_settings(settings),
+		frame_start(Clock::now()), last_completed(frame_start) {}
+
+	std::optional<uint32_t> FramePacer::begin_frame(SwapChain& swapchain, uint64_t timeout) {
+		OVK_PROFILE_SCOPE("FramePacer::begin_frame");
+
+		if (apply_settings())
+			return std::nullopt;
+
+		wait(current_frame, timeout);
+		poll();
+
+		auto start = Clock::now();
+		if (settings.target_frame_time > 0.0f)
+			start = std::max(start, frame_start + from_ms(settings.target_frame_time));
+
+		if (settings.low_latency && gpu_time > 0.0) {
+			// The gpu works through the frames in submission order, each one starts once it is submitted and the one before is done
+			auto predicted = last_completed;
+			for (const auto frame : pending_frames())
+				predicted = std::max(predicted, timings[frame].submitted) + from_ms(gpu_time);
+
+			start = std::max(start, predicted - from_ms(cpu_time) - low_latency_slack);
+		}
+
+		sleep_until(start);
+		frame_start = Clock::now();
+
+		auto [recreate, index] = device.acquire_image(swapchain, image_available[current_frame], {}, timeout);
+		if (recreate)
+			return std::nullopt;
+
+		image_index = index;
+		return index;
+	}
+
+	WaitInfo FramePacer::get_image_available(vk::PipelineStageFlags stages) const {
+		return WaitInfo{ image_available[current_frame].handle.get(), stages };
+	}
+
+	vk::Semaphore FramePacer::get_render_finished() const {
+		return render_finished[current_frame].handle.get();
+	}
+
+	void FramePacer::submit(std::vector<vk::CommandBuffer> cmds) {
+		device.reset_fences({ in_flight_fences[current_frame] });
+		device.submit({ get_image_available() }, std::move(cmds), { get_render_finished() }, in_flight_fences[current_frame]);
+		end_submit();
+	}
+
+	void FramePacer::submit(FrameScheduler& scheduler) {
+		device.reset_fences({ in_flight_fences[current_frame] });
+		scheduler.submit(in_flight_fences[current_frame]);
+		end_submit();
+	}
+
+	bool FramePacer::present(SwapChain& swapchain) {
+		OVK_PROFILE_SCOPE("FramePacer::present");
+
+		const auto recreate = device.present_image(swapchain, image_index, { get_render_finished() });
+		current_frame = (current_frame + 1) % settings.frames_in_flight;
+
+		// Another look at the fences, the closer together they are the more precise the measurement
+		poll();
+		return recreate;
+	}
+
+	void FramePacer::wait_last_frame() {
+		wait(last_frame, VK_STD_TIMEOUT);
+	}
+
+	void FramePacer::set_settings(const Settings& s) {
+		pending_settings = sanitize(s);
+		settings_changed = true;
+	}
+
+	const FramePacer::Settings& FramePacer::get_settings() const { return pending_settings; }
+
+	vk::PresentModeKHR FramePacer::get_present_mode() const { return settings.present_mode; }
+
+	uint32_t FramePacer::get_frame() const { return current_frame; }
+
+	double FramePacer::get_gpu_time() const { return gpu_time; }
+
+	double FramePacer::get_cpu_time() const { return cpu_time; }
+
+	double FramePacer::get_pacing_delay() const { return pacing_delay; }
+
+	void FramePacer::debug_draw() {
+		ImGui::Begin("Frame Pacer");
+
+		auto s = pending_settings;
+		auto changed = false;
+
+		auto frames_in_flight = static_cast<int>(s.frames_in_flight);
+		if (ImGui::SliderInt("frames in flight", &frames_in_flight, 1, static_cast<int>(max_frames_in_flight))) {
+			s.frames_in_flight = static_cast<uint32_t>(frames_in_flight);
+			changed = true;
+		}
+
+		const vk::PresentModeKHR modes[] = { vk::PresentModeKHR::eFifo, vk::PresentModeKHR::eFifoRelaxed, vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate };
+		const char* mode_names[] = { "Fifo", "Fifo Relaxed", "Mailbox", "Immediate" };
+		int mode = static_cast<int>(std::find(std::begin(modes), std::end(modes), s.present_mode) - std::begin(modes));
+		if (ImGui::Combo("present mode", &mode, mode_names, IM_ARRAYSIZE(mode_names))) {
+			s.present_mode = modes[mode];
+			changed = true;
+		}
+
+		changed |= ImGui::SliderFloat("target frame time (ms)", &s.target_frame_time, 0.0f, 50.0f);
+		changed |= ImGui::Checkbox("low latency", &s.low_latency);
+
+		if (changed) set_settings(s);
+
+		ImGui::Separator();
+		ImGui::Text("CPU frame: %.3f ms", cpu_time);
+		ImGui::Text("GPU frame: %.3f ms", gpu_time);
+		ImGui::Text("Pacing delay: %.3f ms", pacing_delay);
+
+		ImGui::End();
+	}
+
+	bool FramePacer::apply_settings() {
+		if (!settings_changed)
+			return false;
+		settings_changed = false;
+
+		if (pending_settings.frames_in_flight != settings.frames_in_flight) {
+			// Slots are handed out modulo frames_in_flight, so none of them may still be in use when the count changes
+			for (const auto frame : pending_frames())
+				wait(frame, VK_STD_TIMEOUT);
+			current_frame = 0;
+		}
+
+		const auto recreate = pending_settings.present_mode != settings.present_mode;
+		settings = pending_settings;
+		return recreate;
+	}
+
+	std::vector<uint32_t> FramePacer::pending_frames() const {
+		std::vector<uint32_t> frames;
+		for (uint32_t frame = 0; frame < max_frames_in_flight; frame++)
+			if (timings[frame].pending) frames.push_back(frame);
+
+		std::sort(frames.begin(), frames.end(), [&](uint32_t a, uint32_t b) { return timings[a].submitted < timings[b].submitted; });
+		return frames;
+	}
+
+	void FramePacer::poll() {
+		auto signaled = true;
+		for (const auto frame : pending_frames()) {
+			// Once a frame is still running the later ones can not be done either
+			signaled = signaled && device.device->getFenceStatus(in_flight_fences[frame].handle.get()) == vk::Result::eSuccess;
+
+			const auto now = Clock::now();
+			if (signaled)
+				complete(frame, timings[frame].last_unsignaled, now);
+			else
+				timings[frame].last_unsignaled = now;
+		}
+		collect();
+	}
+
+	void FramePacer::wait(uint32_t frame, uint64_t timeout) {
+		if (!timings[frame].pending)
+			return;
+
+		// Everything submitted before has to finish first
+		poll();
+		if (!timings[frame].pending)
+			return;
+
+		OVK_PROFILE_SCOPE("wait for frame fence");
+		device.wait_fences({ in_flight_fences[frame] }, true, timeout);
+
+		// We were blocked on it, so waking up is the completion. Frames submitted before are done as well
+		const auto now = Clock::now();
+		for (const auto pending : pending_frames()) {
+			if (pending == frame) {
+				complete(frame, now, now);
+				break;
+			}
+			complete(pending, timings[pending].last_unsignaled, now);
+		}
+		collect();
+	}
+
+	void FramePacer::complete(uint32_t frame, Clock::time_point earliest, Clock::time_point latest) {
+		auto& timing = timings[frame];
+		if (!timing.pending)
+			return;
+		timing.pending = false;
+
+		const auto gpu_start = std::max(timing.submitted, last_completed);
+		const auto sample = to_ms(latest - gpu_start);
+		if (latest - earliest <= precise_window)
+			gpu_time = smooth(gpu_time, sample);
+		else if (sample < gpu_time)
+			// Only an upper bound, but it shows that the estimate is too high
+			gpu_time = sample;
+
+		// The earliest point keeps the start of the next frame a lower bound, so its sample stays an upper bound
+		last_completed = std::max(last_completed, earliest);
+		completed_frames = std::max(completed_frames, timing.serial);
+	}
+
+	void FramePacer::sleep_until(Clock::time_point time) {
+		const auto now = Clock::now();
+		pacing_delay = time > now ? to_ms(time - now) : 0.0;
+		if (time <= now)
+			return;
+
+		OVK_PROFILE_SCOPE("frame pacing");
+		if (time - now > spin_window)
+			std::this_thread::sleep_until(time - spin_window);
+		while (Clock::now() < time)
+			std::this_thread::yield();
+	}
+
+	void FramePacer::end_submit() {
+		const auto now = Clock::now();
+		cpu_time = smooth(cpu_time, to_ms(now - frame_start));
+
+		auto& timing = timings[current_frame];
+		timing.submitted = now;
+		timing.last_unsignaled = now;
+		timing.serial = ++submitted_frames;
+		timing.pending = true;
+		last_frame = current_frame;
+	}
+
+	void FramePacer::collect() {
+		while (!retired.empty() && retired.front().serial <= completed_frames)
+			retired.pop_front();
+	}
+
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "handle.h"
+
+#include "sync.h"
+
+#include <array>
+#include <chrono>
+#include <deque>
+
+namespace ovk {
+	class Device;
+	class SwapChain;
+	class FrameScheduler;
+
+	/**
+	 * \brief Owns the acquire, submit and present synchronization of the frames in flight and paces the frame start
+	 *				Usage per frame:
+	 *					auto index = pacer.begin_frame(swapchain);		// std::nullopt -> recreate the swapchain with get_present_mode()
+	 *					... record, per frame resources are indexed with get_frame() ...
+	 *					pacer.submit(cmds);													// or through a FrameScheduler
+	 *					if (pacer.present(swapchain)) recreate ...
+	 *
+	 *				Pacing happens in begin_frame, after the fence of the frame slot was waited on:
+	 *				- target_frame_time caps the frame rate by delaying the frame start
+	 *				- low_latency delays the frame start so that the submit lands just before the gpu finishes the previous frame,
+	 *					nothing is queued up in front of the gpu and input is sampled as late as possible. Without it a gpu bound
+	 *					application runs frames_in_flight frames ahead of the gpu. The gpu time of a frame is measured from the
+	 *					points in time its fence is observed to be signaled
+	 *				Settings can be changed at any time and take effect with the next begin_frame
+	 */
+	class OVK_API FramePacer {
+	public:
+		static constexpr uint32_t max_frames_in_flight = 3;
+
+		using Clock = std::chrono::steady_clock;
+
+		struct Settings {
+			// 1 - max_frames_in_flight, more frames in flight trade latency for throughput
+			uint32_t frames_in_flight = 2;
+			// Applied by recreating the swapchain (begin_frame returns std::nullopt once after a change)
+			vk::PresentModeKHR present_mode = vk::PresentModeKHR::eFifo;
+			// Minimum time between two frame starts in ms, 0 means unlimited
+			float target_frame_time = 0.0f;
+			bool low_latency = false;
+		};
+
+		explicit FramePacer(Device& device, Settings settings = {});
+
+		FramePacer(const FramePacer& other) = delete;
+		FramePacer& operator=(const FramePacer& other) = delete;
+
+		// Waits for the frame slot, paces and acquires the next image
+		// Returns the swapchain index, std::nullopt if the swapchain has to be recreated (out of date or the present mode changed)
+		std::optional<uint32_t> begin_frame(SwapChain& swapchain, uint64_t timeout = VK_STD_TIMEOUT);
+
+		// For work items that render into the swapchain image, when submitting through a FrameScheduler
+		[[nodiscard]] WaitInfo get_image_available(vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eColorAttachmentOutput) const;
+		[[nodiscard]] vk::Semaphore get_render_finished() const;
+
+		// Submits cmds on the graphics queue, waiting for the image and signaling render finished
+		void submit(std::vector<vk::CommandBuffer> cmds);
+		// Submits everything added to scheduler since scheduler.begin_frame(get_frame()), the item rendering into the
+		// swapchain image has to wait for get_image_available and signal get_render_finished
+		void submit(FrameScheduler& scheduler);
+
+		// Returns true if the swapchain has to be recreated
+		bool present(SwapChain& swapchain);
+
+		// Waits until the gpu finished the last submitted frame (eg. before reading back its results)
+		void wait_last_frame();
+
+		// Keeps object alive until every frame submitted so far is finished, so resources that frames in flight still use
+		// (eg. a retired swapchain or the attachments of the old extent) can be replaced without waiting for the device
+		template <typename T>
+		void retire(T object) {
+			retired.push_back(Retired{ submitted_frames, std::make_shared<T>(std::move(object)) });
+		}
+
+		void set_settings(const Settings& settings);
+		[[nodiscard]] const Settings& get_settings() const;
+		[[nodiscard]] vk::PresentModeKHR get_present_mode() const;
+
+		// Frame slot of the current frame (< max_frames_in_flight), per frame resources should be created max_frames_in_flight times
+		[[nodiscard]] uint32_t get_frame() const;
+
+		// Smoothed measurements in ms
+		[[nodiscard]] double get_gpu_time() const;
+		[[nodiscard]] double get_cpu_time() const;
+		// Time the last begin_frame slept for pacing
+		[[nodiscard]] double get_pacing_delay() const;
+
+		void debug_draw();
+
+	private:
+		struct Timing {
+			Clock::time_point submitted;
+			// Last time the fence was seen unsignaled, the completion lies between this and the first time it is seen signaled
+			Clock::time_point last_unsignaled;
+			uint64_t serial = 0;
+			bool pending = false;
+		};
+
+		struct Retired {
+			// Destroyed once the frame with this serial is finished
+			uint64_t serial;
+			std::shared_ptr<void> object;
+		};
+
+		// Returns true if the swapchain has to be recreated
+		bool apply_settings();
+		// Pending frames in submission order
+		std::vector<uint32_t> pending_frames() const;
+		// Polls the fences of all pending frames and measures the ones that finished
+		void poll();
+		void wait(uint32_t frame, uint64_t timeout);
+		// The frame finished somewhere in [earliest, latest]
+		void complete(uint32_t frame, Clock::time_point earliest, Clock::time_point latest);
+		void sleep_until(Clock::time_point time);
+		void end_submit();
+		void collect();
+
+		Device& device;
+		std::vector<Fence> in_flight_fences;
+		std::vector<Semaphore> image_available, render_finished;
+		std::array<Timing, max_frames_in_flight> timings;
+
+		Settings settings, pending_settings;
+		bool settings_changed = false;
+
+		uint32_t current_frame = 0;
+		uint32_t last_frame = 0;
+		uint32_t image_index = 0;
+
+		// Serials of frames, in submission order
+		uint64_t submitted_frames = 0, completed_frames = 0;
+		std::deque<Retired> retired;
+
+		Clock::time_point frame_start, last_completed;
+		double gpu_time = 0.0, cpu_time = 0.0, pacing_delay = 0.0;
+	};
+
+}
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "frame_scheduler.h"
+
+#include "device.h"
+#include "util/profiler.h"
+
+#include <iterator>
+
+namespace ovk {
+
+	FrameScheduler::FrameScheduler(Device& device, uint32_t frames_in_flight) : device(device), semaphores(frames_in_flight) {}
+
+	void FrameScheduler::begin_frame(uint32_t frame) {
+		ovk_asserts(frame < semaphores.size(), "[FrameScheduler] (begin_frame) frame {} out of range", frame);
+		ovk_asserts(items.empty(), "[FrameScheduler] (begin_frame) the last frame was never submitted");
+		current_frame = frame;
+	}
+
+	FrameScheduler::WorkId FrameScheduler::add(WorkItem item) {
+		const auto id = static_cast<WorkId>(items.size());
+		for (const auto& dependency : item.dependencies)
+			ovk_asserts(dependency.work < id, "[FrameScheduler] (add) work {} depends on {}, which was not added before", id, dependency.work);
+
+		items.push_back(std::move(item));
+		return id;
+	}
+
+	void FrameScheduler::submit(vk::Fence fence) {
+		OVK_PROFILE_SCOPE("FrameScheduler::submit");
+
+		if (items.empty()) {
+			if (fence) device.submit(QueueType::graphics, {}, {}, {}, fence);
+			return;
+		}
+
+		const auto last_queue = device.get_queue(items.back().queue);
+
+		// The fence only covers its own queue, so items on other queues nobody waits for are joined into the last submit
+		std::vector<bool> has_dependents(items.size());
+		for (const auto& item : items)
+			for (const auto& dependency : item.dependencies)
+				has_dependents[dependency.work] = true;
+
+		std::vector<WorkId> joins;
+		for (WorkId i = 0; i < items.size(); i++)
+			if (!has_dependents[i] && device.get_queue(items[i].queue) != last_queue)
+				joins.push_back(i);
+
+		size_t edge_count = joins.size();
+		for (const auto& item : items)
+			edge_count += item.dependencies.size();
+
+		auto& frame_semaphores = semaphores[current_frame];
+		if (frame_semaphores.size() < edge_count) {
+			auto more = device.create_semaphores(static_cast<uint32_t>(edge_count - frame_semaphores.size()));
+			std::move(more.begin(), more.end(), std::back_inserter(frame_semaphores));
+		}
+
+		struct Sync {
+			std::vector<vk::Semaphore> wait;
+			std::vector<vk::PipelineStageFlags> wait_stages;
+			std::vector<vk::Semaphore> signal;
+		};
+
+		std::vector<Sync> syncs(items.size());
+		size_t edge = 0;
+		for (WorkId i = 0; i < items.size(); i++) {
+			for (const auto& wait : items[i].wait_semaphores) {
+				syncs[i].wait.push_back(wait.semaphore);
+				syncs[i].wait_stages.push_back(wait.stage);
+			}
+			syncs[i].signal = items[i].signal_semaphores;
+
+			for (const auto& dependency : items[i].dependencies) {
+				const auto semaphore = frame_semaphores[edge++].handle.get();
+				syncs[dependency.work].signal.push_back(semaphore);
+				syncs[i].wait.push_back(semaphore);
+				syncs[i].wait_stages.push_back(dependency.stages);
+			}
+		}
+
+		Sync join;
+		for (const auto i : joins) {
+			const auto semaphore = frame_semaphores[edge++].handle.get();
+			syncs[i].signal.push_back(semaphore);
+			join.wait.push_back(semaphore);
+			join.wait_stages.push_back(vk::PipelineStageFlagBits::eAllCommands);
+		}
+
+		// Every signal is submitted before its wait, because dependencies only point to earlier items
+		std::vector<vk::SubmitInfo> batch;
+		for (WorkId i = 0; i < items.size(); i++) {
+			const auto& sync = syncs[i];
+			batch.push_back(vk::SubmitInfo{
+				static_cast<uint32_t>(sync.wait.size()), sync.wait.data(), sync.wait_stages.data(),
+				static_cast<uint32_t>(items[i].cmds.size()), items[i].cmds.data(),
+				static_cast<uint32_t>(sync.signal.size()), sync.signal.data()
+			});
+
+			const auto queue = device.get_queue(items[i].queue);
+			const bool last = i + 1 == items.size();
+			if (!last && device.get_queue(items[i + 1].queue) == queue)
+				continue;
+
+			const auto batch_fence = last && joins.empty() ? fence : vk::Fence{};
+			VK_ASSERT(queue.submit(static_cast<uint32_t>(batch.size()), batch.data(), batch_fence), "[FrameScheduler] (submit) failed to submit work");
+			batch.clear();
+		}
+
+		if (!joins.empty()) {
+			const vk::SubmitInfo join_info{
+				static_cast<uint32_t>(join.wait.size()), join.wait.data(), join.wait_stages.data(),
+				0, nullptr,
+				0, nullptr
+			};
+			VK_ASSERT(last_queue.submit(1, &join_info, fence), "[FrameScheduler] (submit) failed to submit the join of the frame");
+		}
+
+		items.clear();
+	}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "handle.h"
+
+#include "sync.h"
+
+namespace ovk {
+	class Device;
+	enum class QueueType;
+
+	/**
+	 * \brief Submits the work of one frame to the graphics, async_compute and transfer queues
+	 *				Work items are added in submission order and name the earlier items they depend on, the scheduler connects
+	 *				them with semaphores. So a compute item (eg. culling or terrain generation) that only depends on its upload
+	 *				runs on the async_compute queue alongside the shadow and main passes and only the pass that consumes its
+	 *				result waits for it. Consecutive items of one queue share a vkQueueSubmit.
+	 *				Resources used by more than one queue family have to be created for all of them (concurrent sharing, eg.
+	 *				create_buffer(..., { QueueType::graphics, QueueType::async_compute }, ...)), there are no ownership transfers.
+	 *				Without a dedicated compute family (see Device::has_async_compute) everything works the same, just without overlap
+	 */
+	class OVK_API FrameScheduler {
+	public:
+		using WorkId = uint32_t;
+
+		struct Dependency {
+			WorkId work;
+			// Stages of the dependent item that have to wait (eg. eDrawIndirect for a culling result)
+			vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eAllCommands;
+		};
+
+		struct WorkItem {
+			QueueType queue;
+			// Allocated from the pool of queue
+			std::vector<vk::CommandBuffer> cmds;
+			std::vector<Dependency> dependencies;
+			// Semaphores from outside the scheduler (eg. image available and render finished of the swapchain)
+			std::vector<WaitInfo> wait_semaphores;
+			std::vector<vk::Semaphore> signal_semaphores;
+		};
+
+		FrameScheduler(Device& device, uint32_t frames_in_flight);
+
+		FrameScheduler(const FrameScheduler& other) = delete;
+		FrameScheduler& operator=(const FrameScheduler& other) = delete;
+
+		// Starts collecting the work of a frame, the last submit of this frame slot has to be finished (eg. its fence waited on)
+		void begin_frame(uint32_t frame);
+
+		// Dependencies can only name items of the same frame that were added before
+		WorkId add(WorkItem item);
+
+		// Submits everything added since begin_frame, fence is signaled once all items (on all queues) are done
+		void submit(vk::Fence fence = {});
+
+	private:
+		Device& device;
+		uint32_t current_frame = 0;
+		std::vector<WorkItem> items;
+		// One semaphore per dependency edge of a frame slot, more are created when a frame needs them
+		std::vector<std::vector<Semaphore>> semaphores;
+	};
+
+}
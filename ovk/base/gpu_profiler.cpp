@@ -0,0 +1,365 @@
+#include "pch.h"
+#include "gpu_profiler.h"
+
+#include "device.h"
+#include "render_command.h"
+
+#include <imgui.h>
+#include <fstream>
+#include <functional>
+
+namespace ovk {
+
+	constexpr auto skipped_region = std::numeric_limits<uint32_t>::max();
+
+	// Results are written in the order of the flag bits
+	constexpr auto statistic_flags =
+		vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+		vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+		vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+	constexpr auto statistic_count = 3;
+
+	GpuProfiler::Statistics& GpuProfiler::Statistics::operator+=(const Statistics &other) {
+		vertex_invocations += other.vertex_invocations;
+		clipping_primitives += other.clipping_primitives;
+		fragment_invocations += other.fragment_invocations;
+		samples_passed += other.samples_passed;
+		return *this;
+	}
+
+	GpuProfiler::GpuProfiler(uint32_t frames_in_flight, uint32_t max_regions, Device &d)
+		: device(d.device.get()), max_queries(2 * (max_regions + 1)), max_segments(4 * (max_regions + 1)) {
+
+		const auto properties = d.physical_device.getProperties();
+		const auto families = d.physical_device.getQueueFamilyProperties();
+		const auto valid_bits = families[d.families.graphics.value()].timestampValidBits;
+
+		timestamp_period = properties.limits.timestampPeriod;
+		timestamp_mask = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << valid_bits) - 1;
+
+		if (valid_bits == 0) {
+			spdlog::warn("[GpuProfiler] (constructor) graphics queue does not support timestamps, profiling is disabled");
+			enabled = false;
+			return;
+		}
+
+		statistics_enabled = d.enabled_features.pipelineStatisticsQuery;
+		// Without precise occlusion queries the results would only tell us if any sample passed
+		occlusion_enabled = statistics_enabled && d.enabled_features.occlusionQueryPrecise;
+
+		auto create_pool = [&](vk::QueryType type, uint32_t count, vk::QueryPipelineStatisticFlags flags = {}) {
+			vk::QueryPoolCreateInfo create_info{ {}, type, count, flags };
+			return UniqueHandle<vk::QueryPool>(
+				VK_CREATE(device.createQueryPool(create_info), "[GpuProfiler] Failed to create Query Pool"),
+				ObjectDestroy<vk::QueryPool>(device));
+		};
+
+		frames.reserve(frames_in_flight);
+		for (uint32_t i = 0; i < frames_in_flight; i++) {
+			Frame frame{ create_pool(vk::QueryType::eTimestamp, max_queries) };
+			if (statistics_enabled) frame.statistics = create_pool(vk::QueryType::ePipelineStatistics, max_segments, statistic_flags);
+			if (occlusion_enabled) frame.occlusion = create_pool(vk::QueryType::eOcclusion, max_segments);
+			frames.push_back(std::move(frame));
+		}
+	}
+
+	void GpuProfiler::begin_frame(RenderCommand &cmd, uint32_t frame) {
+		if (!enabled) return;
+		ovk_asserts(frame < frames.size(), "[GpuProfiler] (begin_frame) frame index {} out of range", frame);
+		ovk_asserts(stack.empty(), "[GpuProfiler] (begin_frame) previous frame has unbalanced regions");
+
+		resolve(frame);
+
+		current_frame = frame;
+		auto &f = frames[frame];
+		f.regions.clear();
+		f.segments.clear();
+		f.query_count = 0;
+		f.pending = true;
+
+		cmd.cmd_handle.resetQueryPool(f.timestamps.get(), 0, max_queries);
+		if (f.statistics) cmd.cmd_handle.resetQueryPool(f.statistics->get(), 0, max_segments);
+		if (f.occlusion) cmd.cmd_handle.resetQueryPool(f.occlusion->get(), 0, max_segments);
+		cmd.profiler = this;
+
+		begin_region(cmd.cmd_handle, "Frame", glm::vec4(1.0f));
+	}
+
+	void GpuProfiler::end_frame(RenderCommand &cmd) {
+		if (!enabled) return;
+		end_region(cmd.cmd_handle);
+
+		ovk_asserts(stack.empty(), "[GpuProfiler] (end_frame) {} region(s) were not closed", stack.size());
+		stack.clear();
+		suspend_statistics(cmd.cmd_handle);
+		cmd.profiler = nullptr;
+	}
+
+	bool GpuProfiler::is_enabled() const {
+		return enabled;
+	}
+
+	bool GpuProfiler::has_statistics() const {
+		return statistics_enabled;
+	}
+
+	bool GpuProfiler::has_occlusion() const {
+		return occlusion_enabled;
+	}
+
+	const std::vector<GpuProfiler::Region>& GpuProfiler::get_results() const {
+		return results;
+	}
+
+	double GpuProfiler::get_frame_ms() const {
+		// The first region is always the whole frame
+		return results.empty() ? 0.0 : results[0].ms;
+	}
+
+	void GpuProfiler::begin_region(vk::CommandBuffer cmd, const std::string &name, glm::vec4 color) {
+		suspend_statistics(cmd);
+
+		auto &f = frames[current_frame];
+		if (f.query_count + 2 > max_queries) {
+			stack.push_back(skipped_region);
+			resume_statistics(cmd);
+			return;
+		}
+
+		// Bottom of pipe for begin and end, so that the region does not include work that was still in flight
+		cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, f.timestamps.get(), f.query_count);
+
+		// Skipped regions are transparent, so the parent is the innermost region we actually record
+		auto parent = skipped_region;
+		for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+			if (*it != skipped_region) { parent = *it; break; }
+		}
+
+		stack.push_back(static_cast<uint32_t>(f.regions.size()));
+		f.regions.push_back(Region{ name, color, static_cast<uint32_t>(stack.size() - 1), parent, 0.0, {}, f.query_count, 0 });
+		f.query_count += 2;
+
+		resume_statistics(cmd);
+	}
+
+	void GpuProfiler::end_region(vk::CommandBuffer cmd) {
+		if (stack.empty()) {
+			spdlog::error("[GpuProfiler] (end_region) no region is open");
+			return;
+		}
+		suspend_statistics(cmd);
+
+		const auto index = stack.back();
+		stack.pop_back();
+		if (index != skipped_region) {
+			auto &f = frames[current_frame];
+			auto &region = f.regions[index];
+			region.end_query = region.begin_query + 1;
+			cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, f.timestamps.get(), region.end_query);
+		}
+
+		resume_statistics(cmd);
+	}
+
+	void GpuProfiler::suspend_statistics(vk::CommandBuffer cmd) {
+		if (!segment_active) return;
+		segment_active = false;
+
+		auto &f = frames[current_frame];
+		const auto query = static_cast<uint32_t>(f.segments.size() - 1);
+		cmd.endQuery(f.statistics->get(), query);
+		if (f.occlusion) cmd.endQuery(f.occlusion->get(), query);
+	}
+
+	void GpuProfiler::resume_statistics(vk::CommandBuffer cmd) {
+		if (!statistics_enabled || segment_active || stack.empty()) return;
+
+		auto &f = frames[current_frame];
+		if (f.segments.size() >= max_segments) return;
+
+		auto region = skipped_region;
+		for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+			if (*it != skipped_region) { region = *it; break; }
+		}
+		if (region == skipped_region) return;
+
+		const auto query = static_cast<uint32_t>(f.segments.size());
+		cmd.beginQuery(f.statistics->get(), query, {});
+		if (f.occlusion) cmd.beginQuery(f.occlusion->get(), query, vk::QueryControlFlagBits::ePrecise);
+
+		f.segments.push_back(region);
+		segment_active = true;
+	}
+
+	void GpuProfiler::resolve(uint32_t frame) {
+		auto &f = frames[frame];
+		if (!f.pending || f.query_count == 0) return;
+		f.pending = false;
+
+		std::vector<uint64_t> timestamps(f.query_count);
+		const auto result = device.getQueryPoolResults(
+			f.timestamps.get(), 0, f.query_count,
+			timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64);
+
+		// eNotReady would mean the frame was never submitted, just drop it
+		if (result != vk::Result::eSuccess) return;
+
+		for (auto &region : f.regions) {
+			const auto begin = timestamps[region.begin_query] & timestamp_mask;
+			const auto end = timestamps[region.end_query] & timestamp_mask;
+			region.ms = static_cast<double>((end - begin) & timestamp_mask) * timestamp_period / 1e6;
+			region.statistics = {};
+		}
+
+		if (!f.segments.empty()) {
+			const auto segment_count = static_cast<uint32_t>(f.segments.size());
+
+			std::vector<uint64_t> statistics(segment_count * statistic_count);
+			VK_ASSERT(device.getQueryPoolResults(
+				f.statistics->get(), 0, segment_count,
+				statistics.size() * sizeof(uint64_t), statistics.data(), statistic_count * sizeof(uint64_t),
+				vk::QueryResultFlagBits::e64), "[GpuProfiler] (resolve) Failed to get pipeline statistics");
+
+			std::vector<uint64_t> samples;
+			if (f.occlusion) {
+				samples.resize(segment_count);
+				VK_ASSERT(device.getQueryPoolResults(
+					f.occlusion->get(), 0, segment_count,
+					samples.size() * sizeof(uint64_t), samples.data(), sizeof(uint64_t),
+					vk::QueryResultFlagBits::e64), "[GpuProfiler] (resolve) Failed to get occlusion results");
+			}
+
+			for (uint32_t i = 0; i < segment_count; i++) {
+				auto &s = f.regions[f.segments[i]].statistics;
+				s.vertex_invocations += statistics[i * statistic_count + 0];
+				s.clipping_primitives += statistics[i * statistic_count + 1];
+				s.fragment_invocations += statistics[i * statistic_count + 2];
+				if (!samples.empty()) s.samples_passed += samples[i];
+			}
+
+			// Children are always recorded after their parent, so walking backwards
+			// every region is complete before it gets added to its parent
+			for (auto it = f.regions.rbegin(); it != f.regions.rend(); ++it) {
+				if (it->parent != skipped_region) f.regions[it->parent].statistics += it->statistics;
+			}
+		}
+
+		results = f.regions;
+	}
+
+	void GpuProfiler::debug_draw() {
+#ifdef OVK_IMGUI_UTILS
+		ImGui::Begin("GPU Profiler");
+
+		if (!enabled) {
+			ImGui::Text("Timestamps are not supported on the graphics queue");
+			ImGui::End();
+			return;
+		}
+
+		ImGui::Text("GPU frame: %.3f ms", get_frame_ms());
+		if (ImGui::Button("Export JSON")) export_json("gpu_profile.json");
+		ImGui::Separator();
+
+		// Regions are stored in recording order, so children directly follow their parent
+		std::function<size_t(size_t)> draw_node = [&](size_t i) -> size_t {
+			const auto &region = results[i];
+			const auto has_children = i + 1 < results.size() && results[i + 1].depth > region.depth;
+
+			ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
+			if (!has_children) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+			ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(region.color.r, region.color.g, region.color.b, 1.0f));
+			const auto open = ImGui::TreeNodeEx(reinterpret_cast<void*>(i), flags, "%s: %.3f ms", region.name.c_str(), region.ms);
+			ImGui::PopStyleColor();
+
+			if (statistics_enabled && ImGui::IsItemHovered()) {
+				const auto &s = region.statistics;
+				ImGui::BeginTooltip();
+				ImGui::Text("vertex invocations:   %llu", s.vertex_invocations);
+				ImGui::Text("clipping primitives:  %llu", s.clipping_primitives);
+				ImGui::Text("fragment invocations: %llu", s.fragment_invocations);
+				if (occlusion_enabled) {
+					ImGui::Text("samples passed:       %llu", s.samples_passed);
+					// Fragments shaded per sample that ended up passing the depth test
+					if (s.samples_passed > 0) ImGui::Text("overdraw:             %.2f", static_cast<double>(s.fragment_invocations) / s.samples_passed);
+				}
+				ImGui::EndTooltip();
+			}
+
+			auto next = i + 1;
+			if (has_children) {
+				while (next < results.size() && results[next].depth > region.depth) {
+					if (open) next = draw_node(next);
+					else next++;
+				}
+				if (open) ImGui::TreePop();
+			}
+			return next;
+		};
+
+		for (size_t i = 0; i < results.size();) i = draw_node(i);
+
+		ImGui::End();
+#endif
+	}
+
+	static std::string escape_json(const std::string& s) {
+		std::string out;
+		out.reserve(s.size());
+		for (auto c : s) {
+			if (c == '"' || c == '\\') out.push_back('\\');
+			out.push_back(c);
+		}
+		return out;
+	}
+
+	std::string GpuProfiler::to_json() const {
+		std::string out;
+
+		std::function<size_t(size_t)> write_node = [&](size_t i) -> size_t {
+			const auto &region = results[i];
+			out += fmt::format(R"({{"name":"{}","ms":{:.6f},)", escape_json(region.name), region.ms);
+			if (statistics_enabled) {
+				const auto &s = region.statistics;
+				out += fmt::format(R"("vertex_invocations":{},"clipping_primitives":{},"fragment_invocations":{},)",
+					s.vertex_invocations, s.clipping_primitives, s.fragment_invocations);
+				if (occlusion_enabled) out += fmt::format(R"("samples_passed":{},)", s.samples_passed);
+			}
+			out += R"("children":[)";
+
+			auto next = i + 1;
+			auto first = true;
+			while (next < results.size() && results[next].depth > region.depth) {
+				if (!first) out += ",";
+				first = false;
+				next = write_node(next);
+			}
+
+			out += "]}";
+			return next;
+		};
+
+		out += fmt::format(R"({{"frame_ms":{:.6f},"regions":[)", get_frame_ms());
+		for (size_t i = 0; i < results.size();) {
+			if (i > 0) out += ",";
+			i = write_node(i);
+		}
+		out += "]}";
+
+		return out;
+	}
+
+	bool GpuProfiler::export_json(const std::string &path) const {
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			spdlog::error("[GpuProfiler] (export_json) failed to open {}", path);
+			return false;
+		}
+		file << to_json();
+		spdlog::info("[GpuProfiler] (export_json) wrote {}", path);
+		return true;
+	}
+
+}
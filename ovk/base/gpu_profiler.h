@@ -0,0 +1,109 @@
+#pragma once
+
+#include "handle.h"
+
+namespace ovk {
+	class Device;
+	class RenderCommand;
+
+	/**
+	 * \brief Measures GPU time of the regions that are recorded with RenderCommand::begin_region/end_region
+	 *				Every frame in flight has its own timestamp query pool, results of a frame are read back
+	 *				the next time that frame slot is recorded (eg. after its fence has been waited on)
+	 *
+	 *				If the device was created with pipelineStatisticsQuery (and occlusionQueryPrecise) we also count
+	 *				shader invocations (and passed samples) per region. Queries of one type can not be nested, so the
+	 *				command buffer is cut into segments at every region and render pass boundary, each segment is
+	 *				attributed to the innermost open region and parents accumulate the counts of their children
+	 */
+	class OVK_API GpuProfiler {
+	public:
+
+		struct Statistics {
+			uint64_t vertex_invocations = 0;
+			uint64_t clipping_primitives = 0;
+			uint64_t fragment_invocations = 0;
+			uint64_t samples_passed = 0;
+
+			Statistics& operator+=(const Statistics& other);
+		};
+
+		struct Region {
+			std::string name;
+			glm::vec4 color;
+			uint32_t depth;
+			uint32_t parent;
+			double ms = 0.0;
+			// Includes the statistics of all child regions
+			Statistics statistics;
+
+			// Indices into the timestamp query pool of the frame
+			uint32_t begin_query, end_query;
+		};
+
+		GpuProfiler(GpuProfiler&& other) noexcept = default;
+		GpuProfiler(const GpuProfiler& other) = delete;
+		GpuProfiler& operator=(GpuProfiler&& other) noexcept = default;
+		GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+		// Must be called outside of a render pass, before any region is recorded into cmd
+		// The fence of frame must already be signaled, since we read back the results of its last use here
+		void begin_frame(RenderCommand& cmd, uint32_t frame);
+		void end_frame(RenderCommand& cmd);
+
+		[[nodiscard]] bool is_enabled() const;
+		[[nodiscard]] bool has_statistics() const;
+		[[nodiscard]] bool has_occlusion() const;
+
+		// Resolved regions of the latest finished frame (in recording order, depth describes the nesting)
+		[[nodiscard]] const std::vector<Region>& get_results() const;
+		[[nodiscard]] double get_frame_ms() const;
+
+		void debug_draw();
+
+		[[nodiscard]] std::string to_json() const;
+		bool export_json(const std::string& path) const;
+
+	private:
+		friend Device;
+		friend RenderCommand;
+		GpuProfiler(uint32_t frames_in_flight, uint32_t max_regions, Device& device);
+
+		void begin_region(vk::CommandBuffer cmd, const std::string& name, glm::vec4 color);
+		void end_region(vk::CommandBuffer cmd);
+
+		// Statistic queries must begin and end in the same subpass (or both outside of a render pass)
+		// so RenderCommand calls these around begin_render_pass and end_render_pass
+		void suspend_statistics(vk::CommandBuffer cmd);
+		void resume_statistics(vk::CommandBuffer cmd);
+
+		void resolve(uint32_t frame);
+
+		struct Frame {
+			UniqueHandle<vk::QueryPool> timestamps;
+			std::optional<UniqueHandle<vk::QueryPool>> statistics, occlusion;
+			std::vector<Region> regions;
+			// Region index of every statistics segment
+			std::vector<uint32_t> segments;
+			uint32_t query_count = 0;
+			bool pending = false;
+		};
+
+		vk::Device device;
+		std::vector<Frame> frames;
+
+		uint32_t current_frame = 0;
+		uint32_t max_queries, max_segments;
+		// Indices into Frame::regions (or skipped_region if we ran out of queries)
+		std::vector<uint32_t> stack;
+		bool segment_active = false;
+
+		bool enabled = true;
+		bool statistics_enabled = false, occlusion_enabled = false;
+		float timestamp_period;
+		uint64_t timestamp_mask;
+
+		std::vector<Region> results;
+	};
+
+}
@@ -34,7 +34,8 @@ namespace ovk {
 			1,
 			vk::SampleCountFlagBits::e1,  // TODO: Multisampling
 			tiling,
-			flags | vk::ImageUsageFlagBits::eTransferDst,
+			// Transient attachments can only be used as attachments
+			(flags & vk::ImageUsageFlagBits::eTransientAttachment) ? flags : flags | vk::ImageUsageFlagBits::eTransferDst,
 			vk::SharingMode::eExclusive,  // NOTE: MMMMMMM not like in any possible case (eg. Image ressource between async_compute and graphics)
 			0,											// TODO: JAJAJA du weit doch schonnnnn
 			nullptr,
@@ -179,17 +180,73 @@ namespace ovk {
 		return std::move(image);
 	}
 
+	// Stages that may access an image in a layout and how
+	static std::pair<vk::PipelineStageFlags, vk::AccessFlags> layout_scope(vk::ImageLayout layout) {
+		using stage = vk::PipelineStageFlagBits;
+		using access = vk::AccessFlagBits;
+		switch (layout) {
+		case vk::ImageLayout::eUndefined:
+		case vk::ImageLayout::ePreinitialized:
+			return { stage::eTopOfPipe, {} };
+		case vk::ImageLayout::eColorAttachmentOptimal:
+			return { stage::eColorAttachmentOutput, access::eColorAttachmentRead | access::eColorAttachmentWrite };
+		case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+			return { stage::eEarlyFragmentTests | stage::eLateFragmentTests, access::eDepthStencilAttachmentRead | access::eDepthStencilAttachmentWrite };
+		case vk::ImageLayout::eDepthStencilReadOnlyOptimal:
+			return { stage::eEarlyFragmentTests | stage::eLateFragmentTests | stage::eFragmentShader, access::eDepthStencilAttachmentRead | access::eShaderRead };
+		case vk::ImageLayout::eShaderReadOnlyOptimal:
+			return { stage::eVertexShader | stage::eFragmentShader | stage::eComputeShader, access::eShaderRead };
+		case vk::ImageLayout::eTransferSrcOptimal:
+			return { stage::eTransfer, access::eTransferRead };
+		case vk::ImageLayout::eTransferDstOptimal:
+			return { stage::eTransfer, access::eTransferWrite };
+		case vk::ImageLayout::ePresentSrcKHR:
+			return { stage::eBottomOfPipe, {} };
+		default:
+			// eGeneral and everything we do not know in detail
+			return { stage::eAllCommands, access::eMemoryRead | access::eMemoryWrite };
+		}
+	}
+
+	bool is_depth_format(vk::Format format) {
+		switch (format) {
+		case vk::Format::eD16Unorm:
+		case vk::Format::eX8D24UnormPack32:
+		case vk::Format::eD32Sfloat:
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	bool has_stencil_component(vk::Format format) {
+		switch (format) {
+		case vk::Format::eD16UnormS8Uint:
+		case vk::Format::eD24UnormS8Uint:
+		case vk::Format::eD32SfloatS8Uint:
+			return true;
+		default:
+			return false;
+		}
+	}
+
 	void Image::transition_layout(vk::CommandBuffer cmd, vk::ImageLayout new_layout, QueueType queue_type, Device& device) {
 		/*const auto cmd = device.create_single_submit_cmd(queue_type, true);*/
 
-		// Are we a depth format???
-		vk::ImageAspectFlags aspect_flag = vk::ImageAspectFlagBits::eColor;			
-		if (format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint || format == vk::Format::eD32Sfloat) {
-			aspect_flag = vk::ImageAspectFlagBits::eDepth;
-		}
-		
-		vk::ImageMemoryBarrier barrier{
-			{}, {},
+		const vk::ImageAspectFlags aspect_flag = is_depth_format(format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+
+		const auto [src_stage, src_access] = layout_scope(layout);
+		const auto [dst_stage, dst_access] = layout_scope(new_layout);
+
+		// Only writes have to be made available
+		const vk::AccessFlags write_access = vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+			| vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eMemoryWrite;
+
+		const vk::ImageMemoryBarrier barrier{
+			src_access & write_access, dst_access,
 			layout,
 			new_layout,
 			VK_QUEUE_FAMILY_IGNORED,
@@ -202,37 +259,6 @@ namespace ovk {
 			}
 		};
 
-		vk::PipelineStageFlags src_stage, dst_stage;
-
-		if (layout == vk::ImageLayout::eUndefined && (new_layout == vk::ImageLayout::eTransferDstOptimal || new_layout == vk::ImageLayout::eTransferSrcOptimal)) {
-			src_stage = vk::PipelineStageFlagBits::eTopOfPipe;
-			barrier.srcAccessMask = {};
-
-			dst_stage = vk::PipelineStageFlagBits::eTransfer;
-			barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-		} else if (layout == vk::ImageLayout::eColorAttachmentOptimal && new_layout == vk::ImageLayout::eTransferSrcOptimal) {
-			src_stage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-			barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
-
-			dst_stage = vk::PipelineStageFlagBits::eTransfer;
-			barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
-		} else if (layout == vk::ImageLayout::eTransferDstOptimal && new_layout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-			src_stage = vk::PipelineStageFlagBits::eTransfer;
-			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
-
-			dst_stage = vk::PipelineStageFlagBits::eFragmentShader;
-			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-		} else if (layout == vk::ImageLayout::eDepthStencilAttachmentOptimal && new_layout == vk::ImageLayout::eShaderReadOnlyOptimal) {
-			src_stage = vk::PipelineStageFlagBits::eLateFragmentTests;
-			barrier.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
-			
-			dst_stage = vk::PipelineStageFlagBits::eFragmentShader;
-			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
-		} else {
-			// PANIC!!!
-			panic("unknown layout transition: {} -> {}", vk::to_string(layout), to_string(new_layout));
-		}
-
 		cmd.pipelineBarrier(
 			src_stage, dst_stage,
 			{},
@@ -251,6 +277,16 @@ namespace ovk {
 		layout = l;
 	}
 
+	bool Image::covers(vk::Extent2D e) const {
+		return extent.width >= e.width && extent.height >= e.height;
+	}
+
+	vk::Extent3D attachment_extent(vk::Extent2D extent) {
+		constexpr uint32_t step = 256;
+		const auto round_up = [](uint32_t v) { return (v + step - 1) / step * step; };
+		return vk::Extent3D(round_up(extent.width), round_up(extent.height), 1);
+	}
+
 	ImageView::ImageView(vk::ImageView handle, vk::Device device) : DeviceObject(device, handle) {}
 
 	vk::ComponentSwizzle parse(char a) {
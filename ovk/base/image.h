@@ -6,6 +6,15 @@
 namespace ovk {
 	enum class QueueType;
 
+	OVK_API bool is_depth_format(vk::Format format);
+	// Combined depth stencil formats, barriers on them have to name both aspects
+	OVK_API bool has_stencil_component(vk::Format format);
+
+	// Size to allocate a render target for extent with, rounded up to multiples of 256 so a resize drag does not reallocate
+	// on every step. Framebuffers may be smaller than their attachments, so a target is only recreated if it does not
+	// cover the new extent (see Image::covers) and shrinking keeps the existing allocation
+	OVK_API vk::Extent3D attachment_extent(vk::Extent2D extent);
+
 	class OVK_API Image : public DeviceObject<vk::Image> {
 		friend class Device;
 
@@ -18,11 +27,15 @@ namespace ovk {
 		static Image from_raw_data_2d(vk::Format data, uint8_t* pixels, int channels, vk::Extent3D extent, vk::ImageUsageFlags image_usage, mem::Allocator* allocator, Device& d);
 
 	public:
+		// Stage and access masks are derived from the old and new layout, so any transition works
 		void transition_layout(vk::CommandBuffer cmd, vk::ImageLayout new_layout, QueueType queue_type, Device& device);
 
 		// This should only be used if the image layout was changed externally (eg. from a subpass)
 		// TODO: Maybe make supbasses notify the image somehow
 		void set_layout(vk::ImageLayout l);
+
+		// True if a framebuffer of extent fits into the image
+		[[nodiscard]] bool covers(vk::Extent2D extent) const;
 		
 		std::shared_ptr<mem::View> memory;
 		vk::Format format;
@@ -81,12 +81,13 @@ namespace ovk {
 #endif
 	}
 
-	std::vector<const char*> get_extensions(bool add_debug_extension) {
-		uint32_t glfw_extension_count = 0;
-		const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
-
-		std::vector<const char*> extensions(glfw_extensions,
-			glfw_extensions + glfw_extension_count);
+	std::vector<const char*> get_extensions(bool add_debug_extension, bool headless) {
+		std::vector<const char*> extensions;
+		if (!headless) {
+			uint32_t glfw_extension_count = 0;
+			const char** glfw_extensions = glfwGetRequiredInstanceExtensions(&glfw_extension_count);
+			extensions.assign(glfw_extensions, glfw_extensions + glfw_extension_count);
+		}
 		if (add_debug_extension)
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -94,7 +95,18 @@ namespace ovk {
 	}
 
 	Instance::Instance(AppInfo app_info, std::vector<std::string>&& additional_extensions, bool add_validation)
-		: instance(vk::Instance(), {})
+		: Instance(std::move(app_info), std::move(additional_extensions), add_validation, false) {}
+
+	Instance Instance::create_headless(AppInfo app_info, std::vector<std::string>&& additional_extensions) {
+#ifdef DEBUG
+		return Instance(std::move(app_info), std::move(additional_extensions), true, true);
+#else
+		return Instance(std::move(app_info), std::move(additional_extensions), false, true);
+#endif
+	}
+
+	Instance::Instance(AppInfo app_info, std::vector<std::string>&& additional_extensions, bool add_validation, bool headless)
+		: headless(headless), instance(vk::Instance(), {})
 	{
 		// TODO: Move that somewhere else but honestly its okay here
 		// auto console = spdlog::default_factory::create<spdlog::sinks::ansicolor_stdout_sink_mt>("console");
@@ -105,7 +117,7 @@ namespace ovk {
 		rang::setWinTermMode(rang::winTerm::Ansi);
 
 		
-		if (!glfwInit())
+		if (!headless && !glfwInit())
 			spdlog::error("failed to initialize glfw!");
 
 
@@ -140,7 +152,7 @@ namespace ovk {
 
 #endif
 
-		auto extensions = get_extensions(add_validation);
+		auto extensions = get_extensions(add_validation, headless);
 
 		for (auto&& additional : additional_extensions)
 			extensions.push_back(additional.c_str());
@@ -177,11 +189,22 @@ namespace ovk {
 	}
 
 	Surface Instance::create_surface(int width, int height, std::string title, bool init_events) {
+		ovk_asserts(!headless, "[Instance] (create_surface) headless instances have no window system");
 		return Surface(width, height, title, init_events, &instance.get());
 	}
 
 	Device Instance::create_device(std::vector<const char *> &&requested_extensions, vk::PhysicalDeviceFeatures features, Surface &s) {
-		return Device(std::move(requested_extensions), features, s, &instance.get());
+		return Device(std::move(requested_extensions), features, &s, &instance.get());
+	}
+
+	Device Instance::create_device(std::vector<const char *> &&requested_extensions, vk::PhysicalDeviceFeatures features) {
+		return Device(std::move(requested_extensions), features, nullptr, &instance.get());
+	}
+
+	bool Instance::is_headless() const { return headless; }
+
+	std::vector<vk::PhysicalDevice> Instance::get_physical_devices() const {
+		return VK_DCREATE(instance->enumeratePhysicalDevices(), "[Instance] (get_physical_devices) failed to enumerate physical devices");
 	}
 
 #ifdef DEBUG	
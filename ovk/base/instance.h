@@ -31,10 +31,25 @@ namespace ovk {
 		Instance(const Instance& o) = delete;
 		Instance& operator=(const Instance& o) = delete;
 
+		// Without GLFW and surface extensions, so it runs where there is no display (eg. lavapipe on CI and benchmark machines)
+		// Devices are created without a surface and render into offscreen swapchains (Device::create_offscreen_swapchain)
+		static Instance create_headless(AppInfo app_info, std::vector<std::string>&& additional_extensions = {});
+
 		Surface create_surface(int width, int height, std::string title, bool init_events = false /* Flags?*/);
 
 		Device create_device(std::vector<const char*>&& requested_extensions, vk::PhysicalDeviceFeatures features, Surface& s);
+		// Headless device, requested_extensions should not contain the swapchain extension
+		Device create_device(std::vector<const char*>&& requested_extensions, vk::PhysicalDeviceFeatures features);
+
+		[[nodiscard]] bool is_headless() const;
+
+		// Device picks one of these, so optional features can be requested only if every candidate reports them
+		[[nodiscard]] std::vector<vk::PhysicalDevice> get_physical_devices() const;
 	private:
+		Instance(AppInfo app_info, std::vector<std::string>&& additional_extensions, bool add_validation, bool headless);
+
+		bool headless;
+
 		// Unique Handle to 
 		UniqueHandle<vk::Instance> instance;
 
@@ -69,6 +69,8 @@ namespace ovk::mem {
 			return flags::eHostVisible | flags::eHostCached;
 		case MemoryType::cpu_coherent_and_cached:
 			return flags::eHostVisible | flags::eHostCached | flags::eHostCoherent;
+		case MemoryType::lazily_allocated:
+			return flags::eDeviceLocal | flags::eLazilyAllocated;
 		default: return {};
 		}
 	}
@@ -76,11 +78,12 @@ namespace ovk::mem {
 	// ***************************************************************************************************************************
 	// Memory View Types (Dedicated and Weak view at the moment (naming might (probably) will change)
 	
-	DedicatedView::DedicatedView(UniqueHandle<vk::DeviceMemory> &&mem, vk::DeviceSize s) : memory(std::move(mem)), size(s) {}
+	DedicatedView::DedicatedView(UniqueHandle<vk::DeviceMemory> &&mem, vk::DeviceSize s, vk::DeviceSize allocation_s) : memory(std::move(mem)), size(s), allocation_size(allocation_s) {}
 
 	vk::DeviceMemory DedicatedView::get() { return memory.get(); }
 	vk::DeviceSize DedicatedView::get_offset() { return 0; }
 	vk::DeviceSize DedicatedView::get_size() { return size; }
+	vk::DeviceSize DedicatedView::get_allocation_size() { return allocation_size; }
 
 	void * DedicatedView::map(Device &device) {
 		return VK_CREATE(device.device->mapMemory(memory, 0, get_size()), "[DedicatedMemory] (map) failed to map memory");
@@ -100,7 +103,7 @@ namespace ovk::mem {
 	void DedicatedAllocator::unmap(View *view, Device &device) {
 	}
 
-	WeakView::WeakView(vk::DeviceMemory mem, vk::DeviceSize o, vk::DeviceSize s, MemoryType t, Allocator* a) : handle(mem), offset(o), size(s), type(t), allocator(a) {}
+	WeakView::WeakView(vk::DeviceMemory mem, vk::DeviceSize o, vk::DeviceSize s, vk::DeviceSize allocation_s, MemoryType t, Allocator* a) : handle(mem), offset(o), size(s), allocation_size(allocation_s), type(t), allocator(a) {}
 	WeakView::~WeakView() {
 		allocator->free(this);
 	}
@@ -108,6 +111,7 @@ namespace ovk::mem {
 	vk::DeviceMemory WeakView::get() { return handle; }
 	vk::DeviceSize WeakView::get_offset() { return offset; }
 	vk::DeviceSize WeakView::get_size() { return size; }
+	vk::DeviceSize WeakView::get_allocation_size() { return allocation_size; }
 
 	void* WeakView::map(Device& device) {
 		return allocator->map(this, device);
@@ -140,7 +144,7 @@ namespace ovk::mem {
 		UniqueHandle<vk::DeviceMemory> handle(
 			std::move(VK_CREATE(device.device->allocateMemory(alloc_info), "[DedicatedAllocator] (allocate) failed to allocate memory")), 
 			ObjectDestroy<vk::DeviceMemory>(device.device.get()));
-		return std::make_shared<DedicatedView>(std::move(handle), info.size);
+		return std::make_shared<DedicatedView>(std::move(handle), info.size, alloc_info.allocationSize);
 		
 	}
 
@@ -227,7 +231,7 @@ namespace ovk::mem {
 			return nullptr;
 		}
 
-		auto result = std::make_shared<WeakView>(memory.handle.get(), head, current_page_size, memory.mem_type, this);
+		auto result = std::make_shared<WeakView>(memory.handle.get(), head, current_page_size, memory.size, memory.mem_type, this);
 
 		layouts.emplace(Layout{ head , current_page_size, info.size });
 
@@ -341,7 +345,7 @@ namespace ovk::mem {
 			return std::make_pair(found.value(), new_block->memory->handle.get());
 		}();
 
-		return std::make_shared<WeakView>(found_place.second, found_place.first.offset, found_place.first.size, info.type, nullptr);
+		return std::make_shared<WeakView>(found_place.second, found_place.first.offset, found_place.first.size, block_size, info.type, nullptr);
 	}
 
 	void Pool::free(View *view) {
@@ -428,7 +432,8 @@ namespace ovk::mem {
 	void DefaultAllocator::add_pool(MemoryType type, Device& device) {
 
 		// TODO: Might but that somewhere else
-		const auto block_size = 500_mb;
+		// Lazily allocated blocks only hold a few transient attachments
+		const auto block_size = type == MemoryType::lazily_allocated ? 64_mb : 500_mb;
 		
 		if (pools.find(type) == pools.end()) {
 			auto [it, success] = pools.insert_or_assign(
@@ -25,7 +25,10 @@ namespace ovk::mem {
 		cpu_accessible,
 		cpu_coherent,
 		cpu_cached,
-		cpu_coherent_and_cached
+		cpu_coherent_and_cached,
+		// For transient attachments, only backed by physical memory if the attachment leaves tile memory
+		// Not every device has it (most desktop gpus do not), see Device::create_transient_attachment
+		lazily_allocated
 	};
 
 	inline const char* to_string(MemoryType e) {
@@ -35,6 +38,7 @@ namespace ovk::mem {
 		case MemoryType::cpu_coherent: return "cpu_coherent";
 		case MemoryType::cpu_cached: return "cpu_cached";
 		case MemoryType::cpu_coherent_and_cached: return "cpu_coherent_and_cached";
+		case MemoryType::lazily_allocated: return "lazily_allocated";
 		default: return "unknown";
 		}
 	}
@@ -49,6 +53,8 @@ namespace ovk::mem {
 		virtual vk::DeviceMemory get() = 0;
 		virtual vk::DeviceSize get_offset() = 0;
 		virtual vk::DeviceSize get_size() = 0;
+		// Size of the whole vk::DeviceMemory the view lives in
+		virtual vk::DeviceSize get_allocation_size() = 0;
 
 		virtual void* map(Device& device) = 0;
 		virtual void unmap(Device& device) = 0;
@@ -99,14 +105,15 @@ namespace ovk::mem {
 	// TODO: Could be replaced with Weak View and therefore we don't need polymorphism here
 	struct OVK_API DedicatedView : View {
 
-		DedicatedView(UniqueHandle<vk::DeviceMemory>&& mem, vk::DeviceSize s);
+		DedicatedView(UniqueHandle<vk::DeviceMemory>&& mem, vk::DeviceSize s, vk::DeviceSize allocation_s);
 		
 		UniqueHandle<vk::DeviceMemory> memory;
-		vk::DeviceSize size;
+		vk::DeviceSize size, allocation_size;
 		~DedicatedView() override = default;
 		vk::DeviceMemory get() override;
 		vk::DeviceSize get_offset() override;
 		vk::DeviceSize get_size() override;
+		vk::DeviceSize get_allocation_size() override;
 		void * map(Device &device) override;
 		void unmap(Device &device) override;
 	};
@@ -114,10 +121,10 @@ namespace ovk::mem {
 	
 	struct OVK_API WeakView : View {
 
-		WeakView(vk::DeviceMemory mem, vk::DeviceSize o, vk::DeviceSize s, MemoryType t, Allocator* a);
+		WeakView(vk::DeviceMemory mem, vk::DeviceSize o, vk::DeviceSize s, vk::DeviceSize allocation_s, MemoryType t, Allocator* a);
 		
 		vk::DeviceMemory handle;
-		vk::DeviceSize offset, size;
+		vk::DeviceSize offset, size, allocation_size;
 		MemoryType type;
 
 		Allocator* allocator;
@@ -126,6 +133,7 @@ namespace ovk::mem {
 		vk::DeviceMemory get() override;
 		vk::DeviceSize get_offset() override;
 		vk::DeviceSize get_size() override;
+		vk::DeviceSize get_allocation_size() override;
 		void * map(Device &device) override;
 		void unmap(Device &device) override;
 	};
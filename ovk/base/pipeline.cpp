@@ -3,7 +3,11 @@
 
 #include "device.h"
 #include "render_pass.h"
+#include "util/profiler.h"
+#include "util/thread_pool.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 
 namespace ovk {
@@ -13,6 +17,7 @@ namespace ovk {
 		std::ifstream file(filename, std::ios::ate | std::ios::binary);
 		if (!file.is_open()) {
 			spdlog::error("failed to read binary file {}: couldn't open filestream", filename);
+			return {};
 		}
 
 		const auto file_size = static_cast<size_t>(file.tellg());
@@ -29,30 +34,80 @@ namespace ovk {
 
 	}
 
-	vk::ShaderModule create_shader_module(vk::Device* device, const std::vector<char>& code) {
+	vk::ShaderModule create_shader_module(vk::Device* device, const std::vector<uint32_t>& code) {
 		vk::ShaderModuleCreateInfo create_info = {};
-		create_info.codeSize = code.size();
-		create_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+		create_info.codeSize = code.size() * sizeof(uint32_t);
+		create_info.pCode = code.data();
 
 		const auto shader_module = VK_CREATE(device->createShaderModule(create_info), "failed to create shader module");
 		
 		return shader_module;
 	}
 
+	namespace {
+		uint64_t fnv1a(const std::vector<uint8_t>& bytes) {
+			uint64_t value = 14695981039346656037ull;
+			for (const auto byte : bytes) {
+				value ^= byte;
+				value *= 1099511628211ull;
+			}
+			return value;
+		}
+
+		// Serializes the raw bytes, only feed it types without padding (vk create infos have to be split into their fields)
+		struct PipelineDescription {
+			std::vector<uint8_t> description;
+
+			void bytes(const void* data, size_t size) {
+				const auto* p = static_cast<const uint8_t*>(data);
+				description.insert(description.end(), p, p + size);
+			}
+
+			template <typename T>
+			PipelineDescription& operator<<(const T& v) {
+				static_assert(std::is_trivially_copyable_v<T>, "[PipelineDescription] T must be trivially copyable");
+				bytes(&v, sizeof(T));
+				return *this;
+			}
+
+			template <typename T>
+			PipelineDescription& operator<<(const std::vector<T>& v) {
+				*this << v.size();
+				if (!v.empty()) bytes(v.data(), v.size() * sizeof(T));
+				return *this;
+			}
+
+			PipelineDescription& operator<<(const std::string& s) {
+				*this << s.size();
+				bytes(s.data(), s.size());
+				return *this;
+			}
+		};
+	}
+
+
+	// compile: file_path is GLSL source, otherwise SPIR-V
+	static std::optional<std::vector<uint32_t>> load_shader_code(Device* device, const std::string& file_path, vk::ShaderStageFlagBits stage, bool compile) {
+		if (compile) return device->get_shader_compiler().compile_file(file_path, stage);
+
+		const auto bytes = read_file(file_path);
+		if (bytes.empty()) return std::nullopt;
+
+		// SPIR-V is a stream of 32 bit words
+		std::vector<uint32_t> code((bytes.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+		std::memcpy(code.data(), bytes.data(), bytes.size());
+		return code;
+	}
 
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_shader_stage_from_file(vk::ShaderStageFlagBits stage, std::string file_path, bool compile_shader,
 	                                                                              const std::string &entry_point) {
 		// Add to Stages Flags
 		stage_flags |= stage;
 
-		const auto code = read_file(file_path);
+		// Errors are already logged, creating the shader module will fail in build
+		auto code = load_shader_code(device, file_path, stage, compile_shader);
 
-		// Index of new Shader Module
-		const auto index = shaders.size();
-		shaders.push_back(create_shader_module(&device->device.get(), code));
-
-		const vk::PipelineShaderStageCreateInfo info { {}, stage, shaders[index], entry_point.c_str() };
-		stages.push_back(info);
+		shader_stages.push_back({ stage, code.value_or(std::vector<uint32_t>{}), entry_point, std::move(file_path), compile_shader });
 
 		return *this;
 
@@ -61,12 +116,8 @@ namespace ovk {
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_shader_stage_u32(vk::ShaderStageFlagBits stage, uint32_t *data, size_t size, const std::string &entry_point) {
 		stage_flags |= stage;
 
-		const auto index = shaders.size();
-		const auto shader_module = VK_CREATE(device->device->createShaderModule({ {}, size, data }), "Failed to create shader module from u32 source");
-		shaders.push_back(shader_module);
-
-		vk::PipelineShaderStageCreateInfo info{ {}, stage, shaders[index], entry_point.c_str() };
-		stages.push_back(info);
+		// size is in bytes (like vk::ShaderModuleCreateInfo::codeSize)
+		shader_stages.push_back({ stage, std::vector<uint32_t>(data, data + size / sizeof(uint32_t)), entry_point, "", false });
 
 		return *this;
 	}
@@ -99,7 +150,7 @@ namespace ovk {
 		return *this;
 	}
 
-	GraphicsPipelineBuilder GraphicsPipelineBuilder::set_depth_stencil(bool depth_test_enabled, bool depth_write_enabled, vk::CompareOp compare, bool depth_bounds,
+	GraphicsPipelineBuilder& GraphicsPipelineBuilder::set_depth_stencil(bool depth_test_enabled, bool depth_write_enabled, vk::CompareOp compare, bool depth_bounds,
 		glm::vec2 bounds) {
 		depth_stencil = vk::PipelineDepthStencilStateCreateInfo{
 			{},
@@ -114,11 +165,27 @@ namespace ovk {
 		return *this;
 	}
 
+	GraphicsPipelineBuilder& GraphicsPipelineBuilder::set_color_blend(uint32_t attachment_count, bool blend_enabled) {
+		ovk_asserts(!blend_attachments.empty(), "[GraphicsPipelineBuilder] (set_color_blend) default blend state missing");
+		auto blend_attachment = blend_attachments.front();
+		blend_attachment.blendEnable = blend_enabled;
+		blend_attachments.assign(attachment_count, blend_attachment);
+		return *this;
+	}
+
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_descriptor_set_layouts(std::vector<vk::DescriptorSetLayout> sets) {
 		set_layouts.insert(set_layouts.end(), sets.begin(), sets.end());
 		return *this;
 	}
 
+	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_descriptor_templates(std::vector<const DescriptorTemplate*> templates) {
+		for (const auto* t : templates) {
+			set_infos[static_cast<uint32_t>(set_layouts.size())] = t->infos;
+			set_layouts.push_back(t->handle.get());
+		}
+		return *this;
+	}
+
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_push_constant(vk::ShaderStageFlagBits stage, uint32_t size, uint32_t offset) {
 		push_constants.emplace_back(stage, offset, size);
 		return *this;
@@ -135,57 +202,247 @@ namespace ovk {
 		return *this;
 	}
 
+	GraphicsPipelineBuilder & GraphicsPipelineBuilder::set_dynamic_viewport_scissor() {
+		add_dynamic_state(vk::DynamicState::eViewport);
+		return add_dynamic_state(vk::DynamicState::eScissor);
+	}
+
+	GraphicsPipelineBuilder & GraphicsPipelineBuilder::add_dynamic_state(vk::DynamicState state) {
+		if (std::find(dynamic_states.begin(), dynamic_states.end(), state) == dynamic_states.end())
+			dynamic_states.push_back(state);
+		return *this;
+	}
+
+	GraphicsPipelineBuilder & GraphicsPipelineBuilder::use_reflection() {
+		reflection = true;
+		return *this;
+	}
+
+	// 'f' for everything the shader reads as float, 'i' and 'u' for signed and unsigned integers
+	static char numeric_class(vk::Format format) {
+		const auto name = vk::to_string(format);
+		if (name.ends_with("Sint")) return 'i';
+		if (name.ends_with("Uint")) return 'u';
+		return 'f';
+	}
+
+	// Descriptor set layouts and push constant ranges of use_reflection (shared by the graphics and compute builder)
+	static void reflect_layout(Device* device, const char* builder_name, const std::vector<ShaderReflection>& stages, const ShaderReflection& merged,
+		const std::unordered_map<uint32_t, std::vector<descriptor::Info>>& set_infos, std::vector<vk::DescriptorSetLayout>& layouts,
+		std::vector<DescriptorTemplate>& generated_templates, std::vector<vk::PushConstantRange>& ranges) {
+
+		// Descriptor Sets
+		if (layouts.empty()) {
+			for (uint32_t set = 0; set < merged.set_count(); set++) {
+				auto builder = device->build_descriptor_template();
+				for (auto& binding : merged.get_set(set)) {
+					if (binding.count == 0) spdlog::warn("[{}] (reflection) set {} binding {} ({}) is runtime sized, using one descriptor", builder_name, set, binding.binding, binding.name);
+					builder.add_binding(binding.binding, binding.type, binding.stages, std::max(binding.count, 1u));
+				}
+				generated_templates.push_back(builder.build());
+				layouts.push_back(generated_templates.back().handle.get());
+			}
+		} else {
+			// Dynamic offsets are a host side decision, the shader can not tell
+			const auto compatible = [](vk::DescriptorType a, vk::DescriptorType b) {
+				const auto base = [](vk::DescriptorType t) {
+					if (t == vk::DescriptorType::eUniformBufferDynamic) return vk::DescriptorType::eUniformBuffer;
+					if (t == vk::DescriptorType::eStorageBufferDynamic) return vk::DescriptorType::eStorageBuffer;
+					return t;
+				};
+				return base(a) == base(b);
+			};
+
+			for (auto& binding : merged.bindings) {
+				if (binding.set >= layouts.size()) {
+					spdlog::error("[{}] (reflection) shaders use set {} ({}), but only {} layouts were given", builder_name, binding.set, binding.name, layouts.size());
+					continue;
+				}
+				const auto infos = set_infos.find(binding.set);
+				if (infos == set_infos.end()) continue;
+
+				const auto info = std::find_if(infos->second.begin(), infos->second.end(), [&binding](const descriptor::Info& i) { return i.binding == binding.binding; });
+				if (info == infos->second.end()) {
+					spdlog::error("[{}] (reflection) set {} binding {} ({}) is missing in the descriptor template", builder_name, binding.set, binding.binding, binding.name);
+				} else if (!compatible(info->type, binding.type)) {
+					spdlog::error("[{}] (reflection) set {} binding {} ({}) is {} in the template, but {} in the shaders",
+						builder_name, binding.set, binding.binding, binding.name, vk::to_string(info->type), vk::to_string(binding.type));
+				} else if ((info->stage & binding.stages) != binding.stages) {
+					spdlog::error("[{}] (reflection) set {} binding {} ({}) is not visible to all stages that use it ({})",
+						builder_name, binding.set, binding.binding, binding.name, vk::to_string(binding.stages));
+				}
+			}
+		}
+
+		// Push Constants
+		if (ranges.empty()) {
+			if (merged.push_constant)
+				ranges.emplace_back(merged.push_constant->stages, merged.push_constant->offset, merged.push_constant->size);
+		} else {
+			for (auto& stage : stages) {
+				if (!stage.push_constant) continue;
+				const auto& block = *stage.push_constant;
+				const auto covered = std::any_of(ranges.begin(), ranges.end(), [&block](const vk::PushConstantRange& r) {
+					return (r.stageFlags & block.stages) && r.offset <= block.offset && r.offset + r.size >= block.offset + block.size;
+				});
+				if (!covered)
+					spdlog::error("[{}] (reflection) push constant block [{}, {}) of the {} shader is not covered by a push constant range",
+						builder_name, block.offset, block.offset + block.size, vk::to_string(block.stages));
+			}
+		}
+	}
+
+	void GraphicsPipelineBuilder::apply_reflection(std::vector<vk::DescriptorSetLayout>& layouts, std::vector<DescriptorTemplate>& generated_templates,
+		std::vector<vk::PushConstantRange>& ranges, std::vector<vk::VertexInputBindingDescription>& vertex_bindings,
+		std::vector<vk::VertexInputAttributeDescription>& vertex_attributes) const {
+
+		std::vector<ShaderReflection> stages;
+		for (auto& shader_stage : shader_stages) {
+			if (auto reflected = ShaderReflection::reflect(shader_stage.code.data(), shader_stage.code.size(), shader_stage.stage))
+				stages.push_back(std::move(*reflected));
+		}
+		if (stages.empty()) return;
+
+		ShaderReflection merged = stages.front();
+		for (size_t i = 1; i < stages.size(); i++) merged.merge(stages[i]);
+
+		reflect_layout(device, "GraphicsPipelineBuilder", stages, merged, set_infos, layouts, generated_templates, ranges);
+
+		// Vertex Input
+		if (vertex_bindings.empty() && vertex_attributes.empty()) {
+			uint32_t offset = 0;
+			for (auto& input : merged.inputs) {
+				vertex_attributes.emplace_back(input.location, 0, input.format, offset);
+				offset += input.size;
+			}
+			if (!merged.inputs.empty()) vertex_bindings.emplace_back(0, offset, vk::VertexInputRate::eVertex);
+		} else {
+			for (auto& input : merged.inputs) {
+				const auto attribute = std::find_if(vertex_attributes.begin(), vertex_attributes.end(), [&input](const vk::VertexInputAttributeDescription& a) { return a.location == input.location; });
+				if (attribute == vertex_attributes.end()) {
+					spdlog::error("[GraphicsPipelineBuilder] (reflection) vertex input {} (location {}) is missing in the vertex layout", input.name, input.location);
+				} else if (numeric_class(attribute->format) != numeric_class(input.format)) {
+					spdlog::error("[GraphicsPipelineBuilder] (reflection) vertex input {} (location {}) is {} in the shader, but {} in the vertex layout",
+						input.name, input.location, vk::to_string(input.format), vk::to_string(attribute->format));
+				}
+			}
+		}
+	}
+
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::set_render_pass(vk::RenderPass render_pass, uint32_t subpass_index) {
 		this->render_pass = render_pass;
+		render_pass_hash = std::nullopt;
 		subpass = subpass_index;
 		return *this;
 	}
 
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::set_render_pass(ovk::RenderPass &render_pass, uint32_t subpass_index) {
-		return set_render_pass(render_pass.handle.get(), subpass_index);
+		set_render_pass(render_pass.handle.get(), subpass_index);
+		render_pass_hash = render_pass.compatibility_hash;
+		return *this;
 	}
 
 	GraphicsPipeline GraphicsPipelineBuilder::build() {
+		OVK_PROFILE_SCOPE("GraphicsPipelineBuilder::build");
 
+		vk::GraphicsPipelineCreateInfo info;
 
 		// Pipeline Stages
 		const auto vertex_and_fragment = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
 		if ((stage_flags & vertex_and_fragment) != vertex_and_fragment) spdlog::error(" [GraphicsPipelineBuilder] (build) Pipeline needs to have at least a vertex and a fragment shader");
+
+		std::vector<vk::ShaderModule> shaders;
+		std::vector<vk::PipelineShaderStageCreateInfo> stages;
+		for (auto& shader_stage : shader_stages) {
+			shaders.push_back(create_shader_module(&device->device.get(), shader_stage.code));
+			stages.emplace_back(vk::PipelineShaderStageCreateFlags{}, shader_stage.stage, shaders.back(), shader_stage.entry_point.c_str());
+		}
+
+		// Specialization Constants (one info per stage, the data of a stage is packed in constant_id order)
+		std::vector<std::vector<vk::SpecializationMapEntry>> specialization_entries(shader_stages.size());
+		std::vector<std::vector<uint8_t>> specialization_data(shader_stages.size());
+		std::vector<vk::SpecializationInfo> specialization_infos(shader_stages.size());
+		for (auto& [key, data] : specializations) {
+			if (!(stage_flags & key.first)) spdlog::warn("[GraphicsPipelineBuilder] (build) specialization constant {} set for missing stage {}", key.second, vk::to_string(key.first));
+		}
+		for (size_t i = 0; i < shader_stages.size(); i++) {
+			auto& entries = specialization_entries[i];
+			auto& bytes = specialization_data[i];
+			for (auto& [key, data] : specializations) {
+				if (key.first != shader_stages[i].stage) continue;
+				entries.emplace_back(key.second, static_cast<uint32_t>(bytes.size()), data.size());
+				bytes.insert(bytes.end(), data.begin(), data.end());
+			}
+			if (entries.empty()) continue;
+
+			specialization_infos[i] = vk::SpecializationInfo(static_cast<uint32_t>(entries.size()), entries.data(), bytes.size(), bytes.data());
+			stages[i].pSpecializationInfo = &specialization_infos[i];
+		}
+
 		info.stageCount = stages.size();
 		info.pStages = stages.data();
 
 		// Viewport State
 		// TODO: CHECK FOR FEATURE MULTIPLE VIEWPORTS
-		if (viewports.empty() || scissors.empty())
-			spdlog::error("[GraphicsPipelineBuilder] (build) You need to provide at least one Viewport and one Scissor");
+		const auto is_dynamic = [this](vk::DynamicState state) {
+			return std::find(dynamic_states.begin(), dynamic_states.end(), state) != dynamic_states.end();
+		};
+		const bool dynamic_viewport = is_dynamic(vk::DynamicState::eViewport), dynamic_scissor = is_dynamic(vk::DynamicState::eScissor);
+		if ((viewports.empty() && !dynamic_viewport) || (scissors.empty() && !dynamic_scissor))
+			spdlog::error("[GraphicsPipelineBuilder] (build) You need to provide at least one Viewport and one Scissor (or make them dynamic)");
 		vk::PipelineViewportStateCreateInfo viewport {
 			{},
-			static_cast<uint32_t>(viewports.size()),
-			viewports.data(),
-			static_cast<uint32_t>(scissors.size()),
-			scissors.data()
+			dynamic_viewport ? std::max(1u, static_cast<uint32_t>(viewports.size())) : static_cast<uint32_t>(viewports.size()),
+			dynamic_viewport ? nullptr : viewports.data(),
+			dynamic_scissor ? std::max(1u, static_cast<uint32_t>(scissors.size())) : static_cast<uint32_t>(scissors.size()),
+			dynamic_scissor ? nullptr : scissors.data()
+		};
+
+		vk::PipelineDynamicStateCreateInfo dynamic_state {
+			{},
+			static_cast<uint32_t>(dynamic_states.size()),
+			dynamic_states.data()
 		};
 
+		auto layouts = set_layouts;
+		auto ranges = push_constants;
+		auto vertex_bindings = bindings;
+		auto vertex_attributes = attributes;
+		std::vector<DescriptorTemplate> generated_templates;
+		if (reflection) apply_reflection(layouts, generated_templates, ranges, vertex_bindings, vertex_attributes);
+
 		// Create Pipeline Layout
 		vk::PipelineLayoutCreateInfo layout {
 			{},
-			static_cast<uint32_t>(set_layouts.size()),
-			set_layouts.empty() ? nullptr : set_layouts.data(),
-			static_cast<uint32_t>(push_constants.size()),
-			push_constants.empty() ? nullptr : push_constants.data()
+			static_cast<uint32_t>(layouts.size()),
+			layouts.empty() ? nullptr : layouts.data(),
+			static_cast<uint32_t>(ranges.size()),
+			ranges.empty() ? nullptr : ranges.data()
 		};
 		
 		const auto pipeline_layout = VK_CREATE(device->device->createPipelineLayout(layout), "[GraphicsPipelineBuilder] (build) Failed to create Pipeline Layout");
 
+		// The builder might have been copied or moved (eg. into a worker task) since the state was set,
+		// so point the create infos at the arrays we actually use
+		auto vertex_input_state = vertex_input;
+		vertex_input_state.vertexBindingDescriptionCount = static_cast<uint32_t>(vertex_bindings.size());
+		vertex_input_state.pVertexBindingDescriptions = vertex_bindings.data();
+		vertex_input_state.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertex_attributes.size());
+		vertex_input_state.pVertexAttributeDescriptions = vertex_attributes.data();
+
+		auto color_blend_state = color_blending;
+		color_blend_state.attachmentCount = static_cast<uint32_t>(blend_attachments.size());
+		color_blend_state.pAttachments = blend_attachments.data();
+
 		// Fill out Create Info
-		info.pVertexInputState = &vertex_input;
+		info.pVertexInputState = &vertex_input_state;
 		info.pInputAssemblyState = &input_assembly;
 		info.pViewportState = &viewport;
 		info.pRasterizationState = &rasterizer;
 		info.pMultisampleState = &multisampling;
 		info.pDepthStencilState = depth_stencil.has_value() ? &depth_stencil.value() : nullptr;
-		info.pColorBlendState = &color_blending;
-		info.pDynamicState = nullptr;
+		info.pColorBlendState = &color_blend_state;
+		info.pDynamicState = dynamic_states.empty() ? nullptr : &dynamic_state;
 
 		info.layout = pipeline_layout;
 
@@ -196,9 +453,10 @@ namespace ovk {
 		info.basePipelineHandle = vk::Pipeline();
 		info.basePipelineIndex = -1;
 
-		const auto pipeline = VK_CREATE(device->device->createGraphicsPipeline(vk::PipelineCache(), info), "[GraphicsPipelineBuilder] (build) Failed to create vk::Pipeline");
+		const auto pipeline = VK_CREATE(device->device->createGraphicsPipeline(device->get_pipeline_cache(), info), "[GraphicsPipelineBuilder] (build) Failed to create vk::Pipeline");
 
 		GraphicsPipeline graphics_pipeline(pipeline, pipeline_layout, device);
+		graphics_pipeline.descriptor_templates = std::move(generated_templates);
 
 		// Delete Shader Modules
 		for (auto& shader : shaders) {
@@ -208,6 +466,94 @@ namespace ovk {
 		return std::move(graphics_pipeline);
 	}
 
+	std::shared_ptr<GraphicsPipeline> GraphicsPipelineBuilder::build_cached() {
+		auto& registry = device->get_pipeline_registry();
+		if (!is_cacheable()) return registry.insert(std::nullopt, build(), *this);
+
+		auto description = describe();
+		if (auto pipeline = registry.find(description)) return pipeline;
+		auto pipeline = build();
+		return registry.insert(std::move(description), std::move(pipeline), *this);
+	}
+
+	PipelineFuture GraphicsPipelineBuilder::build_async() {
+		auto& registry = device->get_pipeline_registry();
+		std::optional<std::vector<uint8_t>> description;
+		if (is_cacheable()) description = describe();
+
+		if (auto pipeline = description ? registry.find(*description) : nullptr) {
+			std::promise<std::shared_ptr<GraphicsPipeline>> ready;
+			ready.set_value(std::move(pipeline));
+			return PipelineFuture(ready.get_future().share());
+		}
+
+		// Two identical requests in flight both compile, the registry keeps whichever finishes first
+		auto future = device->get_thread_pool().submit([builder = std::move(*this), description = std::move(description), &registry]() mutable {
+			auto pipeline = builder.build();
+			return registry.insert(std::move(description), std::move(pipeline), builder);
+		});
+		return PipelineFuture(future.share());
+	}
+
+	std::vector<uint8_t> GraphicsPipelineBuilder::describe() const {
+		PipelineDescription h;
+
+		h << shader_stages.size();
+		for (auto& shader_stage : shader_stages)
+			h << shader_stage.stage << shader_stage.code << shader_stage.entry_point;
+
+		h << specializations.size();
+		for (auto& [key, data] : specializations)
+			h << key.first << key.second << data;
+
+		h << bindings << attributes;
+		h << input_assembly.topology << input_assembly.primitiveRestartEnable;
+
+		h << rasterizer.depthClampEnable << rasterizer.rasterizerDiscardEnable << rasterizer.polygonMode << rasterizer.cullMode << rasterizer.frontFace
+			<< rasterizer.depthBiasEnable << rasterizer.depthBiasConstantFactor << rasterizer.depthBiasClamp << rasterizer.depthBiasSlopeFactor << rasterizer.lineWidth;
+
+		h << multisampling.rasterizationSamples << multisampling.sampleShadingEnable << multisampling.minSampleShading
+			<< multisampling.alphaToCoverageEnable << multisampling.alphaToOneEnable;
+
+		h << blend_attachments << color_blending.logicOpEnable << color_blending.logicOp << color_blending.blendConstants;
+
+		h << depth_stencil.has_value();
+		if (depth_stencil) {
+			h << depth_stencil->depthTestEnable << depth_stencil->depthWriteEnable << depth_stencil->depthCompareOp << depth_stencil->depthBoundsTestEnable
+				<< depth_stencil->stencilTestEnable << depth_stencil->front << depth_stencil->back << depth_stencil->minDepthBounds << depth_stencil->maxDepthBounds;
+		}
+
+		// Handles can be reused by the driver after a layout is destroyed, so layouts with known bindings are hashed by those
+		h << set_layouts.size();
+		for (uint32_t set = 0; set < set_layouts.size(); set++) {
+			if (const auto infos = set_infos.find(set); infos != set_infos.end()) {
+				h << infos->second.size();
+				for (auto& info : infos->second)
+					h << info.binding << info.type << info.stage << info.count << info.flags;
+			} else {
+				h << set_layouts[set];
+			}
+		}
+		h << push_constants << reflection;
+		h << viewports << scissors << dynamic_states;
+
+		if (render_pass_hash) h << *render_pass_hash;
+		else h << render_pass.value_or(vk::RenderPass());
+		h << subpass;
+
+		return std::move(h.description);
+	}
+
+	uint64_t GraphicsPipelineBuilder::hash() const {
+		return fnv1a(describe());
+	}
+
+	bool GraphicsPipelineBuilder::is_cacheable() const {
+		for (uint32_t set = 0; set < set_layouts.size(); set++)
+			if (!set_infos.contains(set)) return false;
+		return render_pass_hash.has_value();
+	}
+
 	GraphicsPipelineBuilder::GraphicsPipelineBuilder(Device* d)
 		: device(d),
 		input_assembly({}, vk::PrimitiveTopology::eTriangleList, false),
@@ -243,4 +589,222 @@ namespace ovk {
 		: DeviceObject(device->device.get(), pipeline_handle),
 			layout(std::forward<vk::PipelineLayout>(layout), ObjectDestroy<vk::PipelineLayout>(device->device.get())) {}
 
+	GraphicsPipelineBuilder & GraphicsPipelineBuilder::set_specialization_data(vk::ShaderStageFlagBits stage, uint32_t constant_id, const void *data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		specializations[{ stage, constant_id }] = std::vector<uint8_t>(bytes, bytes + size);
+		return *this;
+	}
+
+	std::vector<std::string> GraphicsPipelineBuilder::get_shader_files() const {
+		std::vector<std::string> files;
+		for (auto& shader_stage : shader_stages)
+			if (!shader_stage.file_path.empty()) files.push_back(shader_stage.file_path);
+		return files;
+	}
+
+	bool GraphicsPipelineBuilder::reload_shader_stages(const std::unordered_set<std::string> &changed_files) {
+		std::vector<std::vector<uint32_t>> reloaded;
+		for (auto& shader_stage : shader_stages) {
+			if (!changed_files.contains(shader_stage.file_path)) {
+				reloaded.push_back(shader_stage.code);
+				continue;
+			}
+			auto code = load_shader_code(device, shader_stage.file_path, shader_stage.stage, shader_stage.compile);
+			if (!code) return false;
+			reloaded.push_back(std::move(*code));
+		}
+
+		for (size_t i = 0; i < shader_stages.size(); i++) shader_stages[i].code = std::move(reloaded[i]);
+		return true;
+	}
+
+	PipelineFuture::PipelineFuture(std::shared_future<std::shared_ptr<GraphicsPipeline>> future)
+		: future(std::move(future)) {}
+
+	bool PipelineFuture::valid() const {
+		return future.valid();
+	}
+
+	bool PipelineFuture::is_ready() const {
+		return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	const std::shared_ptr<GraphicsPipeline>& PipelineFuture::get() const {
+		ovk_asserts(future.valid(), "[PipelineFuture] (get) no pipeline was requested");
+		if (!is_ready()) {
+			OVK_PROFILE_SCOPE("PipelineFuture::wait");
+			future.wait();
+		}
+		return future.get();
+	}
+
+	GraphicsPipeline& PipelineFuture::operator*() const {
+		return *get();
+	}
+
+	GraphicsPipeline* PipelineFuture::operator->() const {
+		return get().get();
+	}
+
+	std::shared_ptr<GraphicsPipeline> PipelineRegistry::find(const std::vector<uint8_t>& description) const {
+		std::lock_guard lock(mutex);
+		auto [begin, end] = pipelines.equal_range(fnv1a(description));
+		for (auto it = begin; it != end; ++it)
+			if (it->second.description == description) return it->second.pipeline;
+		return nullptr;
+	}
+
+	std::shared_ptr<GraphicsPipeline> PipelineRegistry::insert(std::optional<std::vector<uint8_t>> description, GraphicsPipeline &&pipeline, const GraphicsPipelineBuilder& builder) {
+		// Not cacheable entries still need a key, they are never compared against anything
+		const auto hash = description ? fnv1a(*description) : 0;
+		Entry entry{ std::move(description), std::make_shared<GraphicsPipeline>(std::move(pipeline)), std::make_unique<GraphicsPipelineBuilder>(builder) };
+
+		std::lock_guard lock(mutex);
+		if (entry.description) {
+			auto [begin, end] = pipelines.equal_range(hash);
+			for (auto it = begin; it != end; ++it)
+				if (it->second.description == entry.description) return it->second.pipeline;
+		}
+		return pipelines.emplace(hash, std::move(entry))->second.pipeline;
+	}
+
+	size_t PipelineRegistry::collect_unused() {
+		std::lock_guard lock(mutex);
+		return std::erase_if(pipelines, [](const auto& entry) { return entry.second.pipeline.use_count() == 1; });
+	}
+
+	std::vector<std::string> PipelineRegistry::get_shader_files() const {
+		std::lock_guard lock(mutex);
+		std::unordered_set<std::string> files;
+		for (auto& [hash, entry] : pipelines) {
+			for (auto& file : entry.builder->get_shader_files()) files.insert(file);
+		}
+		return std::vector<std::string>(files.begin(), files.end());
+	}
+
+	size_t PipelineRegistry::reload(const std::unordered_set<std::string> &changed_files) {
+		std::lock_guard lock(mutex);
+
+		size_t rebuilt = 0;
+		for (auto& [hash, entry] : pipelines) {
+			const auto files = entry.builder->get_shader_files();
+			if (std::none_of(files.begin(), files.end(), [&changed_files](const std::string& f) { return changed_files.contains(f); })) continue;
+
+			auto builder = *entry.builder;
+			if (!builder.reload_shader_stages(changed_files)) {
+				spdlog::error("[PipelineRegistry] (reload) keeping the old pipeline, a shader of it failed to load");
+				continue;
+			}
+
+			// Everybody holds the same object, so swapping its contents updates them all
+			*entry.pipeline = builder.build();
+			*entry.builder = std::move(builder);
+			rebuilt++;
+		}
+		// The entry keeps the original description, so building the old state again still finds the pipeline
+		return rebuilt;
+	}
+
+	void PipelineRegistry::clear() {
+		std::lock_guard lock(mutex);
+		pipelines.clear();
+	}
+
+	size_t PipelineRegistry::size() const {
+		std::lock_guard lock(mutex);
+		return pipelines.size();
+	}
+
+	ComputePipelineBuilder::ComputePipelineBuilder(Device *d) : device(d) {}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::set_shader_from_file(std::string file_path, bool compile_shader, const std::string &entry_point) {
+		auto loaded = load_shader_code(device, file_path, vk::ShaderStageFlagBits::eCompute, compile_shader);
+		code = loaded.value_or(std::vector<uint32_t>{});
+		this->entry_point = entry_point;
+		return *this;
+	}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::set_shader_u32(const uint32_t *data, size_t size, const std::string &entry_point) {
+		code = std::vector<uint32_t>(data, data + size / sizeof(uint32_t));
+		this->entry_point = entry_point;
+		return *this;
+	}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::add_descriptor_set_layouts(std::vector<vk::DescriptorSetLayout> sets) {
+		set_layouts.insert(set_layouts.end(), sets.begin(), sets.end());
+		return *this;
+	}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::add_descriptor_templates(std::vector<const DescriptorTemplate*> templates) {
+		for (const auto* t : templates) {
+			set_infos[static_cast<uint32_t>(set_layouts.size())] = t->infos;
+			set_layouts.push_back(t->handle.get());
+		}
+		return *this;
+	}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::add_push_constant(uint32_t size, uint32_t offset) {
+		push_constants.emplace_back(vk::ShaderStageFlagBits::eCompute, offset, size);
+		return *this;
+	}
+
+	ComputePipelineBuilder & ComputePipelineBuilder::use_reflection() {
+		reflection = true;
+		return *this;
+	}
+
+	ComputePipeline ComputePipelineBuilder::build() {
+		OVK_PROFILE_SCOPE("ComputePipelineBuilder::build");
+
+		if (code.empty()) spdlog::error("[ComputePipelineBuilder] (build) Pipeline needs a compute shader");
+
+		auto layouts = set_layouts;
+		auto ranges = push_constants;
+		std::vector<DescriptorTemplate> generated_templates;
+		auto reflected = ShaderReflection::reflect(code.data(), code.size(), vk::ShaderStageFlagBits::eCompute);
+		if (reflection && reflected) reflect_layout(device, "ComputePipelineBuilder", { *reflected }, *reflected, set_infos, layouts, generated_templates, ranges);
+
+		vk::PipelineLayoutCreateInfo layout {
+			{},
+			static_cast<uint32_t>(layouts.size()),
+			layouts.empty() ? nullptr : layouts.data(),
+			static_cast<uint32_t>(ranges.size()),
+			ranges.empty() ? nullptr : ranges.data()
+		};
+		const auto pipeline_layout = VK_CREATE(device->device->createPipelineLayout(layout), "[ComputePipelineBuilder] (build) Failed to create Pipeline Layout");
+
+		// Specialization Constants (packed in constant_id order)
+		std::vector<vk::SpecializationMapEntry> entries;
+		std::vector<uint8_t> bytes;
+		for (auto& [constant_id, data] : specializations) {
+			entries.emplace_back(constant_id, static_cast<uint32_t>(bytes.size()), data.size());
+			bytes.insert(bytes.end(), data.begin(), data.end());
+		}
+		const vk::SpecializationInfo specialization_info(static_cast<uint32_t>(entries.size()), entries.data(), bytes.size(), bytes.data());
+
+		const auto shader = create_shader_module(&device->device.get(), code);
+		const vk::PipelineShaderStageCreateInfo stage {
+			{},
+			vk::ShaderStageFlagBits::eCompute,
+			shader,
+			entry_point.c_str(),
+			entries.empty() ? nullptr : &specialization_info
+		};
+
+		const vk::ComputePipelineCreateInfo info{ {}, stage, pipeline_layout, vk::Pipeline(), -1 };
+		const auto pipeline = VK_CREATE(device->device->createComputePipeline(device->get_pipeline_cache(), info), "[ComputePipelineBuilder] (build) Failed to create vk::Pipeline");
+
+		device->device->destroyShaderModule(shader);
+
+		ComputePipeline compute_pipeline(pipeline, pipeline_layout, device);
+		compute_pipeline.descriptor_templates = std::move(generated_templates);
+		if (reflected) compute_pipeline.local_size = glm::uvec3(reflected->local_size[0], reflected->local_size[1], reflected->local_size[2]);
+
+		return std::move(compute_pipeline);
+	}
+
+	ComputePipeline::ComputePipeline(vk::Pipeline pipeline_handle, vk::PipelineLayout layout, Device *device)
+		: DeviceObject(device->device.get(), pipeline_handle),
+			layout(std::forward<vk::PipelineLayout>(layout), ObjectDestroy<vk::PipelineLayout>(device->device.get())) {}
+
 }
@@ -1,25 +1,60 @@
 #pragma once
 
 #include "handle.h"
+#include "descriptor.h"
+#include "shader_reflection.h"
+#include "vertex_layout.h"
 
 #include <glm/glm.hpp>
+#include <cstring>
+#include <future>
+#include <map>
+#include <mutex>
 #include <optional>
-
-// Maybe we should not pull in this dependency here
-#include <boost/pfr.hpp>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace ovk {
 	class RenderPass;
 
 	class GraphicsPipeline;
+	class ComputePipeline;
+
+	/**
+	 * \brief Pipeline that is (possibly still) compiled on the worker pool of the device, see GraphicsPipelineBuilder::build_async
+	 *				Dereferencing waits for the compilation, so it can be used like the pipeline itself when recording
+	 */
+	class OVK_API PipelineFuture {
+	public:
+		PipelineFuture() = default;
+
+		[[nodiscard]] bool valid() const;
+		[[nodiscard]] bool is_ready() const;
+
+		// Blocks until the pipeline is compiled
+		const std::shared_ptr<GraphicsPipeline>& get() const;
+
+		GraphicsPipeline& operator*() const;
+		GraphicsPipeline* operator->() const;
+
+	private:
+		friend class GraphicsPipelineBuilder;
+		explicit PipelineFuture(std::shared_future<std::shared_ptr<GraphicsPipeline>> future);
+
+		std::shared_future<std::shared_ptr<GraphicsPipeline>> future;
+	};
 
 	class OVK_API GraphicsPipelineBuilder {
 	public:
 
+		// With compile_shader, file_path is GLSL source that is compiled with the ShaderCompiler of the device (cached on disk)
 		GraphicsPipelineBuilder& add_shader_stage_from_file(vk::ShaderStageFlagBits stage, std::string file_path, bool compile_shader = false, const std::string &entry_point = "main");
 		GraphicsPipelineBuilder& add_shader_stage_u32(vk::ShaderStageFlagBits stage, uint32_t* data, size_t size, const std::string& entry_point = "main");
 
-		template <typename T>
+		// One binding per type (in order), wrap a type in per_instance<T> for instance rate, eg.
+		// set_vertex_layout<MeshVertex, per_instance<InstanceData>>()
+		// The attributes are generated at compile time (see vertex::attribute_table), locations continue across bindings
+		template <typename... Ts>
 		GraphicsPipelineBuilder& set_vertex_layout();
 		
 		GraphicsPipelineBuilder& set_vertex_layout(std::vector<vk::VertexInputBindingDescription> bindings, std::vector<vk::VertexInputAttributeDescription> attributes);
@@ -27,33 +62,98 @@ namespace ovk {
 
 		GraphicsPipelineBuilder& set_rasterizer(vk::PipelineRasterizationStateCreateInfo rasterization_state);
 
-		GraphicsPipelineBuilder set_depth_stencil(bool depth_test_enabled = true, bool depth_write_enabled = true, vk::CompareOp compare = vk::CompareOp::eLess, bool depth_bounds = false, glm::vec2 bounds = { 0.0f, 0.0f });
+		GraphicsPipelineBuilder& set_depth_stencil(bool depth_test_enabled = true, bool depth_write_enabled = true, vk::CompareOp compare = vk::CompareOp::eLess, bool depth_bounds = false, glm::vec2 bounds = { 0.0f, 0.0f });
+
+		// One blend state per color attachment of the subpass (default is a single attachment with alpha blending)
+		GraphicsPipelineBuilder& set_color_blend(uint32_t attachment_count, bool blend_enabled = true);
 		
+		// Raw layouts are only known by their handle, which the driver may reuse for another layout once this one is
+		// destroyed, so pipelines using them are never shared through the registry (see is_cacheable). Prefer
+		// add_descriptor_templates
 		GraphicsPipelineBuilder& add_descriptor_set_layouts(std::vector<vk::DescriptorSetLayout> sets);
+		// Like add_descriptor_set_layouts, but the bindings are known, so use_reflection can validate them and the
+		// pipeline description covers the bindings instead of the handle
+		GraphicsPipelineBuilder& add_descriptor_templates(std::vector<const DescriptorTemplate*> templates);
 		GraphicsPipelineBuilder& add_push_constant(vk::ShaderStageFlagBits e_vertex, uint32_t size, uint32_t offset = 0);
 		
 		GraphicsPipelineBuilder& add_viewport(glm::vec2 origin, glm::vec2 extent, float min_depth, float max_depth);
 		GraphicsPipelineBuilder& add_scissor(vk::Offset2D offset, vk::Extent2D extent);
 
+		// Viewport and scissor are not baked into the pipeline but set with RenderCommand::set_viewport/set_scissor,
+		// so the pipeline does not depend on the swapchain extent and survives a resize
+		GraphicsPipelineBuilder& set_dynamic_viewport_scissor();
+		GraphicsPipelineBuilder& add_dynamic_state(vk::DynamicState state);
+
+		// Like raw descriptor set layouts, a raw render pass makes the pipeline not cacheable, prefer the ovk::RenderPass overload
 		GraphicsPipelineBuilder& set_render_pass(vk::RenderPass render_pass, uint32_t subpass_index = 0);
 		GraphicsPipelineBuilder& set_render_pass(ovk::RenderPass& render_pass, uint32_t subpass_index = 0);
 
+		// Value of layout (constant_id = constant_id) const ... in the shader of stage, bool is passed as VkBool32
+		// The values are part of the hash, so every combination is its own pipeline in the registry
+		template <typename T>
+		GraphicsPipelineBuilder& set_specialization(vk::ShaderStageFlagBits stage, uint32_t constant_id, T value);
+
+		// Reflects the SPIR-V of all stages in build:
+		//  - without descriptor set layouts, one DescriptorTemplate per set is generated (merged over all stages)
+		//    and stored in the pipeline, otherwise the templates given with add_descriptor_templates are validated
+		//  - without push constants, one range covering the blocks of all stages is generated, otherwise they are validated
+		//  - without a vertex layout, one tightly packed binding (in location order) is generated, otherwise it is validated
+		// Validation errors are logged, the pipeline is still built
+		GraphicsPipelineBuilder& use_reflection();
+
 
 		// TODO: Rasterizer and Multisampling and Color Blending
 
 		GraphicsPipeline build();
 
+		// Returns the pipeline from the registry of the device if one was already built from identical state,
+		// otherwise builds it and adds it to the registry
+		std::shared_ptr<GraphicsPipeline> build_cached();
+
+		// Like build_cached, but a registry miss is compiled on the worker pool of the device
+		// The builder is moved into the task, so it must not be used afterwards
+		PipelineFuture build_async();
+
+		// Canonical bytes of the shader code and every state that ends up in the pipeline (including layouts and render
+		// pass), the registry compares them on lookup so a hash collision can not return the wrong pipeline
+		[[nodiscard]] std::vector<uint8_t> describe() const;
+		// FNV-1a of describe()
+		[[nodiscard]] uint64_t hash() const;
+		// False if a descriptor set layout or the render pass was given as a raw handle. Those are only described by the
+		// handle value, which the driver may reuse for another object, so build_cached and build_async never return an
+		// existing pipeline for them
+		[[nodiscard]] bool is_cacheable() const;
+
 	private:
 		friend class Device;
+		friend class PipelineRegistry;
 
 		explicit GraphicsPipelineBuilder(Device* d);
 
+		// Files the stages were loaded from (for hot reload)
+		[[nodiscard]] std::vector<std::string> get_shader_files() const;
+		// Loads the stages from changed_files again, returns false (and leaves the builder untouched) if one fails
+		bool reload_shader_stages(const std::unordered_set<std::string>& changed_files);
+
+		GraphicsPipelineBuilder& set_specialization_data(vk::ShaderStageFlagBits stage, uint32_t constant_id, const void* data, size_t size);
+
 		Device* device;
-		std::vector<vk::ShaderModule> shaders;
 
-		std::vector<vk::PipelineShaderStageCreateInfo> stages;
+		// Shader modules are only created in build, so hashing (and registry hits) never touch the driver
+		struct ShaderStage {
+			vk::ShaderStageFlagBits stage;
+			std::vector<uint32_t> code;
+			std::string entry_point;
+			// Empty for stages from memory
+			std::string file_path;
+			bool compile;
+		};
+		std::vector<ShaderStage> shader_stages;
 		vk::ShaderStageFlags stage_flags = {};
 
+		// Ordered, so the hash does not depend on the order of set_specialization calls
+		std::map<std::pair<vk::ShaderStageFlagBits, uint32_t>, std::vector<uint8_t>> specializations;
+
 		std::vector<vk::VertexInputBindingDescription> bindings;
 		std::vector<vk::VertexInputAttributeDescription> attributes;
 		vk::PipelineVertexInputStateCreateInfo vertex_input;
@@ -61,10 +161,18 @@ namespace ovk {
 		vk::PipelineInputAssemblyStateCreateInfo input_assembly;
 
 		std::vector<vk::DescriptorSetLayout> set_layouts;
+		// Bindings of the layouts that were added as templates (indexed by set)
+		std::unordered_map<uint32_t, std::vector<descriptor::Info>> set_infos;
 		std::vector<vk::PushConstantRange> push_constants;
+
+		bool reflection = false;
+		void apply_reflection(std::vector<vk::DescriptorSetLayout>& layouts, std::vector<DescriptorTemplate>& generated_templates,
+			std::vector<vk::PushConstantRange>& ranges, std::vector<vk::VertexInputBindingDescription>& vertex_bindings,
+			std::vector<vk::VertexInputAttributeDescription>& vertex_attributes) const;
 		
 		std::vector<vk::Viewport> viewports;
 		std::vector<vk::Rect2D> scissors;
+		std::vector<vk::DynamicState> dynamic_states;
 
 		vk::PipelineRasterizationStateCreateInfo rasterizer;
 
@@ -76,67 +184,159 @@ namespace ovk {
 		std::optional<vk::PipelineDepthStencilStateCreateInfo> depth_stencil = std::nullopt;
 
 		std::optional<vk::RenderPass> render_pass = std::nullopt;
+		// RenderPass::compatibility_hash, without it (raw vk::RenderPass) the pipeline is not cacheable
+		std::optional<uint64_t> render_pass_hash = std::nullopt;
 		uint32_t subpass = 0;
-
-		vk::GraphicsPipelineCreateInfo info;
 	};
 
-	template <typename T>
-	vk::Format internal_get_format(const T& v) {
-		panic("[GraphicsPipelineBuilder] (set_vertex_layout<T>) unkndown field type: {}", typeid(T).name());
-		return vk::Format::eUndefined;
-	}
-	
-	// Ok so this function tries to provide a bit of magic to figure
-	// out the vertex layout based on a struct.
-	// Currently we only support one binding and nested structures will break
-	// the code,
-	// but for example:
-	// struct MyCoolVertex {
-	//	glm::vec3 pos;
-	//	glm::vec2 tex_coord;
-	//	glm::vec3 normal;
-	// };
-	// should work!
-	template <typename T>
+	template <typename... Ts>
 	GraphicsPipelineBuilder & GraphicsPipelineBuilder::set_vertex_layout() {
-		static_assert(std::is_default_constructible_v<T>, "[GraphicsPipelineBuilder] (set_vertex_layout) T must be default constructable");
+		static_assert(sizeof...(Ts) > 0, "[GraphicsPipelineBuilder] (set_vertex_layout) needs at least one binding");
 		std::vector<vk::VertexInputBindingDescription> bindings;
-		
-		bindings.emplace_back(0, sizeof(T), vk::VertexInputRate::eVertex);
-		uint32_t current_location = 0, current_offset = 0;
 		std::vector<vk::VertexInputAttributeDescription> attributes;
+		uint32_t binding = 0, first_location = 0;
+
+		([&] {
+			using Binding = vertex::Binding<Ts>;
+			constexpr auto& table = vertex::attribute_table<typename Binding::type>;
+
+			bindings.emplace_back(binding, static_cast<uint32_t>(sizeof(typename Binding::type)), Binding::rate);
+			for (auto& attribute : table)
+				attributes.emplace_back(first_location + attribute.location, binding, attribute.format, attribute.offset);
 
-		boost::pfr::for_each_field(T(), [&attributes, &current_location, &current_offset](const auto& field) {
-			vk::Format format = internal_get_format(field);
-			uint32_t size = sizeof(decltype(field));
-			
-			attributes.emplace_back(current_location, 0, format, current_offset);
-			current_location += 1;
-			current_offset += size;
-		});
+			first_location += static_cast<uint32_t>(table.size());
+			binding++;
+		}(), ...);
 
 		set_vertex_layout(bindings, attributes);
 		return *this;
- 	}
-
-	template<>
-	inline vk::Format internal_get_format<glm::vec3>(const glm::vec3& v) {
-		return vk::Format::eR32G32B32Sfloat;;
 	}
 
-	template<>
-	inline vk::Format internal_get_format<glm::vec2>(const glm::vec2& v) {
-		return vk::Format::eR32G32Sfloat;;
-	}
-	
 	class OVK_API GraphicsPipeline : public DeviceObject<vk::Pipeline> {
 	public:
 		UniqueHandle<vk::PipelineLayout> layout;
+		// Generated by GraphicsPipelineBuilder::use_reflection (indexed by set), empty if the layouts were given explicitly
+		std::vector<DescriptorTemplate> descriptor_templates;
 	private:
 		friend GraphicsPipelineBuilder;
 		GraphicsPipeline(vk::Pipeline pipeline_handle, vk::PipelineLayout layout, Device* device);
 
 	};
 
+	/**
+	 * \brief Pipelines of the device indexed by GraphicsPipelineBuilder::describe
+	 *				The registry keeps a reference to every pipeline, so rebuilding the same state (eg. in create_dynamic_objects
+	 *				after a resize) returns the existing pipeline instead of creating a new one
+	 */
+	class OVK_API PipelineRegistry {
+	public:
+		[[nodiscard]] std::shared_ptr<GraphicsPipeline> find(const std::vector<uint8_t>& description) const;
+		// If another thread inserted the same description in the meantime, pipeline is dropped and the existing one is
+		// returned. Without a description (GraphicsPipelineBuilder::is_cacheable) the pipeline is never found, but still
+		// kept for hot reload, which is what the builder is kept for
+		std::shared_ptr<GraphicsPipeline> insert(std::optional<std::vector<uint8_t>> description, GraphicsPipeline&& pipeline,
+			const GraphicsPipelineBuilder& builder);
+
+		// Destroys all pipelines that are not referenced outside of the registry, returns how many were destroyed
+		// Make sure they are no longer used by a command buffer in flight
+		size_t collect_unused();
+		void clear();
+
+		[[nodiscard]] size_t size() const;
+
+		// Shader files of all registered pipelines (see ShaderWatcher)
+		[[nodiscard]] std::vector<std::string> get_shader_files() const;
+		// Rebuilds the pipelines that use one of the files in place, returns how many were rebuilt
+		// The old pipelines are destroyed, so the device must be idle
+		size_t reload(const std::unordered_set<std::string>& changed_files);
+
+	private:
+		struct Entry {
+			// GraphicsPipelineBuilder::describe of the original state (hot reload keeps it), empty if not cacheable
+			std::optional<std::vector<uint8_t>> description;
+			std::shared_ptr<GraphicsPipeline> pipeline;
+			std::unique_ptr<GraphicsPipelineBuilder> builder;
+		};
+
+		// Pipelines are inserted from the worker threads (build_async)
+		mutable std::mutex mutex;
+		// Keyed by the hash of the description, entries with the same hash are told apart by the description
+		std::unordered_multimap<uint64_t, Entry> pipelines;
+	};
+
+	class OVK_API ComputePipelineBuilder {
+	public:
+
+		// Same as GraphicsPipelineBuilder::add_shader_stage_from_file, but for the (only) compute stage
+		ComputePipelineBuilder& set_shader_from_file(std::string file_path, bool compile_shader = false, const std::string& entry_point = "main");
+		ComputePipelineBuilder& set_shader_u32(const uint32_t* data, size_t size, const std::string& entry_point = "main");
+
+		template <typename T>
+		ComputePipelineBuilder& set_specialization(uint32_t constant_id, T value);
+
+		ComputePipelineBuilder& add_descriptor_set_layouts(std::vector<vk::DescriptorSetLayout> sets);
+		ComputePipelineBuilder& add_descriptor_templates(std::vector<const DescriptorTemplate*> templates);
+		ComputePipelineBuilder& add_push_constant(uint32_t size, uint32_t offset = 0);
+
+		// Descriptor set layouts and push constants like GraphicsPipelineBuilder::use_reflection
+		ComputePipelineBuilder& use_reflection();
+
+		ComputePipeline build();
+
+	private:
+		friend class Device;
+		explicit ComputePipelineBuilder(Device* d);
+
+		Device* device;
+
+		std::vector<uint32_t> code;
+		std::string entry_point = "main";
+		std::map<uint32_t, std::vector<uint8_t>> specializations;
+
+		std::vector<vk::DescriptorSetLayout> set_layouts;
+		std::unordered_map<uint32_t, std::vector<descriptor::Info>> set_infos;
+		std::vector<vk::PushConstantRange> push_constants;
+
+		bool reflection = false;
+	};
+
+	template <typename T>
+	ComputePipelineBuilder& ComputePipelineBuilder::set_specialization(uint32_t constant_id, T value) {
+		std::vector<uint8_t> data;
+		if constexpr (std::is_same_v<T, bool>) {
+			const vk::Bool32 b = value ? VK_TRUE : VK_FALSE;
+			data.resize(sizeof(b));
+			std::memcpy(data.data(), &b, sizeof(b));
+		} else {
+			static_assert(std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "[ComputePipelineBuilder] (set_specialization) T must be a 32 or 64 bit scalar");
+			data.resize(sizeof(T));
+			std::memcpy(data.data(), &value, sizeof(T));
+		}
+		specializations[constant_id] = std::move(data);
+		return *this;
+	}
+
+	template <typename T>
+	GraphicsPipelineBuilder& GraphicsPipelineBuilder::set_specialization(vk::ShaderStageFlagBits stage, uint32_t constant_id, T value) {
+		if constexpr (std::is_same_v<T, bool>) {
+			const vk::Bool32 b = value ? VK_TRUE : VK_FALSE;
+			return set_specialization_data(stage, constant_id, &b, sizeof(b));
+		} else {
+			static_assert(std::is_arithmetic_v<T> && (sizeof(T) == 4 || sizeof(T) == 8), "[GraphicsPipelineBuilder] (set_specialization) T must be a 32 or 64 bit scalar");
+			return set_specialization_data(stage, constant_id, &value, sizeof(T));
+		}
+	}
+
+	class OVK_API ComputePipeline : public DeviceObject<vk::Pipeline> {
+	public:
+		UniqueHandle<vk::PipelineLayout> layout;
+		// Generated by ComputePipelineBuilder::use_reflection (indexed by set), empty if the layouts were given explicitly
+		std::vector<DescriptorTemplate> descriptor_templates;
+		// From the shader (local_size_x/y/z), to compute the group count of a dispatch
+		glm::uvec3 local_size = glm::uvec3(1);
+	private:
+		friend ComputePipelineBuilder;
+		ComputePipeline(vk::Pipeline pipeline_handle, vk::PipelineLayout layout, Device* device);
+	};
+
 }
@@ -4,6 +4,7 @@
 #include "gui/gui_renderer.h"
 
 #include "device.h"
+#include "gpu_profiler.h"
 #include <map>
 #include <variant>
 
@@ -26,6 +27,7 @@ namespace ovk {
 			}
 			clear_values.push_back(clear_value);
 		}
+		if (profiler) profiler->suspend_statistics(cmd_handle);
 		cmd_handle.beginRenderPass({
 			rp.handle.get(),
 			fb.handle.get(),
@@ -33,6 +35,7 @@ namespace ovk {
 			static_cast<uint32_t>(clear_values.size()),
 			clear_values.data()
 			}, subass_behavior);
+		if (profiler) profiler->resume_statistics(cmd_handle);
 
 	}
 
@@ -40,6 +43,19 @@ namespace ovk {
 		cmd_handle.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.handle.get());
 	}
 
+	void RenderCommand::set_viewport(glm::vec2 origin, glm::vec2 extent, float min_depth, float max_depth) const {
+		cmd_handle.setViewport(0, vk::Viewport(origin.x, origin.y, extent.x, extent.y, min_depth, max_depth));
+	}
+
+	void RenderCommand::set_scissor(vk::Offset2D offset, vk::Extent2D extent) const {
+		cmd_handle.setScissor(0, vk::Rect2D(offset, extent));
+	}
+
+	void RenderCommand::set_viewport_scissor(vk::Extent2D extent) const {
+		set_viewport(glm::vec2(0, 0), glm::vec2(extent.width, extent.height));
+		set_scissor(vk::Offset2D(0, 0), extent);
+	}
+
 
 	void RenderCommand::bind_vertex_buffers(uint32_t first_binding, std::vector<BufferDescription> descriptions) const {
 		std::vector<vk::Buffer> buffers;
@@ -77,12 +93,56 @@ namespace ovk {
 		cmd_handle.draw(vertex_count, instance_count, first_vertex, first_instance);
 	}
 
+	void RenderCommand::bind_compute_pipeline(const ovk::ComputePipeline &pipeline) const {
+		cmd_handle.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.handle.get());
+	}
+
+	void RenderCommand::bind_descriptor_sets(ComputePipeline &pipe, uint32_t first_set, std::vector<vk::DescriptorSet> sets, std::vector<uint32_t> dynamic_offsets) const {
+		cmd_handle.bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipe.layout.get(), first_set, sets, dynamic_offsets);
+	}
+
+	void RenderCommand::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) const {
+		cmd_handle.dispatch(group_count_x, group_count_y, group_count_z);
+	}
+
+	void RenderCommand::dispatch_threads(const ComputePipeline &pipeline, glm::uvec3 thread_count) const {
+		const auto groups = (thread_count + pipeline.local_size - glm::uvec3(1)) / pipeline.local_size;
+		dispatch(groups.x, groups.y, groups.z);
+	}
+
+	void RenderCommand::dispatch_indirect(const Buffer &buffer, vk::DeviceSize offset) const {
+		cmd_handle.dispatchIndirect(buffer.handle.get(), offset);
+	}
+
+	void RenderCommand::memory_barrier(vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) const {
+		const vk::MemoryBarrier barrier{ src_access, dst_access };
+		cmd_handle.pipelineBarrier(src_stage, dst_stage, {}, { barrier }, {}, {});
+	}
+
+	void RenderCommand::buffer_barrier(const Buffer &buffer, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access,
+		uint32_t src_family, uint32_t dst_family) const {
+		const vk::BufferMemoryBarrier barrier{ src_access, dst_access, src_family, dst_family, buffer.handle.get(), 0, VK_WHOLE_SIZE };
+		cmd_handle.pipelineBarrier(src_stage, dst_stage, {}, {}, { barrier }, {});
+	}
+
+	void RenderCommand::image_barrier(vk::Image image, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access,
+		vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access, uint32_t src_family, uint32_t dst_family, vk::ImageAspectFlags aspect) const {
+		const vk::ImageMemoryBarrier barrier{
+			src_access, dst_access,
+			old_layout, new_layout,
+			src_family, dst_family,
+			image,
+			vk::ImageSubresourceRange(aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS)
+		};
+		cmd_handle.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, { barrier });
+	}
+
 	void RenderCommand::draw_imgui(ImGuiRenderer &renderer, int index, ImDrawData *draw_data) {
 		renderer.cmd_render_imgui(*this, *device, index, draw_data);
 	}
 	
-#ifdef OVK_RENDERDOC_COMPAT
 	void RenderCommand::annotate(const std::string &annotation, glm::vec4 color) {
+#ifdef OVK_RENDERDOC_COMPAT
 		assert(device);
 		if (!device->debug_marker.insert) return;
 
@@ -91,10 +151,13 @@ namespace ovk {
 		memcpy(marker_info.color, &color[0], sizeof(float) * 4);
 		marker_info.pMarkerName = annotation.c_str();
 		device->debug_marker.insert(cmd_handle, &marker_info);
-		
+#endif
 	}
 
 	void RenderCommand::begin_region(const std::string &name, glm::vec4 color) {
+		if (profiler) profiler->begin_region(cmd_handle, name, color);
+
+#ifdef OVK_RENDERDOC_COMPAT
 		assert(device);
 		if (!device->debug_marker.begin) return;
 
@@ -103,28 +166,31 @@ namespace ovk {
 		memcpy(marker_info.color, &color[0], sizeof(float) * 4);
 		marker_info.pMarkerName = name.c_str();
 		device->debug_marker.begin(cmd_handle, &marker_info);
-		
+#endif
 	}
 
 	void RenderCommand::end_region() {
+		if (profiler) profiler->end_region(cmd_handle);
+
+#ifdef OVK_RENDERDOC_COMPAT
 		assert(device);
 		if (!device->debug_marker.end) return;
 
 		device->debug_marker.end(cmd_handle);
-	}
-#else
-	void RenderCommand::annotate(const std::string &annotation, glm::vec4 color) {
-	}
-
-	void RenderCommand::begin_region(const std::string &name, glm::vec4 color) {
+#endif
 	}
 
-	void RenderCommand::end_region() {
+	void RenderCommand::next_subpass(vk::SubpassContents subpass_behavior) const {
+		// Statistics queries can not span subpasses either
+		if (profiler) profiler->suspend_statistics(cmd_handle);
+		cmd_handle.nextSubpass(subpass_behavior);
+		if (profiler) profiler->resume_statistics(cmd_handle);
 	}
-#endif
 
 	void RenderCommand::end_render_pass() const {
+		if (profiler) profiler->suspend_statistics(cmd_handle);
 		cmd_handle.endRenderPass();
+		if (profiler) profiler->resume_statistics(cmd_handle);
 	}
 
 	void RenderCommand::copy(ovk::Buffer& src, uint32_t src_offset, ovk::Buffer& dst, uint32_t dst_offset, uint32_t size) {
@@ -153,4 +219,8 @@ namespace ovk {
 	void RenderCommand::push_constant_impl(GraphicsPipeline &pipeline, vk::ShaderStageFlags stage, uint32_t offset, uint32_t size, void *data) const {
 		cmd_handle.pushConstants(pipeline.layout.get(), stage, offset, size, data);
 	}
+
+	void RenderCommand::push_constant_impl(ComputePipeline &pipeline, uint32_t offset, uint32_t size, void *data) const {
+		cmd_handle.pushConstants(pipeline.layout.get(), vk::ShaderStageFlagBits::eCompute, offset, size, data);
+	}
 }
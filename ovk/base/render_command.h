@@ -8,9 +8,11 @@
 namespace ovk {
 	class ImGuiRenderer;
 	class GraphicsPipeline;
+	class ComputePipeline;
 	class Framebuffer;
 	class RenderPass;
 	class SwapChain;
+	class GpuProfiler;
 
 	class Device;
 
@@ -23,6 +25,12 @@ namespace ovk {
 
 	void bind_graphics_pipeline(const ovk::GraphicsPipeline& pipeline) const;
 
+	// For pipelines built with GraphicsPipelineBuilder::set_dynamic_viewport_scissor
+	void set_viewport(glm::vec2 origin, glm::vec2 extent, float min_depth = 0.0f, float max_depth = 1.0f) const;
+	void set_scissor(vk::Offset2D offset, vk::Extent2D extent) const;
+	// Viewport and scissor covering the whole extent
+	void set_viewport_scissor(vk::Extent2D extent) const;
+
 	struct BufferDescription {
 		std::reference_wrapper<ovk::Buffer> buffer;
 		vk::DeviceSize offset;
@@ -35,10 +43,36 @@ namespace ovk {
 	template<typename T>
 	void push_constant(T& data, GraphicsPipeline &pipeline, vk::ShaderStageFlags stage, uint32_t offset = 0);
 
+	// Compute
+	void bind_compute_pipeline(const ovk::ComputePipeline& pipeline) const;
+	void bind_descriptor_sets(ComputePipeline& pipe, uint32_t first_set, std::vector<vk::DescriptorSet> sets, std::vector<uint32_t> dynamic_offsets = {}) const;
+
+	template<typename T>
+	void push_constant(T& data, ComputePipeline &pipeline, uint32_t offset = 0);
+
+	void dispatch(uint32_t group_count_x, uint32_t group_count_y = 1, uint32_t group_count_z = 1) const;
+	// Enough groups (of the local size of the pipeline) to cover thread_count invocations
+	void dispatch_threads(const ComputePipeline& pipeline, glm::uvec3 thread_count) const;
+	// Group counts are read from a vk::DispatchIndirectCommand in buffer (eg. written by a culling shader)
+	void dispatch_indirect(const Buffer& buffer, vk::DeviceSize offset = 0) const;
+
+	// Barriers
+	// Dependency between commands of this buffer (eg. a compute shader writes a buffer the vertex shader reads)
+	void memory_barrier(vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access) const;
+	// With different queue families this is one half of an ownership transfer: record it with the same arguments
+	// on the releasing queue and on the acquiring queue (after waiting on the semaphore of the release submit)
+	void buffer_barrier(const Buffer& buffer, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access, vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access,
+		uint32_t src_family = VK_QUEUE_FAMILY_IGNORED, uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED) const;
+	void image_barrier(vk::Image image, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::PipelineStageFlags src_stage, vk::AccessFlags src_access,
+		vk::PipelineStageFlags dst_stage, vk::AccessFlags dst_access, uint32_t src_family = VK_QUEUE_FAMILY_IGNORED, uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED,
+		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor) const;
+
 	void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance) const;
 	void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) const;
 
 	void draw_imgui(ImGuiRenderer& renderer, int index, ImDrawData *draw_data);
+
+	void next_subpass(vk::SubpassContents subpass_behavior = vk::SubpassContents::eInline) const;
 		
 	void end_render_pass() const;
 
@@ -52,15 +86,19 @@ namespace ovk {
 		
 	private:
 	friend Device;
+	friend GpuProfiler;
 	RenderCommand(vk::CommandBuffer raw_handle, Device &d);
 
 	void start() const;
 	void end() const;
 
 	void push_constant_impl(GraphicsPipeline& pipeline, vk::ShaderStageFlags stage, uint32_t offset, uint32_t size, void* data) const;
+	void push_constant_impl(ComputePipeline& pipeline, uint32_t offset, uint32_t size, void* data) const;
 		
 	// Only valid during recording through device
 	Device* device;
+	// Set between GpuProfiler::begin_frame and end_frame, regions will then also write timestamps
+	GpuProfiler* profiler = nullptr;
 	};
 
 	template <typename T>
@@ -68,4 +106,9 @@ namespace ovk {
 		push_constant_impl(pipeline, stage, offset, sizeof(T), &data);
 	}
 
+	template <typename T>
+	void RenderCommand::push_constant(T &data, ComputePipeline &pipeline, uint32_t offset) {
+		push_constant_impl(pipeline, offset, sizeof(T), &data);
+	}
+
 }
@@ -3,6 +3,8 @@
 
 
 #include "device.h"
+#include "image.h"
+#include <algorithm>
 #include <optional>
 
 namespace ovk {
@@ -19,7 +21,7 @@ namespace ovk {
 	}
 
 	template <typename T>
-	std::optional<uint32_t> find_index(std::vector<T>& vec, T& e) {
+	std::optional<uint32_t> find_index(const std::vector<T>& vec, const T& e) {
 		for (auto i = 0; i < vec.size(); i++) {
 			if (vec[i] == e) return i;
 		}
@@ -62,6 +64,10 @@ namespace ovk {
 
 			// Input attachments
 			vk_subpass.input = get_references(attachments, subpass.input, vk::ImageLayout::eShaderReadOnlyOptimal, i);
+			for (auto& ref : vk_subpass.input) {
+				if (is_depth_format(attachments[ref.attachment].format))
+					ref.layout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+			}
 			vk_subpass.color = get_references(attachments, subpass.color, vk::ImageLayout::eColorAttachmentOptimal, i);
 			// TODO: WHAT LAYOUT?
 			vk_subpass.resolve = get_references(attachments, subpass.resolve,  vk::ImageLayout::eUndefined, i);
@@ -90,18 +96,91 @@ namespace ovk {
 
 		}
 
-		// TODO: THINK ABOUT DEPENDENCIES
 		std::vector<vk::SubpassDependency> dependencies;
 
+		const auto contains = [](const std::vector<vk::AttachmentDescription>& list, const vk::AttachmentDescription& a) {
+			return std::find(list.begin(), list.end(), a) != list.end();
+		};
+		const auto has_depth = [&](const GraphicSubpass& subpass) {
+			return find_index(attachments, subpass.depth_stencil).has_value();
+		};
+
 		if (add_external_dependency) {
-			dependencies.push_back(vk::SubpassDependency {
-				VK_SUBPASS_EXTERNAL, 0,
-				vk::PipelineStageFlagBits::eColorAttachmentOutput,
-				vk::PipelineStageFlagBits::eColorAttachmentOutput,
-				{},
-				vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
-			});
+			// Wait for the previous use of the attachments (eg. the last frame or the acquire of the swapchain image)
+			// in every subpass that uses an attachment first, the layout transition happens right before that subpass
+			const vk::PipelineStageFlags stages = vk::PipelineStageFlagBits::eColorAttachmentOutput
+				| vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+
+			std::vector<vk::AttachmentDescription> used;
+			for (uint32_t i = 0; i < subpasses.size(); i++) {
+				const auto& subpass = subpasses[i];
+				auto subpass_attachments = subpass.input;
+				subpass_attachments.insert(subpass_attachments.end(), subpass.color.begin(), subpass.color.end());
+				if (has_depth(subpass)) subpass_attachments.push_back(subpass.depth_stencil);
+
+				bool first_use = false;
+				for (const auto& a : subpass_attachments) {
+					if (contains(used, a)) continue;
+					used.push_back(a);
+					first_use = true;
+				}
+				if (!first_use) continue;
+
+				dependencies.push_back(vk::SubpassDependency {
+					VK_SUBPASS_EXTERNAL, i,
+					stages,
+					stages,
+					{},
+					vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite
+						| vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite
+				});
+			}
+
+		}
 
+		// Every subpass waits for the earlier subpasses that wrote one of its attachments (eg. G-buffer -> lighting)
+		// By region, so each tile only waits for itself and tilers keep the attachments in tile memory
+
+		for (uint32_t dst = 1; dst < subpasses.size(); dst++) {
+			const auto& reader = subpasses[dst];
+
+			for (uint32_t src = 0; src < dst; src++) {
+				const auto& writer = subpasses[src];
+
+				vk::SubpassDependency dependency{ src, dst };
+				dependency.dependencyFlags = vk::DependencyFlagBits::eByRegion;
+
+				const auto add_use = [&](const vk::AttachmentDescription& written, vk::PipelineStageFlags src_stages, vk::AccessFlags src_access) {
+					vk::PipelineStageFlags dst_stages;
+					vk::AccessFlags dst_access;
+					if (contains(reader.input, written)) {
+						dst_stages |= vk::PipelineStageFlagBits::eFragmentShader;
+						dst_access |= vk::AccessFlagBits::eInputAttachmentRead;
+					}
+					if (contains(reader.color, written)) {
+						dst_stages |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+						dst_access |= vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+					}
+					if (has_depth(reader) && reader.depth_stencil == written) {
+						dst_stages |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+						dst_access |= vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+					}
+					if (!dst_stages) return;
+
+					dependency.srcStageMask |= src_stages;
+					dependency.srcAccessMask |= src_access;
+					dependency.dstStageMask |= dst_stages;
+					dependency.dstAccessMask |= dst_access;
+				};
+
+				for (const auto& written : writer.color)
+					add_use(written, vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::AccessFlagBits::eColorAttachmentWrite);
+				if (has_depth(writer))
+					add_use(writer.depth_stencil, vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests, vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+
+				if (dependency.srcStageMask)
+					dependencies.push_back(dependency);
+			}
 		}
 
 		std::vector<vk::SubpassDescription> s_passes; s_passes.reserve(vk_subpasses.size());
@@ -119,5 +198,30 @@ namespace ovk {
 
 		handle.set(VK_CREATE(d.device->createRenderPass(create_info), "Failed to create RenderPass"));
 
+		// FNV-1a over the fields, the structs themselves contain pointers
+		compatibility_hash = 14695981039346656037ull;
+		const auto hash = [this](uint32_t word) { compatibility_hash = (compatibility_hash ^ word) * 1099511628211ull; };
+		const auto hash_references = [&hash](const std::vector<vk::AttachmentReference>& refs) {
+			hash(static_cast<uint32_t>(refs.size()));
+			for (auto& ref : refs) { hash(ref.attachment); hash(static_cast<uint32_t>(ref.layout)); }
+		};
+
+		hash(static_cast<uint32_t>(attachments.size()));
+		for (auto& a : attachments) {
+			hash(static_cast<uint32_t>(a.format));
+			hash(static_cast<uint32_t>(a.samples));
+			hash(static_cast<uint32_t>(a.loadOp));
+			hash(static_cast<uint32_t>(a.stencilLoadOp));
+		}
+		hash(static_cast<uint32_t>(vk_subpasses.size()));
+		for (auto& sub : vk_subpasses) {
+			hash_references(sub.input);
+			hash_references(sub.color);
+			hash_references(sub.resolve);
+			hash(sub.depth.has_value() ? sub.depth->attachment : VK_ATTACHMENT_UNUSED);
+			hash(static_cast<uint32_t>(sub.preserve.size()));
+			for (auto p : sub.preserve) hash(p);
+		}
+
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
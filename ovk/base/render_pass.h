@@ -4,6 +4,8 @@
 
 namespace ovk {
 
+	// Attachments are identified by their description, so two attachments of one render pass need different descriptions
+	// (eg. different formats). Dependencies between subpasses are generated from the attachments they share
 	struct OVK_API GraphicSubpass {
 
 		explicit GraphicSubpass(std::vector<vk::AttachmentDescription> input = {},
@@ -20,6 +22,11 @@ namespace ovk {
 	class OVK_API RenderPass : public DeviceObject<vk::RenderPass> {
 		friend class Device;
 		RenderPass(std::vector<vk::AttachmentDescription> attachments, std::vector<GraphicSubpass> subpasses, bool add_external_dependency, Device& d);
+
+	public:
+		// Hash of what makes pipelines compatible with this pass (attachment formats, samples and load ops, and the
+		// attachment references of every subpass). Pipeline hashes use it instead of the handle, which the driver may reuse
+		uint64_t compatibility_hash = 0;
 	};
 
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "shader_compiler.h"
+
+#include "device.h"
+#include "util/profiler.h"
+
+#include <shaderc/shaderc.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+namespace ovk {
+
+	namespace {
+
+		// Bump if the compile options change, so old cache entries are not picked up anymore
+		constexpr uint32_t cache_version = 2;
+
+		std::optional<shaderc_shader_kind> shader_kind(vk::ShaderStageFlagBits stage) {
+			switch (stage) {
+			case vk::ShaderStageFlagBits::eVertex: return shaderc_glsl_vertex_shader;
+			case vk::ShaderStageFlagBits::eFragment: return shaderc_glsl_fragment_shader;
+			case vk::ShaderStageFlagBits::eCompute: return shaderc_glsl_compute_shader;
+			case vk::ShaderStageFlagBits::eGeometry: return shaderc_glsl_geometry_shader;
+			case vk::ShaderStageFlagBits::eTessellationControl: return shaderc_glsl_tess_control_shader;
+			case vk::ShaderStageFlagBits::eTessellationEvaluation: return shaderc_glsl_tess_evaluation_shader;
+			default: return std::nullopt;
+			}
+		}
+
+		std::optional<std::string> read_text_file(const std::string& path) {
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open()) return std::nullopt;
+			std::stringstream ss;
+			ss << file.rdbuf();
+			return ss.str();
+		}
+
+		uint64_t fnv1a(const void* data, size_t size, uint64_t value = 14695981039346656037ull) {
+			const auto* p = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++) {
+				value ^= p[i];
+				value *= 1099511628211ull;
+			}
+			return value;
+		}
+
+		// Resolves #include "file" relative to the including file and #include <file> relative to the working directory
+		class Includer : public shaderc::CompileOptions::IncluderInterface {
+		public:
+			shaderc_include_result* GetInclude(const char* requested_source, shaderc_include_type type, const char* requesting_source, size_t include_depth) override {
+				auto path = std::filesystem::path(requested_source);
+				if (type == shaderc_include_type_relative)
+					path = std::filesystem::path(requesting_source).parent_path() / path;
+
+				auto* data = new Data;
+				if (auto content = read_text_file(path.string())) {
+					data->name = path.generic_string();
+					data->content = std::move(*content);
+				} else {
+					// An empty name signals an error, the content is the message then
+					data->content = fmt::format("failed to open {}", path.string());
+				}
+
+				data->result = { data->name.c_str(), data->name.size(), data->content.c_str(), data->content.size(), data };
+				return &data->result;
+			}
+
+			void ReleaseInclude(shaderc_include_result* result) override {
+				delete static_cast<Data*>(result->user_data);
+			}
+
+		private:
+			struct Data {
+				std::string name, content;
+				shaderc_include_result result;
+			};
+		};
+
+		shaderc::CompileOptions make_options() {
+			shaderc::CompileOptions options;
+			// Instance creates a Vulkan 1.1 instance, which only guarantees SPIR-V 1.3 (1.2 would emit 1.5)
+			options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_1);
+			options.SetIncluder(std::make_unique<Includer>());
+#if defined(RELEASE)
+			options.SetOptimizationLevel(shaderc_optimization_level_performance);
+#else
+			// Keep the source readable in RenderDoc
+			options.SetOptimizationLevel(shaderc_optimization_level_zero);
+			options.SetGenerateDebugInfo();
+#endif
+			return options;
+		}
+
+	}
+
+	ShaderCompiler::ShaderCompiler(std::string cache_directory)
+		: compiler(std::make_unique<shaderc::Compiler>()), cache_directory(std::move(cache_directory)) {}
+
+	ShaderCompiler::~ShaderCompiler() = default;
+
+	void ShaderCompiler::set_cache_directory(const std::string &directory) {
+		cache_directory = directory;
+	}
+
+	std::optional<std::vector<uint32_t>> ShaderCompiler::compile_file(const std::string &file_path, vk::ShaderStageFlagBits stage) const {
+		const auto source = read_text_file(file_path);
+		if (!source) {
+			spdlog::error("[ShaderCompiler] (compile_file) failed to open {}", file_path);
+			return std::nullopt;
+		}
+		return compile(*source, file_path, stage);
+	}
+
+	std::optional<std::vector<uint32_t>> ShaderCompiler::compile(const std::string &source, const std::string &name, vk::ShaderStageFlagBits stage) const {
+		OVK_PROFILE_SCOPE("ShaderCompiler::compile");
+
+		const auto kind = shader_kind(stage);
+		if (!kind) {
+			spdlog::error("[ShaderCompiler] (compile) {}: unsupported stage {}", name, vk::to_string(stage));
+			return std::nullopt;
+		}
+
+		const auto options = make_options();
+
+		// Preprocessing is cheap compared to compiling and resolves the includes, so the hash covers them too
+		const auto preprocessed = compiler->PreprocessGlsl(source, *kind, name.c_str(), options);
+		if (preprocessed.GetCompilationStatus() != shaderc_compilation_status_success) {
+			spdlog::error("[ShaderCompiler] (compile) failed to preprocess {}:\n{}", name, preprocessed.GetErrorMessage());
+			return std::nullopt;
+		}
+		const std::string text(preprocessed.cbegin(), preprocessed.cend());
+
+		std::filesystem::path cache_path;
+		if (!cache_directory.empty()) {
+#if defined(RELEASE)
+			constexpr uint32_t config = 1;
+#else
+			constexpr uint32_t config = 0;
+#endif
+			const uint32_t key_info[] = { cache_version, config, static_cast<uint32_t>(*kind) };
+			const auto hash = fnv1a(text.data(), text.size(), fnv1a(key_info, sizeof(key_info)));
+			cache_path = std::filesystem::path(cache_directory) / fmt::format("{:016x}.spv", hash);
+
+			std::ifstream cached(cache_path, std::ios::binary | std::ios::ate);
+			if (cached.is_open()) {
+				const auto size = static_cast<size_t>(cached.tellg());
+				std::vector<uint32_t> code(size / sizeof(uint32_t));
+				cached.seekg(0);
+				if (size % sizeof(uint32_t) == 0 && cached.read(reinterpret_cast<char*>(code.data()), size)) return code;
+				spdlog::warn("[ShaderCompiler] (compile) ignoring corrupt cache entry {}", cache_path.string());
+			}
+		}
+
+		const auto result = compiler->CompileGlslToSpv(text, *kind, name.c_str(), options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			spdlog::error("[ShaderCompiler] (compile) failed to compile {}:\n{}", name, result.GetErrorMessage());
+			return std::nullopt;
+		}
+		if (result.GetNumWarnings() > 0) spdlog::warn("[ShaderCompiler] (compile) {}:\n{}", name, result.GetErrorMessage());
+
+		std::vector<uint32_t> code(result.cbegin(), result.cend());
+		spdlog::info("[ShaderCompiler] (compile) compiled {}", name);
+
+		if (!cache_path.empty()) {
+			// Write to a temporary file first, a crash must not leave a truncated entry behind
+			std::error_code ec;
+			std::filesystem::create_directories(cache_directory, ec);
+			auto tmp_path = cache_path;
+			tmp_path += ".tmp";
+			{
+				std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+				file.write(reinterpret_cast<const char*>(code.data()), code.size() * sizeof(uint32_t));
+			}
+			std::filesystem::rename(tmp_path, cache_path, ec);
+			if (ec) spdlog::warn("[ShaderCompiler] (compile) failed to write cache entry {}: {}", cache_path.string(), ec.message());
+		}
+
+		return code;
+	}
+
+	ShaderWatcher::ShaderWatcher(Device &d, std::chrono::milliseconds interval)
+		: device(&d), interval(interval), last_poll(std::chrono::steady_clock::now()) {}
+
+	size_t ShaderWatcher::poll() {
+		const auto now = std::chrono::steady_clock::now();
+		if (now - last_poll < interval) return 0;
+		last_poll = now;
+
+		auto& registry = device->get_pipeline_registry();
+
+		std::unordered_set<std::string> changed;
+		for (auto& file : registry.get_shader_files()) {
+			std::error_code ec;
+			const auto time = std::filesystem::last_write_time(file, ec);
+			if (ec) continue;
+
+			// Files we see for the first time only get their timestamp recorded
+			auto [it, inserted] = timestamps.try_emplace(file, time);
+			if (!inserted && it->second != time) {
+				it->second = time;
+				changed.insert(file);
+			}
+		}
+		if (changed.empty()) return 0;
+
+		for (auto& file : changed) spdlog::info("[ShaderWatcher] (poll) {} changed", file);
+
+		// The old pipelines are destroyed while rebuilding
+		device->wait_idle();
+		const auto rebuilt = registry.reload(changed);
+
+		spdlog::info("[ShaderWatcher] (poll) rebuilt {} pipelines", rebuilt);
+		return rebuilt;
+	}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "handle.h"
+
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+
+namespace shaderc {
+	class Compiler;
+}
+
+namespace ovk {
+	class Device;
+
+	/**
+	 * \brief Compiles GLSL to SPIR-V at runtime (shaderc, ships with the Vulkan SDK)
+	 *				Results are cached on disk, keyed by the hash of the preprocessed source (so includes count) and the compile options.
+	 *				Unchanged shaders are therefore only read from the cache, even across runs
+	 */
+	class OVK_API ShaderCompiler {
+	public:
+		explicit ShaderCompiler(std::string cache_directory = "shader_cache");
+		~ShaderCompiler();
+
+		ShaderCompiler(const ShaderCompiler& other) = delete;
+		ShaderCompiler& operator=(const ShaderCompiler& other) = delete;
+
+		// Errors are logged, std::nullopt is returned then
+		[[nodiscard]] std::optional<std::vector<uint32_t>> compile_file(const std::string& file_path, vk::ShaderStageFlagBits stage) const;
+		// name is used for error messages and to resolve relative includes
+		[[nodiscard]] std::optional<std::vector<uint32_t>> compile(const std::string& source, const std::string& name, vk::ShaderStageFlagBits stage) const;
+
+		// Empty disables the disk cache
+		void set_cache_directory(const std::string& directory);
+
+	private:
+		std::unique_ptr<shaderc::Compiler> compiler;
+		std::string cache_directory;
+	};
+
+	/**
+	 * \brief Hot reload for pipelines in the registry of the device (GraphicsPipelineBuilder::build_cached/build_async)
+	 *				Polls the modification time of every shader file those pipelines were built from (GLSL or SPIR-V) and
+	 *				rebuilds only the pipelines that use a changed file. The pipeline objects are updated in place, so everybody
+	 *				holding one picks up the new version the next time a command buffer is recorded.
+	 *				If a shader fails to compile the old pipeline is kept
+	 */
+	class OVK_API ShaderWatcher {
+	public:
+		explicit ShaderWatcher(Device& device, std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+		// Call once per frame (outside of command buffer recording), waits for the device to idle if something changed
+		// Returns the number of rebuilt pipelines
+		size_t poll();
+
+	private:
+		Device* device;
+		std::chrono::milliseconds interval;
+		std::chrono::steady_clock::time_point last_poll;
+		std::unordered_map<std::string, std::filesystem::file_time_type> timestamps;
+	};
+
+}
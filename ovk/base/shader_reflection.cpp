@@ -0,0 +1,419 @@
+#include "pch.h"
+#include "shader_reflection.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+
+namespace ovk {
+
+	// The subset of the SPIR-V spec (https://www.khronos.org/registry/spir-v/specs/unified1/SPIRV.html) we need
+	namespace spirv {
+		constexpr uint32_t magic = 0x07230203;
+		constexpr size_t header_words = 5;
+
+		enum Op : uint32_t {
+			OpName = 5,
+			OpExecutionMode = 16,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpSpecConstant = 50,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+		};
+
+		enum ExecutionMode : uint32_t {
+			LocalSize = 17,
+		};
+
+		enum Decoration : uint32_t {
+			Block = 2,
+			BufferBlock = 3,
+			ArrayStride = 6,
+			MatrixStride = 7,
+			BuiltIn = 11,
+			Location = 30,
+			Binding = 33,
+			DescriptorSet = 34,
+			Offset = 35,
+		};
+
+		enum StorageClass : uint32_t {
+			UniformConstant = 0,
+			Input = 1,
+			Uniform = 2,
+			PushConstant = 9,
+			StorageBuffer = 12,
+		};
+
+		enum Dim : uint32_t {
+			DimBuffer = 5,
+			DimSubpassData = 6,
+		};
+	}
+
+	namespace {
+
+		struct Decorations {
+			std::optional<uint32_t> set, binding, location, offset, array_stride, matrix_stride;
+			bool block = false, buffer_block = false, builtin = false;
+
+			void apply(uint32_t decoration, const uint32_t* literals, uint32_t literal_count) {
+				std::optional<uint32_t> literal;
+				if (literal_count > 0) literal = literals[0];
+				switch (decoration) {
+				case spirv::Block: block = true; break;
+				case spirv::BufferBlock: buffer_block = true; break;
+				case spirv::BuiltIn: builtin = true; break;
+				case spirv::ArrayStride: array_stride = literal; break;
+				case spirv::MatrixStride: matrix_stride = literal; break;
+				case spirv::Location: location = literal; break;
+				case spirv::Binding: binding = literal; break;
+				case spirv::DescriptorSet: set = literal; break;
+				case spirv::Offset: offset = literal; break;
+				default: break;
+				}
+			}
+		};
+
+		struct Type {
+			uint32_t op;
+			// Everything after the result id
+			std::vector<uint32_t> operands;
+		};
+
+		struct Variable {
+			uint32_t id, pointer_type, storage;
+		};
+
+		struct Module {
+			std::unordered_map<uint32_t, Type> types;
+			std::unordered_map<uint32_t, uint32_t> constants;
+			std::unordered_map<uint32_t, Decorations> decorations;
+			std::unordered_map<uint32_t, std::vector<Decorations>> member_decorations;
+			std::unordered_map<uint32_t, std::string> names;
+			std::vector<Variable> variables;
+
+			const Type* type(uint32_t id) const {
+				const auto it = types.find(id);
+				return it != types.end() ? &it->second : nullptr;
+			}
+
+			const Decorations& decoration(uint32_t id) const {
+				static const Decorations none;
+				const auto it = decorations.find(id);
+				return it != decorations.end() ? it->second : none;
+			}
+
+			const Decorations& member_decoration(uint32_t id, uint32_t member) const {
+				static const Decorations none;
+				const auto it = member_decorations.find(id);
+				return it != member_decorations.end() && member < it->second.size() ? it->second[member] : none;
+			}
+
+			std::string name(uint32_t id) const {
+				const auto it = names.find(id);
+				return it != names.end() ? it->second : "";
+			}
+
+			// Size in bytes as laid out in a buffer (honours the explicit offsets and strides)
+			uint32_t size_of(uint32_t id, std::optional<uint32_t> matrix_stride = std::nullopt) const {
+				const auto* t = type(id);
+				if (!t) return 0;
+
+				switch (t->op) {
+				case spirv::OpTypeInt:
+				case spirv::OpTypeFloat:
+					return t->operands[0] / 8;
+				case spirv::OpTypeVector:
+					return t->operands[1] * size_of(t->operands[0]);
+				case spirv::OpTypeMatrix:
+					return t->operands[1] * matrix_stride.value_or(size_of(t->operands[0]));
+				case spirv::OpTypeArray: {
+					const auto length = constants.count(t->operands[1]) ? constants.at(t->operands[1]) : 0;
+					return length * decoration(id).array_stride.value_or(size_of(t->operands[0]));
+				}
+				case spirv::OpTypeStruct: {
+					uint32_t size = 0, running_offset = 0;
+					for (uint32_t m = 0; m < t->operands.size(); m++) {
+						const auto& member = member_decoration(id, m);
+						const auto offset = member.offset.value_or(running_offset);
+						running_offset = offset + size_of(t->operands[m], member.matrix_stride);
+						size = std::max(size, running_offset);
+					}
+					return size;
+				}
+				default:
+					return 0;
+				}
+			}
+
+			std::optional<vk::DescriptorType> descriptor_type(uint32_t id, uint32_t storage) const {
+				const auto* t = type(id);
+				if (!t) return std::nullopt;
+
+				switch (t->op) {
+				case spirv::OpTypeSampledImage:
+					return vk::DescriptorType::eCombinedImageSampler;
+				case spirv::OpTypeSampler:
+					return vk::DescriptorType::eSampler;
+				case spirv::OpTypeImage: {
+					if (t->operands.size() < 6) return std::nullopt;
+					const auto dim = t->operands[1];
+					const auto sampled = t->operands[5];
+					if (dim == spirv::DimSubpassData) return vk::DescriptorType::eInputAttachment;
+					if (dim == spirv::DimBuffer) return sampled == 2 ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+					return sampled == 2 ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+				}
+				case spirv::OpTypeStruct:
+					if (storage == spirv::StorageBuffer || decoration(id).buffer_block) return vk::DescriptorType::eStorageBuffer;
+					return vk::DescriptorType::eUniformBuffer;
+				default:
+					return std::nullopt;
+				}
+			}
+
+			vk::Format vector_format(uint32_t id) const {
+				const auto* t = type(id);
+				if (!t) return vk::Format::eUndefined;
+
+				uint32_t components = 1;
+				if (t->op == spirv::OpTypeVector) {
+					components = t->operands[1];
+					t = type(t->operands[0]);
+				}
+				if (!t || t->operands.empty() || components < 1 || components > 4) return vk::Format::eUndefined;
+
+				const auto width = t->operands[0];
+				if (t->op == spirv::OpTypeFloat && width == 32) {
+					constexpr vk::Format formats[] = { vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+					return formats[components - 1];
+				}
+				if (t->op == spirv::OpTypeFloat && width == 64) {
+					constexpr vk::Format formats[] = { vk::Format::eR64Sfloat, vk::Format::eR64G64Sfloat, vk::Format::eR64G64B64Sfloat, vk::Format::eR64G64B64A64Sfloat };
+					return formats[components - 1];
+				}
+				if (t->op == spirv::OpTypeInt && width == 32) {
+					const auto is_signed = t->operands[1] == 1;
+					constexpr vk::Format sint[] = { vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+					constexpr vk::Format uint[] = { vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+					return is_signed ? sint[components - 1] : uint[components - 1];
+				}
+				return vk::Format::eUndefined;
+			}
+		};
+
+		std::string read_string(const uint32_t* words, uint32_t word_count) {
+			const auto* chars = reinterpret_cast<const char*>(words);
+			return std::string(chars, strnlen(chars, word_count * sizeof(uint32_t)));
+		}
+
+	}
+
+	std::optional<ShaderReflection> ShaderReflection::reflect(const uint32_t* code, size_t word_count, vk::ShaderStageFlagBits stage) {
+		if (word_count < spirv::header_words || code[0] != spirv::magic) {
+			spdlog::error("[ShaderReflection] (reflect) {} shader is not valid SPIR-V", vk::to_string(stage));
+			return std::nullopt;
+		}
+
+		Module module;
+		std::array<uint32_t, 3> local_size = { 1, 1, 1 };
+		for (size_t i = spirv::header_words; i < word_count;) {
+			const auto op = code[i] & 0xffff;
+			const auto count = code[i] >> 16;
+			if (count == 0 || i + count > word_count) {
+				spdlog::error("[ShaderReflection] (reflect) {} shader: malformed instruction at word {}", vk::to_string(stage), i);
+				return std::nullopt;
+			}
+
+			const uint32_t* args = code + i + 1;
+			const uint32_t n = count - 1;
+
+			switch (op) {
+			case spirv::OpName:
+				if (n >= 2) module.names[args[0]] = read_string(args + 1, n - 1);
+				break;
+			case spirv::OpExecutionMode:
+				if (n >= 5 && args[1] == spirv::LocalSize) local_size = { args[2], args[3], args[4] };
+				break;
+			case spirv::OpTypeInt:
+			case spirv::OpTypeFloat:
+			case spirv::OpTypeVector:
+			case spirv::OpTypeMatrix:
+			case spirv::OpTypeImage:
+			case spirv::OpTypeSampler:
+			case spirv::OpTypeSampledImage:
+			case spirv::OpTypeArray:
+			case spirv::OpTypeRuntimeArray:
+			case spirv::OpTypeStruct:
+			case spirv::OpTypePointer:
+				if (n >= 1) module.types[args[0]] = Type{ op, std::vector<uint32_t>(args + 1, args + n) };
+				break;
+			case spirv::OpConstant:
+			// Array sizes from specialization constants are reflected with their default value
+			case spirv::OpSpecConstant:
+				if (n >= 3) module.constants[args[1]] = args[2];
+				break;
+			case spirv::OpVariable:
+				if (n >= 3) module.variables.push_back(Variable{ args[1], args[0], args[2] });
+				break;
+			case spirv::OpDecorate:
+				if (n >= 2) module.decorations[args[0]].apply(args[1], args + 2, n - 2);
+				break;
+			case spirv::OpMemberDecorate:
+				if (n >= 3) {
+					auto& members = module.member_decorations[args[0]];
+					if (members.size() <= args[1]) members.resize(args[1] + 1);
+					members[args[1]].apply(args[2], args + 3, n - 3);
+				}
+				break;
+			default:
+				break;
+			}
+
+			i += count;
+		}
+
+		ShaderReflection reflection;
+		reflection.stages = stage;
+		if (stage == vk::ShaderStageFlagBits::eCompute) reflection.local_size = local_size;
+
+		for (auto& variable : module.variables) {
+			const auto* pointer = module.type(variable.pointer_type);
+			if (!pointer || pointer->op != spirv::OpTypePointer) continue;
+			auto type_id = pointer->operands[1];
+			const auto& decoration = module.decoration(variable.id);
+
+			switch (variable.storage) {
+			case spirv::UniformConstant:
+			case spirv::Uniform:
+			case spirv::StorageBuffer: {
+				if (!decoration.binding) continue;
+
+				// Arrays of descriptors
+				uint32_t count = 1;
+				while (const auto* t = module.type(type_id)) {
+					if (t->op == spirv::OpTypeArray) {
+						count *= module.constants.count(t->operands[1]) ? module.constants.at(t->operands[1]) : 1;
+					} else if (t->op == spirv::OpTypeRuntimeArray) {
+						count = 0;
+					} else break;
+					type_id = t->operands[0];
+				}
+
+				const auto type = module.descriptor_type(type_id, variable.storage);
+				if (!type) {
+					spdlog::warn("[ShaderReflection] (reflect) {} shader: unsupported descriptor type at binding {}", vk::to_string(stage), *decoration.binding);
+					continue;
+				}
+
+				// Uniform blocks are named after the block type, the variable is the instance name
+				auto name = module.name(variable.id);
+				if (name.empty()) name = module.name(type_id);
+
+				reflection.bindings.push_back(DescriptorBinding{ decoration.set.value_or(0), *decoration.binding, *type, count, stage, name });
+				break;
+			}
+			case spirv::PushConstant: {
+				const auto* block = module.type(type_id);
+				if (!block || block->op != spirv::OpTypeStruct) continue;
+
+				uint32_t offset = UINT32_MAX;
+				for (uint32_t m = 0; m < block->operands.size(); m++)
+					offset = std::min(offset, module.member_decoration(type_id, m).offset.value_or(0));
+				if (offset == UINT32_MAX) offset = 0;
+
+				reflection.push_constant = PushConstantBlock{ offset, module.size_of(type_id) - offset, stage };
+				break;
+			}
+			case spirv::Input: {
+				if (stage != vk::ShaderStageFlagBits::eVertex) continue;
+				if (decoration.builtin || !decoration.location) continue;
+
+				const auto* t = module.type(type_id);
+				if (!t) continue;
+
+				// Matrices occupy one location per column
+				const auto columns = t->op == spirv::OpTypeMatrix ? t->operands[1] : 1;
+				const auto column_type = t->op == spirv::OpTypeMatrix ? t->operands[0] : type_id;
+
+				for (uint32_t c = 0; c < columns; c++) {
+					const auto format = module.vector_format(column_type);
+					if (format == vk::Format::eUndefined)
+						spdlog::warn("[ShaderReflection] (reflect) unsupported vertex input type at location {}", *decoration.location + c);
+					reflection.inputs.push_back(VertexInput{ *decoration.location + c, format, module.size_of(column_type), module.name(variable.id) });
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		std::sort(reflection.inputs.begin(), reflection.inputs.end(), [](const VertexInput& a, const VertexInput& b) { return a.location < b.location; });
+
+		return reflection;
+	}
+
+	bool ShaderReflection::merge(const ShaderReflection &other) {
+		for (auto& binding : other.bindings) {
+			auto it = std::find_if(bindings.begin(), bindings.end(), [&binding](const DescriptorBinding& b) {
+				return b.set == binding.set && b.binding == binding.binding;
+			});
+
+			if (it == bindings.end()) {
+				bindings.push_back(binding);
+				continue;
+			}
+
+			if (it->type != binding.type || it->count != binding.count) {
+				spdlog::error("[ShaderReflection] (merge) set {} binding {} is declared as {} ({}) and {} ({})",
+					binding.set, binding.binding, vk::to_string(it->type), vk::to_string(it->stages), vk::to_string(binding.type), vk::to_string(binding.stages));
+				return false;
+			}
+			it->stages |= binding.stages;
+		}
+
+		if (other.push_constant) {
+			if (!push_constant) {
+				push_constant = other.push_constant;
+			} else {
+				// One range visible to all stages that declare a block keeps the pipeline layout simple
+				const auto begin = std::min(push_constant->offset, other.push_constant->offset);
+				const auto end = std::max(push_constant->offset + push_constant->size, other.push_constant->offset + other.push_constant->size);
+				push_constant = PushConstantBlock{ begin, end - begin, push_constant->stages | other.push_constant->stages };
+			}
+		}
+
+		if (other.stages & vk::ShaderStageFlagBits::eVertex) inputs = other.inputs;
+		stages |= other.stages;
+
+		return true;
+	}
+
+	std::vector<ShaderReflection::DescriptorBinding> ShaderReflection::get_set(uint32_t set) const {
+		std::vector<DescriptorBinding> result;
+		std::copy_if(bindings.begin(), bindings.end(), std::back_inserter(result), [set](const DescriptorBinding& b) { return b.set == set; });
+		std::sort(result.begin(), result.end(), [](const DescriptorBinding& a, const DescriptorBinding& b) { return a.binding < b.binding; });
+		return result;
+	}
+
+	uint32_t ShaderReflection::set_count() const {
+		uint32_t count = 0;
+		for (auto& binding : bindings) count = std::max(count, binding.set + 1);
+		return count;
+	}
+
+}
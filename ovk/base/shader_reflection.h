@@ -0,0 +1,59 @@
+#pragma once
+
+#include "handle.h"
+
+#include <array>
+
+namespace ovk {
+
+	/**
+	 * \brief Minimal SPIR-V reflection (descriptor bindings, push constant block and vertex inputs)
+	 *				Only walks the declarations of the module, so everything that is declared counts as used
+	 *				(glslang does not strip unused uniforms either)
+	 */
+	struct OVK_API ShaderReflection {
+
+		struct DescriptorBinding {
+			uint32_t set = 0;
+			uint32_t binding = 0;
+			vk::DescriptorType type = vk::DescriptorType::eUniformBuffer;
+			// 0 for runtime sized arrays
+			uint32_t count = 1;
+			vk::ShaderStageFlags stages;
+			std::string name;
+		};
+
+		struct PushConstantBlock {
+			uint32_t offset = 0;
+			uint32_t size = 0;
+			vk::ShaderStageFlags stages;
+		};
+
+		struct VertexInput {
+			uint32_t location;
+			vk::Format format;
+			uint32_t size;
+			std::string name;
+		};
+
+		vk::ShaderStageFlags stages;
+		std::vector<DescriptorBinding> bindings;
+		std::optional<PushConstantBlock> push_constant;
+		// Only filled for vertex shaders, sorted by location
+		std::vector<VertexInput> inputs;
+		// Only filled for compute shaders (the default values if the size comes from specialization constants)
+		std::array<uint32_t, 3> local_size = { 1, 1, 1 };
+
+		// Returns std::nullopt (and logs) if the code is not valid SPIR-V
+		static std::optional<ShaderReflection> reflect(const uint32_t* code, size_t word_count, vk::ShaderStageFlagBits stage);
+
+		// Merges the bindings (and push constant ranges) of another stage into this one
+		// Returns false if both declare the same set/binding with different types
+		bool merge(const ShaderReflection& other);
+
+		// Bindings of one set sorted by binding
+		[[nodiscard]] std::vector<DescriptorBinding> get_set(uint32_t set) const;
+		[[nodiscard]] uint32_t set_count() const;
+	};
+
+}
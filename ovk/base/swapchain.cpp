@@ -24,19 +24,13 @@ namespace ovk {
 		return available[0];
 	}
 
-	vk::PresentModeKHR choose_present_mode(const std::vector<vk::PresentModeKHR>& available) {
-		auto best_choise = vk::PresentModeKHR::eFifo;
-
-		/*for (const auto& available_mode : available) {
-			if (available_mode == vk::PresentModeKHR::eMailbox) {
-				return available_mode;
-			}
-			else if (available_mode == vk::PresentModeKHR::eImmediate) {
-				best_choise = available_mode;
-			}
-		}*/
-
-		return best_choise;
+	vk::PresentModeKHR choose_present_mode(const std::vector<vk::PresentModeKHR>& available, vk::PresentModeKHR preferred) {
+		if (std::find(available.begin(), available.end(), preferred) != available.end())
+			return preferred;
+
+		// Fifo is the only mode every implementation has to support
+		spdlog::warn("[SwapChain] present mode {} is not supported, falling back to Fifo", vk::to_string(preferred));
+		return vk::PresentModeKHR::eFifo;
 	}
 
 	vk::Extent2D choose_swap_extent(const vk::SurfaceCapabilitiesKHR& capabilities, GLFWwindow* window) {
@@ -60,7 +54,7 @@ namespace ovk {
 	}
 
 
-	SwapChain::SwapChain(Surface& surface, Device& device) : DeviceObject(device.device.get()) {
+	SwapChain::SwapChain(Surface& surface, Device& device, vk::PresentModeKHR preferred_present_mode, const SwapChain* old_swapchain) : DeviceObject(device.device.get()) {
 
 		const auto support = query_support(surface, device);
 
@@ -70,7 +64,7 @@ namespace ovk {
 
 
 		format = choose_format(support.formats);
-		present_mode = choose_present_mode(support.present_modes);
+		present_mode = choose_present_mode(support.present_modes, preferred_present_mode);
 		swap_extent = choose_swap_extent(support.capabilities, surface.window.get());
 
 		vk::SwapchainCreateInfoKHR create_info{
@@ -87,7 +81,8 @@ namespace ovk {
 			vk::CompositeAlphaFlagBitsKHR::eOpaque,
 			present_mode,
 			true,
-			{}
+			// Retires the old swapchain, images it already acquired are still presented
+			old_swapchain ? old_swapchain->handle.get() : vk::SwapchainKHR{}
 		};
 
 		if (device.families.graphics != device.families.present) {
@@ -105,6 +100,34 @@ namespace ovk {
 
 		this->image_count = static_cast<uint32_t>(images.size());
 
+		create_image_views(device);
+	}
+
+	SwapChain::SwapChain(Device& device, vk::Extent2D extent, vk::Format f, uint32_t count) : DeviceObject(device.device.get()) {
+		// There is no vk::SwapchainKHR behind an offscreen swapchain
+		handle.invalidate(false);
+
+		format = vk::SurfaceFormatKHR{ f, vk::ColorSpaceKHR::eSrgbNonlinear };
+		present_mode = vk::PresentModeKHR::eImmediate;
+		swap_extent = extent;
+		image_count = count;
+
+		offscreen_images.reserve(image_count);
+		for (uint32_t i = 0; i < image_count; i++) {
+			offscreen_images.push_back(device.create_image(
+				vk::ImageType::e2D,
+				format.format,
+				vk::Extent3D(extent.width, extent.height, 1),
+				vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+				vk::ImageTiling::eOptimal,
+				mem::MemoryType::device_local));
+			images.push_back(offscreen_images.back().handle.get());
+		}
+
+		create_image_views(device);
+	}
+
+	void SwapChain::create_image_views(Device& device) {
 		image_views.reserve(images.size());
 
 		for (auto image : images) {
@@ -129,6 +152,10 @@ namespace ovk {
 
 	}
 
+	bool SwapChain::is_offscreen() const {
+		return !offscreen_images.empty();
+	}
+
 	SwapChainSupport SwapChain::query_support(Surface &surface, Device &device) {
 
 		SwapChainSupport support;
@@ -146,7 +173,8 @@ namespace ovk {
 		{}, format.format, vk::SampleCountFlagBits::e1,
 		vk::AttachmentLoadOp::eClear, {},
 		vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
-		{}, vk::ImageLayout::ePresentSrcKHR
+		// Offscreen images are read back (or copied) after rendering instead of presented
+		{}, is_offscreen() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR
 		};
 	}
 
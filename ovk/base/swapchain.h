@@ -2,6 +2,7 @@
 
 #include "handle.h"
 #include "framebuffer.h"
+#include "image.h"
 
 namespace ovk {
 
@@ -17,19 +18,26 @@ namespace ovk {
 	/**
 	 * \brief USING SWAPCHAIN REQUIRES SWAPCHAIN_KHR EXTENSIONS
 	 *				Swapchain creates a simple optimal Swapchain for multi-buffered Rendering
+	 *				An offscreen swapchain (Device::create_offscreen_swapchain) owns plain images instead and needs neither a
+	 *				surface nor the extension, so renderers written against SwapChain also run headless
 	 */
 	class OVK_API SwapChain : public DeviceObject<vk::SwapchainKHR> {
 	private:
-		SwapChain(Surface& surface, Device& device);
+		SwapChain(Surface& surface, Device& device, vk::PresentModeKHR preferred_present_mode, const SwapChain* old_swapchain);
+		SwapChain(Device& device, vk::Extent2D extent, vk::Format format, uint32_t image_count);
 		friend class Device;
 		static SwapChainSupport query_support(Surface& s, Device& d);
+		void create_image_views(Device& device);
 
 	public:
 
 		vk::AttachmentDescription get_color_attachment_description() const;
 		std::vector<ovk::Framebuffer> create_framebuffers(ovk::RenderPass& rp, ovk::Device& device);
+
+		[[nodiscard]] bool is_offscreen() const;
 		
 		vk::SurfaceFormatKHR format{};
+		// The preferred mode of Device::create_swapchain if the surface supports it, otherwise Fifo
 		vk::PresentModeKHR present_mode;
 		vk::Extent2D swap_extent;
 		uint32_t image_count;
@@ -37,6 +45,11 @@ namespace ovk {
 		std::vector<vk::Image> images;
 		std::vector<UniqueHandle<vk::ImageView>> image_views;
 
+	private:
+		// Only for offscreen swapchains, images holds their handles
+		std::vector<Image> offscreen_images;
+		uint32_t next_image = 0;
+
 	};
 
 }
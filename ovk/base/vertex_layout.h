@@ -0,0 +1,161 @@
+#pragma once
+
+#include "handle.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Maybe we should not pull in this dependency here
+#include <boost/pfr.hpp>
+
+namespace ovk {
+
+	// Tag for GraphicsPipelineBuilder::set_vertex_layout, the binding of T advances once per instance instead of once per vertex
+	template <typename T>
+	struct per_instance {};
+
+	namespace vertex {
+
+		// Compressed attribute types, the shader reads all of them as float vectors
+		// (10-10-10-2 as vec4, the 2 bit component is w)
+		struct unorm8x4 { uint8_t x, y, z, w; };
+		struct snorm8x4 { int8_t x, y, z, w; };
+		struct unorm16x2 { uint16_t x, y; };
+		struct snorm16x2 { int16_t x, y; };
+		struct unorm16x4 { uint16_t x, y, z, w; };
+		struct snorm16x4 { int16_t x, y, z, w; };
+		struct half2 { uint16_t x, y; };
+		struct half4 { uint16_t x, y, z, w; };
+		struct unorm10x3_2 { uint32_t packed; };
+		struct snorm10x3_2 { uint32_t packed; };
+
+		namespace internal {
+			template <typename To, typename From>
+			To bit_cast(const From& from) {
+				static_assert(sizeof(To) == sizeof(From));
+				To to;
+				std::memcpy(&to, &from, sizeof(To));
+				return to;
+			}
+		}
+
+		inline unorm8x4 pack_unorm8x4(glm::vec4 v) { return internal::bit_cast<unorm8x4>(glm::packUnorm4x8(v)); }
+		inline snorm8x4 pack_snorm8x4(glm::vec4 v) { return internal::bit_cast<snorm8x4>(glm::packSnorm4x8(v)); }
+		inline unorm16x2 pack_unorm16x2(glm::vec2 v) { return internal::bit_cast<unorm16x2>(glm::packUnorm2x16(v)); }
+		inline snorm16x2 pack_snorm16x2(glm::vec2 v) { return internal::bit_cast<snorm16x2>(glm::packSnorm2x16(v)); }
+		inline unorm16x4 pack_unorm16x4(glm::vec4 v) { return internal::bit_cast<unorm16x4>(glm::packUnorm4x16(v)); }
+		inline snorm16x4 pack_snorm16x4(glm::vec4 v) { return internal::bit_cast<snorm16x4>(glm::packSnorm4x16(v)); }
+		inline half2 pack_half2(glm::vec2 v) { return internal::bit_cast<half2>(glm::packHalf2x16(v)); }
+		inline half4 pack_half4(glm::vec4 v) { return internal::bit_cast<half4>(glm::packHalf4x16(v)); }
+		inline unorm10x3_2 pack_unorm10x3_2(glm::vec4 v) { return { glm::packUnorm3x10_1x2(v) }; }
+		inline snorm10x3_2 pack_snorm10x3_2(glm::vec4 v) { return { glm::packSnorm3x10_1x2(v) }; }
+
+		// Format of a field type and how many locations it occupies (matrices take one per column)
+		template <typename T>
+		struct Attribute {
+			static constexpr bool supported = false;
+		};
+
+#define OVK_VERTEX_ATTRIBUTE(type, vk_format, location_count) \
+		template <> struct Attribute<type> { \
+			static constexpr bool supported = true; \
+			static constexpr vk::Format format = vk::Format::vk_format; \
+			static constexpr uint32_t locations = location_count; \
+		};
+
+		OVK_VERTEX_ATTRIBUTE(float, eR32Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::vec2, eR32G32Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::vec3, eR32G32B32Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::vec4, eR32G32B32A32Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(int32_t, eR32Sint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::ivec2, eR32G32Sint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::ivec3, eR32G32B32Sint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::ivec4, eR32G32B32A32Sint, 1)
+		OVK_VERTEX_ATTRIBUTE(uint32_t, eR32Uint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::uvec2, eR32G32Uint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::uvec3, eR32G32B32Uint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::uvec4, eR32G32B32A32Uint, 1)
+		OVK_VERTEX_ATTRIBUTE(glm::mat3, eR32G32B32Sfloat, 3)
+		OVK_VERTEX_ATTRIBUTE(glm::mat4, eR32G32B32A32Sfloat, 4)
+		OVK_VERTEX_ATTRIBUTE(unorm8x4, eR8G8B8A8Unorm, 1)
+		OVK_VERTEX_ATTRIBUTE(snorm8x4, eR8G8B8A8Snorm, 1)
+		OVK_VERTEX_ATTRIBUTE(unorm16x2, eR16G16Unorm, 1)
+		OVK_VERTEX_ATTRIBUTE(snorm16x2, eR16G16Snorm, 1)
+		OVK_VERTEX_ATTRIBUTE(unorm16x4, eR16G16B16A16Unorm, 1)
+		OVK_VERTEX_ATTRIBUTE(snorm16x4, eR16G16B16A16Snorm, 1)
+		OVK_VERTEX_ATTRIBUTE(half2, eR16G16Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(half4, eR16G16B16A16Sfloat, 1)
+		OVK_VERTEX_ATTRIBUTE(unorm10x3_2, eA2B10G10R10UnormPack32, 1)
+		OVK_VERTEX_ATTRIBUTE(snorm10x3_2, eA2B10G10R10SnormPack32, 1)
+
+#undef OVK_VERTEX_ATTRIBUTE
+
+		// Location is relative to the first location of the binding
+		struct AttributeDescription {
+			uint32_t location;
+			vk::Format format;
+			uint32_t offset;
+		};
+
+		template <typename T>
+		struct Binding {
+			using type = T;
+			static constexpr vk::VertexInputRate rate = vk::VertexInputRate::eVertex;
+		};
+
+		template <typename T>
+		struct Binding<per_instance<T>> {
+			using type = T;
+			static constexpr vk::VertexInputRate rate = vk::VertexInputRate::eInstance;
+		};
+
+		template <typename T>
+		constexpr uint32_t location_count() {
+			return []<size_t... I>(std::index_sequence<I...>) {
+				return (Attribute<boost::pfr::tuple_element_t<I, T>>::locations + ... + 0u);
+			}(std::make_index_sequence<boost::pfr::tuple_size_v<T>>{});
+		}
+
+		// Offsets follow the layout rules of the compiler (every field aligned to its alignment),
+		// the static_assert in attribute_table catches everything that does not
+		template <typename T>
+		constexpr auto make_attribute_table() {
+			std::array<AttributeDescription, location_count<T>()> table{};
+			uint32_t index = 0, location = 0, offset = 0;
+
+			[&]<size_t... I>(std::index_sequence<I...>) {
+				([&] {
+					using F = boost::pfr::tuple_element_t<I, T>;
+					static_assert(Attribute<F>::supported, "[vertex] (attribute_table) unsupported field type, see ovk::vertex::Attribute");
+
+					offset = (offset + alignof(F) - 1) / alignof(F) * alignof(F);
+					for (uint32_t c = 0; c < Attribute<F>::locations; c++)
+						table[index++] = AttributeDescription{ location++, Attribute<F>::format, offset + c * static_cast<uint32_t>(sizeof(F) / Attribute<F>::locations) };
+					offset += sizeof(F);
+				}(), ...);
+			}(std::make_index_sequence<boost::pfr::tuple_size_v<T>>{});
+
+			return std::make_pair(table, (offset + alignof(T) - 1) / alignof(T) * alignof(T));
+		}
+
+		// Attributes of the vertex struct T, generated at compile time
+		// T has to be an aggregate of supported types without nested structs, eg.
+		// struct MyCoolVertex {
+		//	glm::vec3 pos;
+		//	vertex::snorm10x3_2 normal;
+		//	vertex::half2 tex_coord;
+		// };
+		template <typename T>
+		inline constexpr auto attribute_table = [] {
+			static_assert(std::is_aggregate_v<T>, "[vertex] (attribute_table) T must be an aggregate");
+			constexpr auto result = make_attribute_table<T>();
+			static_assert(result.second == sizeof(T), "[vertex] (attribute_table) computed layout does not match sizeof(T)");
+			return result.first;
+		}();
+
+	}
+
+}
@@ -23,6 +23,9 @@
 // ImGui Utils (Like Allocator::draw_debug())
 #define OVK_IMGUI_UTILS
 
+// CPU Profiler zones (OVK_PROFILE_SCOPE, see util/profiler.h), compiles to nothing if undefined
+#define OVK_PROFILER
+
 // Define if you want to use SPDLOG Compatible Handles
 #define OVK_SPDLOG_COMPAT
 // Define if u want to use RenderDoc as an offline debugger with the debug marker extension
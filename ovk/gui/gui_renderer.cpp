@@ -114,6 +114,8 @@ namespace ovk {
 
 		io.RenderDrawListsFn = nullptr;
 
+		subpass = props.subpass;
+
 		if (props.use_extern_font) {
 			ovk_assert(io.Fonts->AddFontFromFileTTF(props.font_path, 16.0f));
 		}
@@ -191,13 +193,23 @@ namespace ovk {
 		
 	}
 
+	void ImGuiRenderer::resize(SwapChain& new_swapchain) {
+		ovk_asserts(new_swapchain.image_count == dynamic_objs.vertex_buffers.size(), "[ImGuiRenderer] (resize) image count changed, use recreate");
+
+		auto& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2(new_swapchain.swap_extent.width, new_swapchain.swap_extent.height);
+	}
+
 	void ImGuiRenderer::cmd_render_imgui(RenderCommand& cmd, Device &device, int index, ImDrawData *draw_data) {
 	
 		ovk_assert(index <= dynamic_objs.vertex_buffers.size(), "OutOfRange Index (Maybe the Swaapchain changed?)");
 
 		cmd.begin_region("ImGui Rendering", glm::vec4(0.23f, 0.76f, 0.56f, 1.00f));
 
-		if (!draw_data->TotalVtxCount || !draw_data->TotalIdxCount) return;
+		if (!draw_data->TotalVtxCount || !draw_data->TotalIdxCount) {
+			cmd.end_region();
+			return;
+		}
 		
 		{
 			// Create new buffers for this frame!
@@ -243,11 +255,22 @@ namespace ovk {
 		if constexpr (sizeof(ImDrawVert) == 4) idx_type = vk::IndexType::eUint32;
 		cmd.bind_index_buffer(*dynamic_objs.index_buffers[index], 0, idx_type);
 
+		cmd.set_viewport(glm::vec2(0, 0), glm::vec2(draw_data->DisplaySize.x, draw_data->DisplaySize.y));
+
 		int vtx_offset = 0, idx_offset = 0;
 		for (int n = 0; n < draw_data->CmdListsCount; n++) {
 			auto cmd_list = draw_data->CmdLists[n];
 			for (int i = 0; i < cmd_list->CmdBuffer.Size; i++) {
 				const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[i];
+
+				// Now that the scissor is dynamic we can respect the clip rects of the draw commands
+				const auto clip_min = glm::max(glm::vec2(pcmd->ClipRect.x - draw_data->DisplayPos.x, pcmd->ClipRect.y - draw_data->DisplayPos.y), glm::vec2(0.0f));
+				const auto clip_max = glm::min(glm::vec2(pcmd->ClipRect.z - draw_data->DisplayPos.x, pcmd->ClipRect.w - draw_data->DisplayPos.y), glm::vec2(draw_data->DisplaySize.x, draw_data->DisplaySize.y));
+				if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y) continue;
+				cmd.set_scissor(
+					vk::Offset2D(static_cast<int32_t>(clip_min.x), static_cast<int32_t>(clip_min.y)),
+					vk::Extent2D(static_cast<uint32_t>(clip_max.x - clip_min.x), static_cast<uint32_t>(clip_max.y - clip_min.y)));
+
 				cmd.draw_indexed(pcmd->ElemCount, 1, pcmd->IdxOffset + idx_offset, pcmd->VtxOffset + vtx_offset, 0);
 			}
 			idx_offset += cmd_list->IdxBuffer.Size;
@@ -290,25 +313,21 @@ namespace ovk {
 	}
 
 	void ImGuiRenderer::create_swapchain_objects(SwapChain& new_swapchain, RenderPass& rp, Device& device) {
-		dynamic_objs.pipeline = std::make_unique<GraphicsPipeline>(
-			std::forward<GraphicsPipeline>(
-				device.build_pipeline()
-				.set_render_pass(rp)
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_frag_spv, sizeof(__glsl_shader_frag_spv))
-				.set_vertex_layout({ vk::VertexInputBindingDescription { 0, sizeof(ImDrawVert) } },
-					{ vk::VertexInputAttributeDescription { 0, 0, vk::Format::eR32G32Sfloat, offsetof(ImGuiVertex, pos)},
-						vk::VertexInputAttributeDescription { 1, 0, vk::Format::eR32G32Sfloat, offsetof(ImGuiVertex, tex)},
-						vk::VertexInputAttributeDescription { 2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(ImGuiVertex, color)} }
-				)
-				.set_depth_stencil(false, false)
-				.add_descriptor_set_layouts({ const_objs.descriptor_layout->handle.get() })
-				.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(ImGuiPushConstant))
-				.add_viewport(glm::vec2(0, 0), glm::vec2(new_swapchain.swap_extent.width, new_swapchain.swap_extent.height), 0.0f, 1.0f)
-				.add_scissor(vk::Offset2D(0, 0), new_swapchain.swap_extent)
-				.build()
-				)
-			);
+		// recreate drops our reference, but the registry still holds the pipeline, so a resize does not rebuild it
+		dynamic_objs.pipeline = device.build_pipeline()
+			.set_render_pass(rp, subpass)
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_frag_spv, sizeof(__glsl_shader_frag_spv))
+			.set_vertex_layout({ vk::VertexInputBindingDescription { 0, sizeof(ImDrawVert) } },
+				{ vk::VertexInputAttributeDescription { 0, 0, vk::Format::eR32G32Sfloat, offsetof(ImGuiVertex, pos)},
+					vk::VertexInputAttributeDescription { 1, 0, vk::Format::eR32G32Sfloat, offsetof(ImGuiVertex, tex)},
+					vk::VertexInputAttributeDescription { 2, 0, vk::Format::eR8G8B8A8Unorm, offsetof(ImGuiVertex, color)} }
+			)
+			.set_depth_stencil(false, false)
+			.add_descriptor_templates({ const_objs.descriptor_layout.get() })
+			.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(ImGuiPushConstant))
+			.set_dynamic_viewport_scissor()
+			.build_cached();
 
 		dynamic_objs.vertex_buffers.resize(new_swapchain.image_count);
 		dynamic_objs.index_buffers.resize(new_swapchain.image_count);
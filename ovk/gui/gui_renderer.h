@@ -15,6 +15,8 @@ namespace ovk {
 	struct OVK_API ImGuiSetupProps {
 		bool use_extern_font = false;
 		const char* font_path = "";
+		// Subpass of the render pass ImGui is drawn in
+		uint32_t subpass = 0;
 	};
 
 	class OVK_API ImGuiRenderer : public EventListener {
@@ -29,6 +31,9 @@ namespace ovk {
 		void update();
 
 		void recreate(SwapChain& new_swapchain, RenderPass& rp, Device& device);
+		// Only updates the display size, for a swapchain with the same image count and render pass. Unlike recreate the
+		// buffers of frames in flight stay alive, so no wait for the device is needed
+		void resize(SwapChain& new_swapchain);
 
 		ImGuiContext* context;
 		
@@ -43,6 +48,7 @@ namespace ovk {
 		void create_swapchain_objects(SwapChain& new_swapchain, RenderPass& rp, Device& device);
 		
 		GLFWwindow* window;
+		uint32_t subpass = 0;
 		
 	public:
 		~ImGuiRenderer() override = default;
@@ -64,7 +70,7 @@ namespace ovk {
 		} const_objs;
 
 		struct {
-			std::unique_ptr<GraphicsPipeline> pipeline;
+			std::shared_ptr<GraphicsPipeline> pipeline;
 			
 			std::vector<std::unique_ptr<Buffer>> vertex_buffers;
 			std::vector<std::unique_ptr<Buffer>> index_buffers;
@@ -396,6 +396,18 @@ namespace ovk {
 		}
 
 	};
+
+	template<>
+	struct OVK_API ObjectDestroy<vk::DescriptorUpdateTemplate> {
+
+		vk::Device d;
+		explicit ObjectDestroy(vk::Device& _d) : d(_d) {}
+
+		void operator()(vk::DescriptorUpdateTemplate& iv) const {
+			d.destroyDescriptorUpdateTemplate(iv);
+		}
+
+	};
 	
 	template<>
 	struct OVK_API ObjectDestroy<vk::PipelineLayout> {
@@ -501,6 +513,24 @@ namespace ovk {
 			d.destroySampler(iv);
 		}
 	};
+
+	template<>
+	struct OVK_API ObjectDestroy<vk::QueryPool> {
+		vk::Device d;
+		explicit ObjectDestroy(vk::Device& _d) : d(_d) {}
+		void operator()(vk::QueryPool& iv) const {
+			d.destroyQueryPool(iv);
+		}
+	};
+
+	template<>
+	struct OVK_API ObjectDestroy<vk::PipelineCache> {
+		vk::Device d;
+		explicit ObjectDestroy(vk::Device& _d) : d(_d) {}
+		void operator()(vk::PipelineCache& iv) const {
+			d.destroyPipelineCache(iv);
+		}
+	};
 	
 }
 
@@ -1,7 +1,7 @@
 #include "pch.h"
 #include "renderer.h"
 
-#define texture_rect_count 64
+#include "util/profiler.h"
 
 namespace ovk::ui {
 	
@@ -16,6 +16,58 @@ namespace ovk::ui {
 	static uint32_t __glsl_shader_colored_frag_spv[] = {
 #include "shader/ui_colored.frag.spv"																							
 	};
+
+	// ui_textured.frag with the texture taken from the bindless table, compiled when the renderer is created
+	static const char* glsl_shader_textured_bindless_frag = R"glsl(
+#version 450 core
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (location = 0) in vec2 pass_tex;
+layout (location = 1) in vec4 pass_ndc;
+
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+layout (push_constant) uniform FragmentPushConstant {
+	layout (offset = 4 * 16) vec2 pos;
+	layout (offset = 4 * 16 + 8) vec2 scale;
+	layout (offset = 4 * 16 + 16) float radius;
+	layout (offset = 4 * 16 + 20) uint texture_index;
+} pc;
+
+layout (location = 0) out vec4 color;
+
+bool is_inside(vec2 a, vec2 b, vec2 value) {
+	vec2 top_left = vec2(min(a.x, b.x), min(a.y, b.y));
+	vec2 bottom_right = vec2(max(a.x, b.x), max(a.y, b.y));
+	return (value.x >= top_left.x && value.x <= bottom_right.x) && (value.y >= top_left.y && value.y <= bottom_right.y);
+}
+
+void main() {
+	color = texture(textures[pc.texture_index], pass_tex);
+
+	float r = pc.radius;
+	if (r != 0.0f) {
+		vec2 fp = pass_ndc.xy;
+		vec2 check_point = vec2(0.0f);
+		vec2 bias = vec2(1.05f);
+
+		vec2 scale[4] = vec2[]( -pc.scale,  vec2(pc.scale.x, -pc.scale.y), vec2(-pc.scale.x, pc.scale.y), pc.scale );
+		vec2 r2[4] =    vec2[]( vec2(r, r), vec2(-r, r), vec2(r, -r), vec2(-r, -r) );
+
+		for (int i = 0; i < 4; i++) {
+			if (is_inside(pc.pos + bias * 0.5f * scale[i], pc.pos + 0.5f * scale[i] + r2[i], fp)) {
+				check_point = pc.pos + 0.5f * scale[i] + r2[i];
+			}
+		}
+
+		if (check_point != vec2(0.0f)) {
+			float d = distance(check_point, fp);
+			if (d > r) discard;
+		}
+	}
+}
+)glsl";
 	
 
 		
@@ -28,6 +80,8 @@ namespace ovk::ui {
 		glm::vec2 pos;
 		glm::vec2 scale;
 		float radius;
+		// Only read by the bindless shader
+		uint32_t texture_index;
 	};
 
 	struct ColoredFragmentPushConstant {
@@ -39,6 +93,48 @@ namespace ovk::ui {
 
 	TexturedRect::TexturedRect(ovk::DescriptorSet &&set, glm::vec2 _pos, glm::vec2 _scale)
 	  : descriptor_set(std::move(set)), pos(_pos), scale(_scale) {}
+
+	TexturedRect::TexturedRect(ovk::DescriptorAllocator& allocator, const ovk::DescriptorTemplate& descriptor_template, ovk::DescriptorSet&& set,
+		glm::vec2 _pos, glm::vec2 _scale)
+		: descriptor_set(std::move(set)), pos(_pos), scale(_scale), allocator(&allocator), descriptor_template(&descriptor_template) {}
+
+	TexturedRect::TexturedRect(ovk::BindlessTextures& table, uint32_t index, glm::vec2 _pos, glm::vec2 _scale)
+		: texture_index(index), pos(_pos), scale(_scale), bindless_table(&table) {}
+
+	TexturedRect::TexturedRect(TexturedRect&& other) noexcept
+		: descriptor_set(std::move(other.descriptor_set)), texture_index(other.texture_index), pos(other.pos), scale(other.scale),
+			bindless_table(std::exchange(other.bindless_table, nullptr)), allocator(std::exchange(other.allocator, nullptr)),
+			descriptor_template(std::exchange(other.descriptor_template, nullptr)) {
+		other.descriptor_set.reset();
+	}
+
+	TexturedRect& TexturedRect::operator=(TexturedRect&& other) noexcept {
+		if (this != &other) {
+			release();
+			descriptor_set = std::move(other.descriptor_set);
+			other.descriptor_set.reset();
+			texture_index = other.texture_index;
+			pos = other.pos;
+			scale = other.scale;
+			bindless_table = std::exchange(other.bindless_table, nullptr);
+			allocator = std::exchange(other.allocator, nullptr);
+			descriptor_template = std::exchange(other.descriptor_template, nullptr);
+		}
+		return *this;
+	}
+
+	TexturedRect::~TexturedRect() { release(); }
+
+	void TexturedRect::release() {
+		// The slot is handed out again, so the table does not keep pointing at a view that may be destroyed next
+		if (bindless_table) bindless_table->remove(texture_index);
+		bindless_table = nullptr;
+		// The pools can not free single sets, the allocator reuses it for the next rect instead
+		if (allocator && descriptor_set) allocator->free(*descriptor_template, std::move(*descriptor_set));
+		allocator = nullptr;
+		descriptor_template = nullptr;
+		descriptor_set.reset();
+	}
 	
 	Renderer::Renderer(ovk::RenderPass& rp, std::shared_ptr<ovk::SwapChain>& sc, std::shared_ptr<ovk::Device>& d)
 		: swapchain(sc), device(d), renderpass(&rp) {
@@ -64,21 +160,37 @@ namespace ovk::ui {
 
 	
 	void Renderer::on_inline_render(ovk::RenderCommand& cmd, uint32_t index) {
-		cmd.bind_graphics_pipeline(*pipeline.textured);
-		cmd.bind_vertex_buffers(0, { { std::ref(*vertex_buffer), 0 } });
-		for (auto* rect : texture_rects) {
+		cmd.set_viewport_scissor(swapchain->swap_extent);
 
+		auto draw_textured = [&](ovk::GraphicsPipeline& pipe, TexturedRect& rect) {
 			glm::mat4 model(1.0f);
 
-			model = glm::translate(model, glm::vec3(rect->pos.x, rect->pos.y, 0.0f));
-			model = glm::scale(model, glm::vec3(rect->scale.x, rect->scale.y, 0.0f));
+			model = glm::translate(model, glm::vec3(rect.pos.x, rect.pos.y, 0.0f));
+			model = glm::scale(model, glm::vec3(rect.scale.x, rect.scale.y, 0.0f));
+
+			cmd.push_constant(model, pipe, vk::ShaderStageFlagBits::eVertex, 0);
+			TexturedFragmentPushConstant pc{ rect.pos, rect.scale, 10.0f, rect.texture_index };
+			cmd.push_constant(pc, pipe, vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4));
 
-			cmd.push_constant(model, *pipeline.textured, vk::ShaderStageFlagBits::eVertex, 0);
-			TexturedFragmentPushConstant pc{ rect->pos, rect->scale, 10.0f };
-			cmd.push_constant(pc, *pipeline.textured, vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4));
-				
-			cmd.bind_descriptor_sets(*pipeline.textured, 0, { rect->descriptor_set.set });
 			cmd.draw(6, 1, 0, 0);
+		};
+
+		if (pipeline.textured_bindless) {
+			cmd.bind_graphics_pipeline(*pipeline.textured_bindless);
+			cmd.bind_vertex_buffers(0, { { std::ref(*vertex_buffer), 0 } });
+			// Projection and the texture table, bound once for all rects
+			cmd.bind_descriptor_sets(*pipeline.textured_bindless, 0, { des_set_colored->set, bindless_textures->get_set().set });
+			for (auto* rect : texture_rects) {
+				if (!rect->descriptor_set) draw_textured(*pipeline.textured_bindless, *rect);
+			}
+		}
+
+		cmd.bind_graphics_pipeline(*pipeline.textured);
+		cmd.bind_vertex_buffers(0, { { std::ref(*vertex_buffer), 0 } });
+		for (auto* rect : texture_rects) {
+			if (!rect->descriptor_set) continue;
+			cmd.bind_descriptor_sets(*pipeline.textured, 0, { rect->descriptor_set->set });
+			draw_textured(*pipeline.textured, *rect);
 		}
 		texture_rects.clear();
 
@@ -116,15 +228,23 @@ namespace ovk::ui {
 
 	TexturedRect Renderer::create_textured_rect(ovk::Image& image, ovk::ImageView& view, ovk::Sampler& sampler, glm::vec2 pos, glm::vec2 scale) {
 
-		auto sets = device->make_descriptor_sets(*descriptor_pool, 1, *descriptor_template);
-		ovk_assert(sets.size() == 1);
+		OVK_PROFILE_SCOPE("ui::Renderer::create_textured_rect");
 
-		auto set = std::move(sets[0]);
+		if (bindless_textures) {
+			if (auto index = bindless_textures->add(sampler.handle.get(), view.handle.get(), image.layout))
+				return TexturedRect(*bindless_textures, *index, pos, scale);
+			// The table is full, this rect gets its own set
+		}
+
+		// The allocator grows, so there is no limit on the number of rects
+		auto set = descriptor_allocator->allocate(*descriptor_template);
 
-		set.write(*projection_uniform_buffer, 0, 0);
-		set.write(sampler.handle.get(), view.handle.get(), image.layout, 1);
+		set.update(*rect_update_template, {
+			ovk::descriptor::Data::from_buffer(*projection_uniform_buffer),
+			ovk::descriptor::Data::from_image(sampler.handle.get(), view.handle.get(), image.layout)
+		});
 		
-		return TexturedRect(std::move(set), pos, scale);
+		return TexturedRect(*descriptor_allocator, *descriptor_template, std::move(set), pos, scale);
 
 	}
 
@@ -154,23 +274,22 @@ namespace ovk::ui {
 																					 .add_sampler(1, vk::ShaderStageFlagBits::eFragment)
 																					 .build());
 
-		descriptor_pool = ovk::make_unique(device->create_descriptor_pool(
-      { descriptor_template.get() },
-			{ texture_rect_count }
-    ));
+		rect_update_template = ovk::make_unique(device->create_descriptor_update_template(*descriptor_template));
 
 		des_template_colored = ovk::make_unique(device->build_descriptor_template()
 																						.add_uniform_buffer(0, vk::ShaderStageFlagBits::eVertex)
 																						.build());
 
-		des_pool_colored = ovk::make_unique(device->create_descriptor_pool(
-																					{ des_template_colored.get() },
-																					{ 1 } ));
+		descriptor_allocator = std::make_unique<ovk::DescriptorAllocator>(*device);
 
-		auto sets = device->make_descriptor_sets(*des_pool_colored, 1, *des_template_colored);
-		ovk_assert(sets.size() == 1);
+		des_set_colored = ovk::make_unique(descriptor_allocator->allocate(*des_template_colored));
 
-		des_set_colored = ovk::make_unique(std::move(sets[0]));
+		if (device->has_bindless()) {
+			if (auto code = device->get_shader_compiler().compile(glsl_shader_textured_bindless_frag, "ui_textured_bindless.frag", vk::ShaderStageFlagBits::eFragment)) {
+				bindless_fragment_code = std::move(*code);
+				bindless_textures = std::make_unique<ovk::BindlessTextures>(*device);
+			}
+		}
 
 	}
 
@@ -187,39 +306,44 @@ namespace ovk::ui {
 
 		des_set_colored->write(*projection_uniform_buffer, 0, 0);
 		
-		pipeline.textured = std::make_unique<GraphicsPipeline>(
-			std::forward<GraphicsPipeline>(
-				device->build_pipeline()
-				.set_render_pass(*renderpass)
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_textured_frag_spv, sizeof(__glsl_shader_textured_frag_spv))
-				.set_vertex_layout<Vertex>()
-				.set_depth_stencil(false, false)
-				.add_descriptor_set_layouts({ descriptor_template->handle.get() })
-				.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
-				.add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(ColoredFragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
-				.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-				.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-				.build()
-			)
-		);
-
-		pipeline.colored = std::make_unique<GraphicsPipeline>(
-			std::forward<GraphicsPipeline>(
-				device->build_pipeline()
+		// Viewport and scissor are dynamic, so on a resize these are served by the pipeline registry
+		pipeline.textured = device->build_pipeline()
+			.set_render_pass(*renderpass)
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_textured_frag_spv, sizeof(__glsl_shader_textured_frag_spv))
+			.set_vertex_layout<Vertex>()
+			.set_depth_stencil(false, false)
+			.add_descriptor_templates({ descriptor_template.get() })
+			.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
+			.add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(ColoredFragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
+			.set_dynamic_viewport_scissor()
+			.build_cached();
+
+		if (bindless_textures) {
+			pipeline.textured_bindless = device->build_pipeline()
 				.set_render_pass(*renderpass)
 				.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_colored_frag_spv, sizeof(__glsl_shader_colored_frag_spv))
+				.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, bindless_fragment_code.data(), bindless_fragment_code.size() * sizeof(uint32_t))
 				.set_vertex_layout<Vertex>()
 				.set_depth_stencil(false, false)
-				.add_descriptor_set_layouts({ des_template_colored->handle.get() })
+				.add_descriptor_templates({ des_template_colored.get(), &bindless_textures->get_template() })
 				.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
 				.add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(ColoredFragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
-				.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-				.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-				.build()
-			)
-		);
+				.set_dynamic_viewport_scissor()
+				.build_cached();
+		}
+
+		pipeline.colored = device->build_pipeline()
+			.set_render_pass(*renderpass)
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_colored_frag_spv, sizeof(__glsl_shader_colored_frag_spv))
+			.set_vertex_layout<Vertex>()
+			.set_depth_stencil(false, false)
+			.add_descriptor_templates({ des_template_colored.get() })
+			.add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
+			.add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(ColoredFragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
+			.set_dynamic_viewport_scissor()
+			.build_cached();
 
 	}
 
@@ -14,12 +14,37 @@
 
 namespace ovk::ui {
 
+	// Hands its descriptor set back to the allocator of the Renderer (or releases its slot in the bindless table) when
+	// destroyed, so (like any descriptor set) it must not be destroyed while frames in flight draw it, and not outlive the
+	// Renderer that created it
 	struct OVK_API TexturedRect {
 
+		// The set is only dropped when the rect is destroyed
 		TexturedRect(ovk::DescriptorSet&& set, glm::vec2 _pos, glm::vec2 _scale);
+		// The set is handed back to allocator when the rect is destroyed
+		TexturedRect(ovk::DescriptorAllocator& allocator, const ovk::DescriptorTemplate& descriptor_template, ovk::DescriptorSet&& set,
+			glm::vec2 _pos, glm::vec2 _scale);
+		TexturedRect(ovk::BindlessTextures& table, uint32_t texture_index, glm::vec2 _pos, glm::vec2 _scale);
+
+		TexturedRect(const TexturedRect& other) = delete;
+		TexturedRect(TexturedRect&& other) noexcept;
+		TexturedRect& operator=(const TexturedRect& other) = delete;
+		TexturedRect& operator=(TexturedRect&& other) noexcept;
+		~TexturedRect();
 		
-		ovk::DescriptorSet descriptor_set;
+		// Empty if the texture lives in the bindless table of the renderer (at texture_index)
+		std::optional<ovk::DescriptorSet> descriptor_set;
+		uint32_t texture_index = 0;
 		glm::vec2 pos, scale;
+
+	private:
+		void release();
+
+		// The table texture_index belongs to, nullptr with an own descriptor set
+		ovk::BindlessTextures* bindless_table = nullptr;
+		// Where descriptor_set goes back to, nullptr if it is not from an allocator
+		ovk::DescriptorAllocator* allocator = nullptr;
+		const ovk::DescriptorTemplate* descriptor_template = nullptr;
 		
 	};
 
@@ -59,7 +84,11 @@ namespace ovk::ui {
 		std::unique_ptr<TextRenderer> text_renderer;
 
 		std::unique_ptr<ovk::DescriptorTemplate> descriptor_template, des_template_colored;
-		std::unique_ptr<ovk::DescriptorPool> descriptor_pool, des_pool_colored;
+		std::unique_ptr<ovk::DescriptorUpdateTemplate> rect_update_template;
+		// Only if the device supports bindless descriptors, rects then share one set
+		std::unique_ptr<ovk::BindlessTextures> bindless_textures;
+		std::vector<uint32_t> bindless_fragment_code;
+		std::unique_ptr<ovk::DescriptorAllocator> descriptor_allocator;
 		std::unique_ptr<ovk::DescriptorSet> des_set_colored;
 		
 		std::vector<TexturedRect*> texture_rects;
@@ -70,7 +99,7 @@ namespace ovk::ui {
 		// Contains [0, 0] to screen_extent orthographic-projection matrix
 		std::unique_ptr<ovk::Buffer> projection_uniform_buffer;
 		struct {
-			std::unique_ptr<ovk::GraphicsPipeline> textured, colored;
+			std::shared_ptr<ovk::GraphicsPipeline> textured, textured_bindless, colored;
 		} pipeline;
 		
 	};
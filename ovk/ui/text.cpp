@@ -92,6 +92,7 @@ namespace ovk::ui {
 		auto &vertex_buffer = vertex_buffers[index];
 		vertex_buffer = ovk::make_unique(device->create_vertex_buffer(vertices, ovk::mem::MemoryType::cpu_coherent_and_cached));
 		
+		cmd.set_viewport_scissor(swapchain->swap_extent);
 		cmd.bind_graphics_pipeline(*pipeline);
 
 		cmd.bind_descriptor_sets(*pipeline, 0, { descriptor_set->set });
@@ -219,22 +220,17 @@ namespace ovk::ui {
 	void TextRenderer::create_dynamic_objects() {
 
 		
-		pipeline = std::make_unique<GraphicsPipeline>(
-			std::forward<GraphicsPipeline>(
-				device->build_pipeline()
-				.set_render_pass(*renderpass)
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
-				.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_frag_spv, sizeof(__glsl_shader_frag_spv))
-				.set_vertex_layout<VertexLayout>()
-				.set_depth_stencil(false, false)
-				.add_descriptor_set_layouts({ descriptor_template->handle.get() })
-				// .add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
-				// .add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(FragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
-				.add_viewport(glm::vec2(0, 0), glm::vec2(swapchain->swap_extent.width, swapchain->swap_extent.height), 0.0f, 1.0f)
-				.add_scissor(vk::Offset2D(0, 0), swapchain->swap_extent)
-				.build()
-			)
-		);
+		pipeline = device->build_pipeline()
+			.set_render_pass(*renderpass)
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eVertex, __glsl_shader_vert_spv, sizeof(__glsl_shader_vert_spv))
+			.add_shader_stage_u32(vk::ShaderStageFlagBits::eFragment, __glsl_shader_frag_spv, sizeof(__glsl_shader_frag_spv))
+			.set_vertex_layout<VertexLayout>()
+			.set_depth_stencil(false, false)
+			.add_descriptor_templates({ descriptor_template.get() })
+			// .add_push_constant(vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4))
+			// .add_push_constant(vk::ShaderStageFlagBits::eFragment, sizeof(FragmentPushConstant), /*offset:*/ sizeof(glm::mat4))
+			.set_dynamic_viewport_scissor()
+			.build_cached();
 
 		vertex_buffers.resize(swapchain->image_count);
 
@@ -51,7 +51,7 @@ namespace ovk::ui {
 		std::unique_ptr<ovk::ImageView> font_image_view;
 
 		// Dynamic Thingys
-		std::unique_ptr<ovk::GraphicsPipeline> pipeline;
+		std::shared_ptr<ovk::GraphicsPipeline> pipeline;
 		std::vector<std::unique_ptr<ovk::Buffer>> vertex_buffers;
 
 		std::unique_ptr<ovk::Buffer> projection_uniform_buffer;
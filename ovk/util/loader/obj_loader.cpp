@@ -5,146 +5,309 @@
 #include "pch.h"
 
 #include "base/device.h"
+#include "util/mesh_cache.h"
+#include "util/mesh_optimizer.h"
+#include "util/profiler.h"
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
+#include "obj_parser.h"
+
+#include <unordered_map>
 
 namespace ovk::util {
 
-Model impl_load_model_obj(const std::string &filepath, ParseOptions options,
-                          ovk::Device &device) {
+// Vertices are welded if position, normal and texcoord are bitwise equal
+struct VertexDataHash {
+  size_t operator()(const VertexData &vertex) const {
+    // FNV-1a over the float words
+    uint32_t words[sizeof(VertexData) / sizeof(uint32_t)];
+    memcpy(words, &vertex, sizeof(VertexData));
+
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto word : words)
+      hash = (hash ^ word) * 1099511628211ull;
+    return static_cast<size_t>(hash);
+  }
+};
+
+struct VertexDataEqual {
+  bool operator()(const VertexData &a, const VertexData &b) const {
+    return memcmp(&a, &b, sizeof(VertexData)) == 0;
+  }
+};
+
+// The vertices before the callback, this is what the mesh cache stores
+struct ObjMesh {
+  std::vector<VertexData> vertices;
+  // Empty without ParseOptions::use_index_buffer
+  std::vector<uint32_t> indices;
+};
+
+// Section 0 of the mesh cache, followed by the vertices and the indices (in
+// their final type)
+struct ObjCacheInfo {
+  uint64_t vertex_count;
+  uint64_t index_count;
+  // 0 without an index buffer
+  uint32_t index_size;
+  uint32_t padding;
+};
+
+// Everything that changes what is cached
+static uint64_t cache_key(const ParseOptions &options) {
+  constexpr uint32_t obj_cache_format = 2;
+  const uint32_t key_info[] = {obj_cache_format, sizeof(VertexData),
+                               options.use_index_buffer,
+                               options.optimize_mesh};
+
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto word : key_info)
+    hash = (hash ^ word) * 1099511628211ull;
+  return hash;
+}
+
+// The sizes in the header only catch truncated caches, an index past the
+// vertices would make the gpu read out of bounds
+static bool cached_indices_valid(const void *indices, size_t index_count,
+                                 uint32_t index_size, size_t vertex_count) {
+  if (index_size == 0)
+    return index_count == 0;
+  if (index_size != 2 && index_size != 4)
+    return false;
 
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
+  for (size_t i = 0; i < index_count; i++) {
+    const size_t index = index_size == 2
+                             ? static_cast<const uint16_t *>(indices)[i]
+                             : static_cast<const uint32_t *>(indices)[i];
+    if (index >= vertex_count)
+      return false;
+  }
+  return true;
+}
 
-  std::string warn;
-  std::string error;
+static std::optional<ObjMesh> parse_obj(const std::string &filepath,
+                                        const ParseOptions &options,
+                                        ovk::Device &device) {
+  const auto obj = parse_obj_file(filepath, &device.get_thread_pool());
+  if (!obj) {
+    spdlog::error("[ObjParser] Failed to open {}", filepath);
+    return std::nullopt;
+  }
 
-  // tinyobj_opt::LoadOption option;
-  // option.req_num_threads = -1; // All of them
-  // option.verbose = verbose;
-  // bool ret = parseObj(&attrib, &shapes, &materials, data, data_len, option);
+  if (obj->malformed_lines > 0)
+    spdlog::warn("[ObjParser] Skipped {} malformed lines in {}",
+                 obj->malformed_lines, filepath);
+  if (obj->invalid_indices > 0)
+    spdlog::warn("[ObjParser] {} indices out of range in {}",
+                 obj->invalid_indices, filepath);
 
-  // if (!ret) spdlog::error("[TinyObjLoader] Failed to parse obj");
+  const auto vertex_count = obj->indices.size();
 
-  bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &error,
-                              filepath.c_str());
+  ObjMesh mesh;
+  mesh.vertices.reserve(vertex_count);
 
-  if (!warn.empty()) {
-    spdlog::warn("[TinyObjLoader] Warning: ");
-    spdlog::warn(warn);
+  // With an index buffer every unique vertex is only stored (and passed to
+  // the callback) once
+  std::unordered_map<VertexData, uint32_t, VertexDataHash, VertexDataEqual>
+      unique_vertices;
+  if (options.use_index_buffer) {
+    unique_vertices.reserve(vertex_count);
+    mesh.indices.reserve(vertex_count);
   }
 
-  if (!error.empty()) {
-    spdlog::error("[TinyObjLoader] Erroring: ");
-    spdlog::error(error);
+  // Loop over triangles
+  for (size_t t = 0; t + 2 < obj->indices.size(); t += 3) {
+    // Vertices are required to be present
+    if (obj->indices[t + 0].position < 0 || obj->indices[t + 1].position < 0 ||
+        obj->indices[t + 2].position < 0)
+      continue;
+
+    for (size_t v = t; v < t + 3; v++) {
+      const auto &idx = obj->indices[v];
+      const auto position = &obj->positions[3 * idx.position];
+      // Normals and texcoords are optional
+      glm::vec3 normal(0.0f);
+      if (idx.normal >= 0) {
+        const auto n = &obj->normals[3 * idx.normal];
+        normal = glm::vec3(n[0], n[1], n[2]);
+      }
+      glm::vec2 texcoord(0.0f);
+      if (idx.texcoord >= 0) {
+        const auto uv = &obj->texcoords[2 * idx.texcoord];
+        texcoord = glm::vec2(uv[0], uv[1]);
+      }
+      // Construct Vertex
+      VertexData data{.pos = glm::vec3(position[0], position[1], position[2]),
+                      .normal = normal,
+                      .texcoord = texcoord};
+
+      if (options.use_index_buffer) {
+        const auto [it, inserted] = unique_vertices.try_emplace(
+            data, static_cast<uint32_t>(mesh.vertices.size()));
+        if (inserted)
+          mesh.vertices.push_back(data);
+        mesh.indices.push_back(it->second);
+      } else {
+        mesh.vertices.push_back(data);
+      }
+    }
   }
 
-  // Ok here we are going to be a bit memory wasting but it will later give user
-  // huge perfomance benefits
-  // we need to figure out the maximum size in bytes the output buffer can get
-  // if the user decides to use all data (position, normal, texcoord) which is
-  // honestly probable
-  ovk_assert(sizeof(VertexData) == 8 * sizeof(float));
-  const auto vertex_size = sizeof(VertexData);
-
-  // -> We need to figure out the vertex_count before hand
-  uint64_t vertex_count = 0;
-  for (auto &shape : shapes)
-    // Since we now that num_face_vertices will always be 3 we can just
-    vertex_count += shape.mesh.num_face_vertices.size() * 3;
-  const auto buffer_size = vertex_count * vertex_size;
-
-  // Now we need to create the (memory coherent) buffer
-  uint8_t *head = new uint8_t[buffer_size];
-
-  // Then we are going to produce the output buffer to be passed to the callback
-  OutputBuffer output_buffer{.start = head, .size = 0, .max_size = buffer_size};
-
-  // Sanity Checking
-  if (!options.disable_callback) {
+  if (options.use_index_buffer)
+    spdlog::info("welded {} vertices to {} ({:.2f}x)", vertex_count,
+                 mesh.vertices.size(),
+                 static_cast<double>(vertex_count) /
+                     std::max<size_t>(mesh.vertices.size(), 1));
+
+  if (options.use_index_buffer && options.optimize_mesh) {
+    std::vector<glm::vec3> positions(mesh.vertices.size());
+    for (size_t v = 0; v < mesh.vertices.size(); v++)
+      positions[v] = mesh.vertices[v].pos;
+
+    const auto unique_count = mesh.vertices.size();
+    const auto before = analyze_vertex_cache(mesh.indices, unique_count);
+    optimize_vertex_cache(mesh.indices, unique_count);
+    optimize_overdraw(mesh.indices, positions);
+    optimize_vertex_fetch(mesh.indices,
+                          reinterpret_cast<uint8_t *>(mesh.vertices.data()),
+                          unique_count, sizeof(VertexData));
+    const auto after = analyze_vertex_cache(mesh.indices, unique_count);
+
+    spdlog::info("optimized mesh: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                 before.acmr, after.acmr, before.atvr, after.atvr);
+  }
+
+  return mesh;
+}
+
+// Runs the callback and creates the buffers, vertices and indices may point
+// straight into the mesh cache mapping
+static Model upload(const VertexData *vertices, size_t vertex_count,
+                    const void *indices, size_t index_count,
+                    uint32_t index_size, const ParseOptions &options,
+                    ovk::Device &device) {
+  OVK_PROFILE_SCOPE("upload_model");
+
+  std::unique_ptr<ovk::Buffer> vertex_buffer;
+  if (options.disable_callback) {
+    // -> Directly upload the data
+    vertex_buffer = ovk::make_unique(device.create_buffer(
+        vk::BufferUsageFlagBits::eVertexBuffer,
+        vertex_count * sizeof(VertexData), const_cast<VertexData *>(vertices),
+        {ovk::QueueType::graphics}, ovk::mem::MemoryType::device_local));
+  } else {
+    // Sanity Checking
     ovk_assert(options.callback != nullptr,
                "You did not disable callback for parsing, but no "
                "callback was provided");
+
+    // Ok here we are going to be a bit memory wasting but it will later give
+    // user huge perfomance benefits
+    // we need to figure out the maximum size in bytes the output buffer can
+    // get if the user decides to use all data (position, normal, texcoord)
+    // which is honestly probable
+    ovk_assert(sizeof(VertexData) == 8 * sizeof(float));
+    const auto buffer_size = vertex_count * sizeof(VertexData);
+
+    // Now we need to create the (memory coherent) buffer
+    uint8_t *head = new uint8_t[buffer_size];
+
+    // Then we are going to produce the output buffer to be passed to the
+    // callback
+    OutputBuffer output_buffer{
+        .start = head, .size = 0, .max_size = buffer_size};
+
+    // -> Call the Callback
+    for (size_t v = 0; v < vertex_count; v++)
+      options.callback(vertices[v], output_buffer);
+
+    if (output_buffer.size > output_buffer.max_size)
+      panic("Buffer overflow! Probably destroyed something");
+
+    // -> But that into a buffer
+    vertex_buffer = ovk::make_unique(device.create_buffer(
+        vk::BufferUsageFlagBits::eVertexBuffer, output_buffer.size,
+        output_buffer.start, {ovk::QueueType::graphics},
+        ovk::mem::MemoryType::device_local));
+
+    // delete output buffer
+    delete[] output_buffer.start;
   }
 
-  // spdlog::info("Length's: vertices - {}, normals - {}, texcoords - {}",
-  //              attrib.vertices.size(), attrib.normals.size(),
-  //              attrib.texcoords.size());
-
-  const auto use_normals = attrib.normals.size() != 0;
-  const auto use_texcoords = attrib.texcoords.size() != 0;
-
-  // Loop over shapes
-  for (size_t s = 0; s < shapes.size(); s++) {
-    // Loop over faces(polygon)
-    size_t index_offset = 0;
-
-    for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-      int fv = shapes[s].mesh.num_face_vertices[f];
-
-      // -> Because triangulate was true
-      ovk_assert(fv == 3);
-
-      // Loop over vertices in the face.
-      for (size_t v = 0; v < fv; v++) {
-        // access to vertex
-        tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-        // Vertices are required to be present
-        tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-        tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-        tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-        // Normals and texcoords are optional
-        glm::vec3 normal(0.0f);
-        if (use_normals) {
-          tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-          tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-          tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-          normal = glm::vec3(nx, ny, nz);
-        }
-        glm::vec2 texcoord(0.0f);
-        if (use_texcoords) {
-          tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-          tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-          texcoord = glm::vec2(tx, ty);
-        }
-        // Construct Vertex
-        VertexData data{.pos = glm::vec3(vx, vy, vz),
-                        .normal = normal,
-                        .texcoord = texcoord};
-
-        if (options.disable_callback) {
-          // -> Directly push back the data
-          memcpy(output_buffer.start + output_buffer.size, &data,
-                 sizeof(VertexData));
-          output_buffer.size += sizeof(VertexData);
-        } else {
-          // -> Call the Callback
-          options.callback(data, output_buffer);
-        }
-      }
-      index_offset += fv;
+  if (index_size == 0 || index_count == 0) {
+    spdlog::info("finished loading: {} vertices", vertex_count);
+    return Model(std::move(vertex_buffer), nullptr, vertex_count);
+  }
 
-      // per-face material
-      // shapes[s].mesh.material_ids[f];
+  auto index_buffer = ovk::make_unique(device.create_buffer(
+      vk::BufferUsageFlagBits::eIndexBuffer, index_count * index_size,
+      const_cast<void *>(indices), {ovk::QueueType::graphics},
+      ovk::mem::MemoryType::device_local));
+  const auto index_type =
+      index_size == 2 ? vk::IndexType::eUint16 : vk::IndexType::eUint32;
+
+  spdlog::info("finished loading: {} vertices, {} {} bit indices",
+               vertex_count, index_count, index_size * 8);
+  return Model(std::move(vertex_buffer), std::move(index_buffer), index_count,
+               index_type);
+}
+
+Model impl_load_model_obj(const std::string &filepath, ParseOptions options,
+                          ovk::Device &device) {
+  OVK_PROFILE_SCOPE("load_model_obj");
+
+  const auto key = cache_key(options);
+  if (options.use_cache) {
+    if (const auto cache = MeshCache::open(filepath, key);
+        cache && cache->section_count() == 3 &&
+        cache->section(0).size == sizeof(ObjCacheInfo)) {
+      const auto &info = *cache->section(0).as<ObjCacheInfo>();
+      const auto vertices = cache->section(1);
+      const auto indices = cache->section(2);
+
+      if (vertices.count<VertexData>() == info.vertex_count &&
+          indices.size == info.index_count * info.index_size &&
+          cached_indices_valid(indices.data, info.index_count, info.index_size,
+                               info.vertex_count)) {
+        spdlog::info("loading {} from the mesh cache", filepath);
+        return upload(vertices.as<VertexData>(), info.vertex_count,
+                      indices.data, info.index_count, info.index_size, options,
+                      device);
+      }
+      spdlog::warn("mesh cache of {} is corrupt", filepath);
     }
   }
 
-  if (output_buffer.size > output_buffer.max_size)
-    panic("Buffer overflow! Probably destroyed something");
+  const auto parsed = parse_obj(filepath, options, device);
+  if (!parsed)
+    return Model(nullptr, nullptr, 0);
+  const auto &mesh = *parsed;
 
-  // -> But that into a buffer
-  auto vertex_buffer = ovk::make_unique(device.create_buffer(
-      vk::BufferUsageFlagBits::eVertexBuffer, output_buffer.size,
-      output_buffer.start, {ovk::QueueType::graphics},
-      ovk::mem::MemoryType::device_local));
+  // 16 bit indices halve the index buffer for everything below 65536 vertices
+  const auto short_indices =
+      !mesh.indices.empty() &&
+      mesh.vertices.size() <= std::numeric_limits<uint16_t>::max() + size_t(1);
+  std::vector<uint16_t> indices16;
+  if (short_indices)
+    indices16.assign(mesh.indices.begin(), mesh.indices.end());
+
+  const ObjCacheInfo info{
+      mesh.vertices.size(), mesh.indices.size(),
+      options.use_index_buffer ? (short_indices ? 2u : 4u) : 0u, 0};
+  const void *indices = short_indices
+                            ? static_cast<const void *>(indices16.data())
+                            : static_cast<const void *>(mesh.indices.data());
+
+  if (options.use_cache)
+    MeshCache::write(
+        filepath, key,
+        {{reinterpret_cast<const uint8_t *>(&info), sizeof(info)},
+         {reinterpret_cast<const uint8_t *>(mesh.vertices.data()),
+          mesh.vertices.size() * sizeof(VertexData)},
+         {static_cast<const uint8_t *>(indices),
+          info.index_count * info.index_size}});
 
-	// delete output buffer
-	delete[] output_buffer.start;
-	
-  spdlog::info("finished loading: {} vertices", vertex_count);
-  return Model(std::move(vertex_buffer), nullptr, vertex_count);
+  return upload(mesh.vertices.data(), info.vertex_count, indices,
+                info.index_count, info.index_size, options, device);
 }
 
 } // namespace ovk::util
@@ -0,0 +1,327 @@
+#include "obj_parser.h"
+#include "pch.h"
+
+#include "util/mapped_file.h"
+#include "util/profiler.h"
+#include "util/thread_pool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <future>
+#include <limits>
+
+namespace ovk::util {
+
+namespace {
+
+// Below this per thread, splitting the file costs more than it saves
+constexpr size_t min_chunk_size = 256 * 1024;
+
+// Stored for indices that are 0 or out of range, merge turns them into -1 and counts them
+constexpr int32_t invalid_index = std::numeric_limits<int32_t>::max();
+
+enum Attribute : uint32_t { position = 0, normal = 1, texcoord = 2 };
+
+int32_t &attribute(ObjIndex &index, uint32_t attribute) {
+  switch (attribute) {
+  case position:
+    return index.position;
+  case normal:
+    return index.normal;
+  default:
+    return index.texcoord;
+  }
+}
+
+struct Chunk {
+  const char *begin, *end;
+
+  std::vector<float> positions, normals, texcoords;
+  std::vector<ObjIndex> indices;
+  // 3 * corner + attribute of negative (relative) indices. They are resolved against the counts of this chunk while
+  // parsing and need the offset of the chunk added once it is known
+  std::vector<size_t> relative;
+  size_t malformed_lines = 0;
+
+  // Offsets of the chunk in the merged arrays, in elements
+  size_t position_base = 0, normal_base = 0, texcoord_base = 0, index_base = 0;
+  size_t invalid_indices = 0;
+};
+
+// Polygon corner before triangulation
+struct Corner {
+  ObjIndex index;
+  // Bit per Attribute
+  uint32_t relative;
+};
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+const char *skip_space(const char *p, const char *end) {
+  while (p < end && is_space(*p))
+    p++;
+  return p;
+}
+
+bool parse_float(const char *&p, const char *end, float &value) {
+  p = skip_space(p, end);
+  // from_chars does not accept a leading +
+  if (p < end && *p == '+')
+    p++;
+
+  const auto [next, ec] = std::from_chars(p, end, value);
+  if (ec == std::errc::result_out_of_range)
+    // Denormals, which are 0 as far as a mesh is concerned
+    value = 0.0f;
+  else if (ec != std::errc())
+    return false;
+
+  p = next;
+  return true;
+}
+
+template <size_t N> bool parse_floats(const char *p, const char *end, std::vector<float> &target, size_t required) {
+  float values[N] = {};
+  for (size_t i = 0; i < N; i++) {
+    if (!parse_float(p, end, values[i])) {
+      if (i < required)
+        return false;
+      break;
+    }
+  }
+  target.insert(target.end(), values, values + N);
+  return true;
+}
+
+// count is the number of elements parsed so far in this chunk, for relative indices
+bool parse_index(const char *&p, const char *end, size_t count, int32_t &index, bool &relative) {
+  int64_t value;
+  const auto [next, ec] = std::from_chars(p, end, value);
+  if (ec != std::errc())
+    return false;
+  p = next;
+
+  constexpr int64_t max = std::numeric_limits<int32_t>::max();
+  if (value > 0) {
+    index = value <= max ? static_cast<int32_t>(value - 1) : invalid_index;
+  } else if (value < 0) {
+    // Might reference a previous chunk, so this can still be negative
+    const auto local = static_cast<int64_t>(count) + value;
+    index = local >= -max ? static_cast<int32_t>(local) : invalid_index;
+    relative = index != invalid_index;
+  } else {
+    index = invalid_index;
+  }
+  return true;
+}
+
+bool parse_face(Chunk &chunk, const char *p, const char *end, std::vector<Corner> &polygon) {
+  polygon.clear();
+
+  while (true) {
+    p = skip_space(p, end);
+    if (p == end)
+      break;
+
+    // v, v/vt, v//vn or v/vt/vn
+    Corner corner{{-1, -1, -1}, 0};
+    bool relative = false;
+    if (!parse_index(p, end, chunk.positions.size() / 3, corner.index.position, relative))
+      return false;
+    corner.relative |= relative << position;
+
+    if (p < end && *p == '/') {
+      p++;
+      if (p < end && *p != '/') {
+        relative = false;
+        if (!parse_index(p, end, chunk.texcoords.size() / 2, corner.index.texcoord, relative))
+          return false;
+        corner.relative |= relative << texcoord;
+      }
+      if (p < end && *p == '/') {
+        p++;
+        relative = false;
+        if (!parse_index(p, end, chunk.normals.size() / 3, corner.index.normal, relative))
+          return false;
+        corner.relative |= relative << normal;
+      }
+    }
+
+    if (p < end && !is_space(*p))
+      return false;
+    polygon.push_back(corner);
+  }
+
+  if (polygon.size() < 3)
+    return false;
+
+  const auto emit = [&chunk](const Corner &corner) {
+    const auto index = chunk.indices.size();
+    chunk.indices.push_back(corner.index);
+    for (uint32_t a = position; a <= texcoord; a++)
+      if (corner.relative & (1u << a))
+        chunk.relative.push_back(3 * index + a);
+  };
+
+  // Fan triangulation, like tinyobj for convex polygons
+  for (size_t i = 2; i < polygon.size(); i++) {
+    emit(polygon[0]);
+    emit(polygon[i - 1]);
+    emit(polygon[i]);
+  }
+  return true;
+}
+
+// p points to the first non space character of the line, false if the line is malformed
+bool parse_line(Chunk &chunk, const char *p, const char *end, std::vector<Corner> &polygon) {
+  if (end - p < 2)
+    return true;
+
+  if (p[0] == 'v') {
+    if (is_space(p[1]))
+      // Ignores w and vertex colors
+      return parse_floats<3>(p + 2, end, chunk.positions, 3);
+    if (end - p >= 3 && is_space(p[2])) {
+      if (p[1] == 'n')
+        return parse_floats<3>(p + 3, end, chunk.normals, 3);
+      if (p[1] == 't')
+        // v is optional, w is ignored
+        return parse_floats<2>(p + 3, end, chunk.texcoords, 1);
+    }
+  } else if (p[0] == 'f' && is_space(p[1])) {
+    return parse_face(chunk, p + 2, end, polygon);
+  }
+
+  // Comments, groups, materials, ...
+  return true;
+}
+
+void parse_chunk(Chunk &chunk) {
+  OVK_PROFILE_SCOPE("parse_obj_chunk");
+
+  std::vector<Corner> polygon;
+  auto line = chunk.begin;
+  while (line < chunk.end) {
+    auto line_end = static_cast<const char *>(memchr(line, '\n', chunk.end - line));
+    if (!line_end)
+      line_end = chunk.end;
+
+    if (!parse_line(chunk, skip_space(line, line_end), line_end, polygon))
+      chunk.malformed_lines++;
+    line = line_end + 1;
+  }
+}
+
+void merge_chunk(Chunk &chunk, ObjAttributes &result) {
+  OVK_PROFILE_SCOPE("merge_obj_chunk");
+
+  std::copy(chunk.positions.begin(), chunk.positions.end(), result.positions.begin() + 3 * chunk.position_base);
+  std::copy(chunk.normals.begin(), chunk.normals.end(), result.normals.begin() + 3 * chunk.normal_base);
+  std::copy(chunk.texcoords.begin(), chunk.texcoords.end(), result.texcoords.begin() + 2 * chunk.texcoord_base);
+
+  const auto indices = result.indices.data() + chunk.index_base;
+  std::copy(chunk.indices.begin(), chunk.indices.end(), indices);
+
+  const size_t bases[] = {chunk.position_base, chunk.normal_base, chunk.texcoord_base};
+  for (const auto slot : chunk.relative) {
+    auto &index = attribute(indices[slot / 3], slot % 3);
+    const auto absolute = static_cast<int64_t>(index) + static_cast<int64_t>(bases[slot % 3]);
+    index = absolute >= 0 && absolute < invalid_index ? static_cast<int32_t>(absolute) : invalid_index;
+  }
+
+  const int64_t counts[] = {static_cast<int64_t>(result.positions.size() / 3),
+                            static_cast<int64_t>(result.normals.size() / 3),
+                            static_cast<int64_t>(result.texcoords.size() / 2)};
+  for (size_t i = 0; i < chunk.indices.size(); i++) {
+    for (uint32_t a = position; a <= texcoord; a++) {
+      auto &index = attribute(indices[i], a);
+      if (index != -1 && index >= counts[a]) {
+        index = -1;
+        chunk.invalid_indices++;
+      }
+    }
+  }
+}
+
+// Runs f for every chunk, the calling thread takes the first one
+template <typename F> void for_each_chunk(std::vector<Chunk> &chunks, ThreadPool *pool, F f) {
+  std::vector<std::future<void>> futures;
+  for (size_t c = 1; c < chunks.size(); c++)
+    futures.push_back(pool->submit([&chunks, &f, c]() { f(chunks[c]); }));
+
+  f(chunks[0]);
+  for (auto &future : futures)
+    future.get();
+}
+
+} // namespace
+
+ObjAttributes parse_obj_data(const char *data, size_t size, ThreadPool *pool) {
+  OVK_PROFILE_SCOPE("parse_obj_data");
+
+  size_t chunk_count = 1;
+  if (pool)
+    chunk_count = std::clamp<size_t>(size / min_chunk_size, 1, pool->size() + 1);
+
+  // Split at the first line break after every nth of the file
+  std::vector<Chunk> chunks(chunk_count);
+  const auto data_end = data + size;
+  auto begin = data;
+  for (size_t c = 0; c < chunk_count; c++) {
+    auto end = data_end;
+    if (c + 1 < chunk_count) {
+      const auto split = std::max(begin, data + size * (c + 1) / chunk_count);
+      const auto line_end = static_cast<const char *>(memchr(split, '\n', data_end - split));
+      end = line_end ? line_end + 1 : data_end;
+    }
+
+    chunks[c].begin = begin;
+    chunks[c].end = end;
+    begin = end;
+  }
+
+  for_each_chunk(chunks, pool, parse_chunk);
+
+  // The offsets of the chunks are only known once all of them are parsed
+  ObjAttributes result;
+  size_t position_count = 0, normal_count = 0, texcoord_count = 0, index_count = 0;
+  for (auto &chunk : chunks) {
+    chunk.position_base = position_count;
+    chunk.normal_base = normal_count;
+    chunk.texcoord_base = texcoord_count;
+    chunk.index_base = index_count;
+
+    position_count += chunk.positions.size() / 3;
+    normal_count += chunk.normals.size() / 3;
+    texcoord_count += chunk.texcoords.size() / 2;
+    index_count += chunk.indices.size();
+    result.malformed_lines += chunk.malformed_lines;
+  }
+
+  result.positions.resize(3 * position_count);
+  result.normals.resize(3 * normal_count);
+  result.texcoords.resize(2 * texcoord_count);
+  result.indices.resize(index_count);
+
+  for_each_chunk(chunks, pool, [&result](Chunk &chunk) { merge_chunk(chunk, result); });
+
+  for (const auto &chunk : chunks)
+    result.invalid_indices += chunk.invalid_indices;
+
+  return result;
+}
+
+std::optional<ObjAttributes> parse_obj_file(const std::string &path, ThreadPool *pool) {
+  OVK_PROFILE_SCOPE("parse_obj_file");
+
+  const auto file = MappedFile::open(path);
+  if (!file)
+    return std::nullopt;
+  if (file->size() == 0)
+    return ObjAttributes{};
+
+  return parse_obj_data(reinterpret_cast<const char *>(file->data()), file->size(), pool);
+}
+
+} // namespace ovk::util
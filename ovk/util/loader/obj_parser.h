@@ -0,0 +1,45 @@
+#pragma once
+
+#include "def.h"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Parallel parser for the geometry of Wavefront OBJ files
+// Usage:
+//   if (auto obj = ovk::util::parse_obj_file("model.obj", &device.get_thread_pool())) {
+//     for (const auto &corner : obj->indices) ... obj->positions[3 * corner.position] ...
+//   }
+//
+// The file is mapped and split into line aligned chunks, one per thread, which are parsed independently and merged.
+// Only v, vn, vt and f are read (polygons are fan triangulated), everything else (groups, materials, smoothing, ...)
+// is skipped.
+
+namespace ovk::util {
+
+class ThreadPool;
+
+struct OVK_API ObjIndex {
+  // 0 based into the attribute arrays, -1 if the corner has no such attribute (or referenced one that does not exist)
+  int32_t position, normal, texcoord;
+};
+
+struct OVK_API ObjAttributes {
+  // xyz, xyz and uv
+  std::vector<float> positions, normals, texcoords;
+  // 3 corners per triangle
+  std::vector<ObjIndex> indices;
+
+  // Lines that could not be parsed and indices that were out of range
+  size_t malformed_lines = 0;
+  size_t invalid_indices = 0;
+};
+
+// pool may be nullptr to parse on the calling thread only, small files are always parsed on the calling thread.
+// The calling thread parses a chunk as well, so this must not be called from a task of pool
+OVK_API ObjAttributes parse_obj_data(const char *data, size_t size, ThreadPool *pool = nullptr);
+// std::nullopt if the file can not be opened
+OVK_API std::optional<ObjAttributes> parse_obj_file(const std::string &path, ThreadPool *pool = nullptr);
+
+} // namespace ovk::util
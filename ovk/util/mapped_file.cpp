@@ -0,0 +1,110 @@
+#include "mapped_file.h"
+#include "pch.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ovk::util {
+
+std::optional<MappedFile> MappedFile::open(const std::string &path) {
+  MappedFile result;
+
+#ifdef _WIN32
+  const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return std::nullopt;
+  result.file = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+    return std::nullopt;
+  result.length = static_cast<size_t>(size.QuadPart);
+  if (result.length == 0)
+    return result;
+
+  result.file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!result.file_mapping)
+    return std::nullopt;
+  result.mapping = static_cast<const uint8_t *>(MapViewOfFile(result.file_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!result.mapping)
+    return std::nullopt;
+#else
+  const auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return std::nullopt;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    ::close(fd);
+    return std::nullopt;
+  }
+  result.length = static_cast<size_t>(info.st_size);
+
+  if (result.length > 0) {
+    auto mapping = mmap(nullptr, result.length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      return std::nullopt;
+    }
+    // Everything is read front to back, once
+    madvise(mapping, result.length, MADV_SEQUENTIAL);
+    result.mapping = static_cast<const uint8_t *>(mapping);
+  }
+  // The mapping keeps the file alive
+  ::close(fd);
+#endif
+
+  return result;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    mapping = std::exchange(other.mapping, nullptr);
+    length = std::exchange(other.length, 0);
+#ifdef _WIN32
+    file = std::exchange(other.file, nullptr);
+    file_mapping = std::exchange(other.file_mapping, nullptr);
+#endif
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+const uint8_t *MappedFile::data() const { return mapping; }
+
+size_t MappedFile::size() const { return length; }
+
+void MappedFile::close() {
+#ifdef _WIN32
+  if (mapping)
+    UnmapViewOfFile(mapping);
+  if (file_mapping)
+    CloseHandle(file_mapping);
+  if (file)
+    CloseHandle(file);
+  file = nullptr;
+  file_mapping = nullptr;
+#else
+  if (mapping)
+    munmap(const_cast<uint8_t *>(mapping), length);
+#endif
+  mapping = nullptr;
+  length = 0;
+}
+
+} // namespace ovk::util
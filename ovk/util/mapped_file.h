@@ -0,0 +1,41 @@
+#pragma once
+
+#include "def.h"
+
+#include <optional>
+#include <string>
+
+// Read only memory mapping of a whole file
+// Usage:
+//   if (auto file = ovk::util::MappedFile::open("model.obj")) parse(file->data(), file->size());
+
+namespace ovk::util {
+
+class OVK_API MappedFile {
+public:
+  // std::nullopt if the file does not exist or can not be mapped
+  static std::optional<MappedFile> open(const std::string &path);
+
+  MappedFile(const MappedFile &other) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(const MappedFile &other) = delete;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  // nullptr for empty files
+  [[nodiscard]] const uint8_t *data() const;
+  [[nodiscard]] size_t size() const;
+
+private:
+  MappedFile() = default;
+  void close();
+
+  const uint8_t *mapping = nullptr;
+  size_t length = 0;
+#ifdef _WIN32
+  void *file = nullptr;
+  void *file_mapping = nullptr;
+#endif
+};
+
+} // namespace ovk::util
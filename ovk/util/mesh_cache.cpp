@@ -0,0 +1,162 @@
+#include "mesh_cache.h"
+#include "pch.h"
+
+#include "profiler.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ovk::util {
+
+namespace {
+
+constexpr char magic[8] = "OVKMESH";
+constexpr uint64_t section_alignment = 16;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t section_count;
+  uint64_t key;
+  uint64_t source_size;
+  int64_t source_time;
+};
+
+struct SectionEntry {
+  uint64_t offset, size;
+};
+
+uint64_t align(uint64_t offset) { return (offset + section_alignment - 1) & ~(section_alignment - 1); }
+
+// Size and modification time of source, false if it does not exist
+bool stat_source(const std::string &source, uint64_t &size, int64_t &time) {
+  std::error_code ec;
+  size = std::filesystem::file_size(source, ec);
+  if (ec)
+    return false;
+  time = static_cast<int64_t>(std::filesystem::last_write_time(source, ec).time_since_epoch().count());
+  return !ec;
+}
+
+} // namespace
+
+MeshCache::MeshCache(MappedFile &&file) : file(std::move(file)) {}
+
+std::optional<MeshCache> MeshCache::open(const std::string &source, uint64_t key) {
+  OVK_PROFILE_SCOPE("MeshCache::open");
+
+  uint64_t source_size;
+  int64_t source_time;
+  if (!stat_source(source, source_size, source_time))
+    return std::nullopt;
+
+  const auto path = path_for(source);
+  auto file = MappedFile::open(path);
+  if (!file)
+    return std::nullopt;
+
+  Header header;
+  if (file->size() < sizeof(Header)) {
+    spdlog::warn("[MeshCache] (open) {} is truncated", path);
+    return std::nullopt;
+  }
+  memcpy(&header, file->data(), sizeof(Header));
+
+  if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.key != key) {
+    spdlog::info("[MeshCache] (open) {} was written by another version or with other options", path);
+    return std::nullopt;
+  }
+  if (header.source_size != source_size || header.source_time != source_time) {
+    spdlog::info("[MeshCache] (open) {} changed since {} was written", source, path);
+    return std::nullopt;
+  }
+
+  const auto table_end = sizeof(Header) + static_cast<uint64_t>(header.section_count) * sizeof(SectionEntry);
+  if (file->size() < table_end) {
+    spdlog::warn("[MeshCache] (open) {} is truncated", path);
+    return std::nullopt;
+  }
+
+  MeshCache cache(std::move(*file));
+  const auto data = cache.file.data();
+  cache.sections.reserve(header.section_count);
+  for (uint32_t i = 0; i < header.section_count; i++) {
+    SectionEntry entry;
+    memcpy(&entry, data + sizeof(Header) + i * sizeof(SectionEntry), sizeof(SectionEntry));
+    if (entry.offset < table_end || entry.offset > cache.file.size() || entry.size > cache.file.size() - entry.offset) {
+      spdlog::warn("[MeshCache] (open) {} is corrupt", path);
+      return std::nullopt;
+    }
+    cache.sections.push_back(Section{data + entry.offset, static_cast<size_t>(entry.size)});
+  }
+
+  spdlog::trace("[MeshCache] (open) using {}", path);
+  return cache;
+}
+
+bool MeshCache::write(const std::string &source, uint64_t key, const std::vector<Section> &sections) {
+  OVK_PROFILE_SCOPE("MeshCache::write");
+
+  Header header{};
+  memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.section_count = static_cast<uint32_t>(sections.size());
+  header.key = key;
+  if (!stat_source(source, header.source_size, header.source_time))
+    return false;
+
+  std::vector<SectionEntry> table(sections.size());
+  auto offset = align(sizeof(Header) + sections.size() * sizeof(SectionEntry));
+  for (size_t i = 0; i < sections.size(); i++) {
+    table[i] = SectionEntry{offset, sections[i].size};
+    offset = align(offset + sections[i].size);
+  }
+
+  // Write to a temporary file first, a crash must not leave a truncated cache behind
+  const std::filesystem::path path = path_for(source);
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::warn("[MeshCache] (write) failed to open {}", tmp_path.string());
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    file.write(reinterpret_cast<const char *>(table.data()), table.size() * sizeof(SectionEntry));
+
+    const char padding[section_alignment] = {};
+    for (size_t i = 0; i < sections.size(); i++) {
+      file.write(padding, static_cast<std::streamsize>(table[i].offset - static_cast<uint64_t>(file.tellp())));
+      file.write(reinterpret_cast<const char *>(sections[i].data), sections[i].size);
+    }
+
+    if (!file.good()) {
+      spdlog::warn("[MeshCache] (write) failed to write {}", tmp_path.string());
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    spdlog::warn("[MeshCache] (write) failed to write {}: {}", path.string(), ec.message());
+    return false;
+  }
+
+  spdlog::info("[MeshCache] (write) cached {} in {}", source, path.string());
+  return true;
+}
+
+std::string MeshCache::path_for(const std::string &source) { return source + ".ovkmesh"; }
+
+size_t MeshCache::section_count() const { return sections.size(); }
+
+MeshCache::Section MeshCache::section(size_t index) const {
+  ovk_asserts(index < sections.size(), "[MeshCache] (section) {} has only {} sections", index, sections.size());
+  return sections[index];
+}
+
+} // namespace ovk::util
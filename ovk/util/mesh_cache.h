@@ -0,0 +1,59 @@
+#pragma once
+
+#include "def.h"
+
+#include "mapped_file.h"
+
+#include <string>
+#include <vector>
+
+// Binary sidecar of a parsed mesh source, so the source only has to be parsed once
+// Usage:
+//   if (auto cache = ovk::util::MeshCache::open("model.obj", key)) {
+//     upload(cache->section(0));    // Points straight into the mapping
+//   } else {
+//     ... parse ...
+//     ovk::util::MeshCache::write("model.obj", key, { { vertices.data(), vertices.size() * sizeof(Vertex) } });
+//   }
+//
+// The cache is "model.obj.ovkmesh" next to the source. Layout, native endianness:
+//   Header { magic, version, key, source size, source modification time, section count }
+//   { offset, size } per section
+//   the sections, each aligned to 16 bytes
+// It is only used if everything in the header matches, key describes the content (eg. vertex format and load options)
+// and changes whenever that does. Stale or corrupt caches are ignored and rewritten by the next write
+
+namespace ovk::util {
+
+class OVK_API MeshCache {
+public:
+  struct Section {
+    const uint8_t *data;
+    size_t size;
+
+    template <typename T> [[nodiscard]] const T *as() const { return reinterpret_cast<const T *>(data); }
+    template <typename T> [[nodiscard]] size_t count() const { return size / sizeof(T); }
+  };
+
+  // Bump when the layout of the cache or of what the loaders store in it changes
+  static constexpr uint32_t version = 1;
+
+  // std::nullopt if there is no valid cache for the current state of source
+  static std::optional<MeshCache> open(const std::string &source, uint64_t key);
+  // Returns false if the cache could not be written (eg. read only directory), the load works anyway
+  static bool write(const std::string &source, uint64_t key, const std::vector<Section> &sections);
+
+  static std::string path_for(const std::string &source);
+
+  [[nodiscard]] size_t section_count() const;
+  // Valid as long as the MeshCache lives
+  [[nodiscard]] Section section(size_t index) const;
+
+private:
+  explicit MeshCache(MappedFile &&file);
+
+  MappedFile file;
+  std::vector<Section> sections;
+};
+
+} // namespace ovk::util
@@ -0,0 +1,284 @@
+#include "mesh_optimizer.h"
+#include "pch.h"
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace ovk::util {
+
+namespace {
+
+constexpr uint32_t no_entry = ~0u;
+
+// Triangles using each vertex, in compressed rows
+struct Adjacency {
+  std::vector<uint32_t> offsets, counts, triangles;
+
+  Adjacency(const std::vector<uint32_t> &indices, size_t vertex_count)
+      : offsets(vertex_count + 1), counts(vertex_count) {
+    for (const auto index : indices)
+      counts[index]++;
+    for (size_t v = 0; v < vertex_count; v++)
+      offsets[v + 1] = offsets[v] + counts[v];
+
+    triangles.resize(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++)
+      triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+};
+
+// Scoring of "Linear-Speed Vertex Cache Optimisation", the cache here is only the model the order is optimized for
+constexpr uint32_t forsyth_cache_size = 32;
+constexpr float cache_decay_power = 1.5f;
+constexpr float last_triangle_score = 0.75f;
+constexpr float valence_boost_scale = 2.0f;
+constexpr float valence_boost_power = 0.5f;
+
+float vertex_score(uint32_t cache_position, uint32_t remaining_triangles) {
+  if (remaining_triangles == 0)
+    return -1.0f;
+
+  float score = 0.0f;
+  if (cache_position != no_entry) {
+    if (cache_position < 3) {
+      // The vertices of the last triangle, it should not be used again right away
+      score = last_triangle_score;
+    } else {
+      const float scaler = 1.0f / (forsyth_cache_size - 3);
+      score = std::pow(1.0f - (cache_position - 3) * scaler, cache_decay_power);
+    }
+  }
+
+  // Vertices with few triangles left should be finished, so they do not have to be transformed again later
+  return score + valence_boost_scale * std::pow(static_cast<float>(remaining_triangles), -valence_boost_power);
+}
+
+} // namespace
+
+VertexCacheStats analyze_vertex_cache(const std::vector<uint32_t> &indices, size_t vertex_count,
+                                      uint32_t cache_size) {
+  // Cache timestamps, a vertex is in the cache if it was added less than cache_size misses ago
+  std::vector<uint64_t> added(vertex_count, 0);
+  std::vector<bool> referenced(vertex_count);
+  uint64_t misses = 0;
+
+  for (const auto index : indices) {
+    if (added[index] == 0 || misses - added[index] >= cache_size) {
+      misses++;
+      added[index] = misses;
+    }
+    referenced[index] = true;
+  }
+
+  const auto triangles = indices.size() / 3;
+  const auto used = std::count(referenced.begin(), referenced.end(), true);
+
+  VertexCacheStats stats;
+  stats.acmr = triangles ? static_cast<double>(misses) / triangles : 0.0;
+  stats.atvr = used ? static_cast<double>(misses) / used : 0.0;
+  return stats;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count) {
+  OVK_PROFILE_SCOPE("optimize_vertex_cache");
+
+  const auto triangle_count = indices.size() / 3;
+  if (triangle_count == 0)
+    return;
+
+  Adjacency adjacency(indices, vertex_count);
+  // Triangles not emitted yet, the emitted ones are removed from the front of each row
+  auto &remaining = adjacency.counts;
+
+  std::vector<uint32_t> cache_position(vertex_count, no_entry);
+  std::vector<float> scores(vertex_count);
+  for (size_t v = 0; v < vertex_count; v++)
+    scores[v] = vertex_score(no_entry, remaining[v]);
+
+  std::vector<float> triangle_scores(triangle_count);
+  for (size_t t = 0; t < triangle_count; t++)
+    triangle_scores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+
+  std::vector<bool> emitted(triangle_count);
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+
+  // LRU cache, with room for the 3 vertices that are pushed in front of the full cache
+  std::vector<uint32_t> cache, next_cache;
+  cache.reserve(forsyth_cache_size + 3);
+  next_cache.reserve(forsyth_cache_size + 3);
+
+  size_t input_cursor = 0;
+  uint32_t best = 0;
+  while (true) {
+    emitted[best] = true;
+    const uint32_t *triangle = &indices[best * 3];
+    result.insert(result.end(), triangle, triangle + 3);
+
+    // Remove the triangle from the rows of its vertices
+    for (uint32_t k = 0; k < 3; k++) {
+      const auto v = triangle[k];
+      auto *row = &adjacency.triangles[adjacency.offsets[v]];
+      const auto end = row + remaining[v];
+      std::swap(*std::find(row, end, best), *(end - 1));
+      remaining[v]--;
+    }
+
+    next_cache.assign(triangle, triangle + 3);
+    for (const auto v : cache)
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+        next_cache.push_back(v);
+    std::swap(cache, next_cache);
+
+    // Vertices that fell out of the cache only lose their cache score
+    for (size_t i = forsyth_cache_size; i < cache.size(); i++) {
+      cache_position[cache[i]] = no_entry;
+      scores[cache[i]] = vertex_score(no_entry, remaining[cache[i]]);
+    }
+    if (cache.size() > forsyth_cache_size)
+      cache.resize(forsyth_cache_size);
+
+    for (uint32_t i = 0; i < cache.size(); i++) {
+      cache_position[cache[i]] = i;
+      scores[cache[i]] = vertex_score(i, remaining[cache[i]]);
+    }
+
+    // Only triangles of cached vertices changed their score, the best of them is next
+    float best_score = -1.0f;
+    best = no_entry;
+    for (const auto v : cache) {
+      const auto row = &adjacency.triangles[adjacency.offsets[v]];
+      for (uint32_t i = 0; i < remaining[v]; i++) {
+        const auto t = row[i];
+        const auto score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+        triangle_scores[t] = score;
+        if (score > best_score) {
+          best_score = score;
+          best = t;
+        }
+      }
+    }
+
+    if (best == no_entry) {
+      // Nothing left around the cache, continue with the next triangle in input order so this stays linear
+      while (input_cursor < triangle_count && emitted[input_cursor])
+        input_cursor++;
+      if (input_cursor == triangle_count)
+        break;
+      best = static_cast<uint32_t>(input_cursor);
+    }
+  }
+
+  indices = std::move(result);
+}
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float threshold) {
+  OVK_PROFILE_SCOPE("optimize_overdraw");
+
+  const auto triangle_count = indices.size() / 3;
+  if (triangle_count == 0)
+    return;
+
+  // The same FIFO cache as analyze_vertex_cache
+  constexpr uint32_t cache_size = 16;
+  const auto input = analyze_vertex_cache(indices, positions.size(), cache_size);
+  const auto target = threshold * input.acmr;
+
+  // Tipsify: every cluster starts with a cold cache, since any cluster may be drawn before it. A cluster ends as soon
+  // as its own ACMR is within threshold of the input order, so the strips of the vertex cache order are only cut where
+  // the cold start has paid off
+  std::vector<size_t> clusters{0};
+  std::vector<uint64_t> added(positions.size(), 0);
+  uint64_t time = 0, misses = 0;
+  for (size_t t = 0; t + 1 < triangle_count; t++) {
+    for (uint32_t k = 0; k < 3; k++) {
+      const auto v = indices[t * 3 + k];
+      if (added[v] == 0 || time - added[v] >= cache_size) {
+        added[v] = ++time;
+        misses++;
+      }
+    }
+
+    if (misses <= target * (t + 1 - clusters.back())) {
+      clusters.push_back(t + 1);
+      // Everything falls out of the cache
+      time += cache_size;
+      misses = 0;
+    }
+  }
+  clusters.push_back(triangle_count);
+  if (clusters.size() <= 2)
+    return;
+
+  // Area weighted centroid and normal per cluster and for the mesh
+  glm::vec3 mesh_centroid(0.0f);
+  float mesh_area = 0.0f;
+  std::vector<glm::vec3> centroids(clusters.size() - 1), normals(clusters.size() - 1);
+  for (size_t c = 0; c + 1 < clusters.size(); c++) {
+    glm::vec3 centroid(0.0f), normal(0.0f);
+    float area = 0.0f;
+    for (size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+      const auto &a = positions[indices[t * 3]];
+      const auto &b = positions[indices[t * 3 + 1]];
+      const auto &c_ = positions[indices[t * 3 + 2]];
+      // Twice the area in length
+      const auto cross = glm::cross(b - a, c_ - a);
+      const auto triangle_area = glm::length(cross);
+      centroid += (a + b + c_) * (triangle_area / 3.0f);
+      normal += cross;
+      area += triangle_area;
+    }
+
+    mesh_centroid += centroid;
+    mesh_area += area;
+    centroids[c] = area > 0.0f ? centroid / area : positions[indices[clusters[c] * 3]];
+    normals[c] = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f);
+  }
+  if (mesh_area > 0.0f)
+    mesh_centroid /= mesh_area;
+
+  // Clusters far out along their normal are likely in front of the rest, so they come first
+  std::vector<size_t> order(clusters.size() - 1);
+  std::iota(order.begin(), order.end(), size_t(0));
+  std::vector<float> keys(order.size());
+  for (size_t c = 0; c < order.size(); c++)
+    keys[c] = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+  std::vector<uint32_t> result;
+  result.reserve(indices.size());
+  for (const auto c : order)
+    result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+
+  // Every cut restarts from a cold cache, so the result is always a bit worse than the input. Like Tipsify the cost is
+  // bounded by threshold, the last cluster is not checked on its own, so the whole order is checked once more
+  if (analyze_vertex_cache(result, positions.size(), cache_size).acmr <= target)
+    indices = std::move(result);
+}
+
+void optimize_vertex_fetch(std::vector<uint32_t> &indices, uint8_t *vertices, size_t vertex_count, size_t stride) {
+  OVK_PROFILE_SCOPE("optimize_vertex_fetch");
+
+  std::vector<uint32_t> remap(vertex_count, no_entry);
+  uint32_t next = 0;
+  for (auto &index : indices) {
+    if (remap[index] == no_entry)
+      remap[index] = next++;
+    index = remap[index];
+  }
+  for (auto &target : remap)
+    if (target == no_entry)
+      target = next++;
+
+  std::vector<uint8_t> reordered(vertex_count * stride);
+  for (size_t v = 0; v < vertex_count; v++)
+    memcpy(&reordered[remap[v] * stride], vertices + v * stride, stride);
+  memcpy(vertices, reordered.data(), reordered.size());
+}
+
+} // namespace ovk::util
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "def.h"
+
+#include <vector>
+
+// Reordering of indexed triangle lists for the gpu, the result renders the same triangles
+// Usage (in this order, each step keeps what the ones before achieved as far as possible):
+//   ovk::util::optimize_vertex_cache(indices, vertex_count);
+//   ovk::util::optimize_overdraw(indices, positions);
+//   ovk::util::optimize_vertex_fetch(indices, vertices, vertex_count, sizeof(Vertex));
+//
+// load_model runs all of them with ParseOptions::optimize_mesh.
+
+namespace ovk::util {
+
+struct OVK_API VertexCacheStats {
+  // Average cache miss ratio, transformed vertices per triangle (0.5 at best, 3 at worst)
+  double acmr = 0.0;
+  // Average transform to vertex ratio, transformed vertices per referenced vertex (1 at best)
+  double atvr = 0.0;
+};
+
+// Simulates a FIFO post transform cache, 16 entries is a conservative guess for current hardware
+OVK_API VertexCacheStats analyze_vertex_cache(const std::vector<uint32_t> &indices, size_t vertex_count,
+                                              uint32_t cache_size = 16);
+
+// Reorders the triangles for post transform cache locality (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+OVK_API void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+
+// Reorders clusters of triangles so that the ones facing outwards are drawn first and occlude the rest (the clustering
+// of Tipsify). A cluster ends once its ACMR from a cold cache is at most threshold times the ACMR of the input order.
+// The reordered ACMR may be up to threshold times the input ACMR, indices are left alone if it would be any worse
+OVK_API void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+                               float threshold = 1.05f);
+
+// Reorders the vertices in the order of first use, so the vertex fetch walks through memory linearly
+// vertices holds vertex_count vertices of stride bytes, unused vertices end up at the back
+OVK_API void optimize_vertex_fetch(std::vector<uint32_t> &indices, uint8_t *vertices, size_t vertex_count,
+                                   size_t stride);
+
+} // namespace ovk::util
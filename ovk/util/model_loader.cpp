@@ -8,9 +8,11 @@ namespace ovk::util {
 using BufferPtr = std::unique_ptr<ovk::Buffer>;
 
 Model::Model(std::unique_ptr<ovk::Buffer> &&vertex,
-             std::unique_ptr<ovk::Buffer> &&index, uint64_t draw_count)
+             std::unique_ptr<ovk::Buffer> &&index, uint64_t draw_count,
+             vk::IndexType index_type)
     : vertex(std::forward<BufferPtr>(vertex)),
-      index(std::forward<BufferPtr>(index)), draw_count(draw_count) {}
+      index(std::forward<BufferPtr>(index)), draw_count(draw_count),
+      index_type(index_type) {}
 
 void OutputBuffer::push_data(void *data, size_t data_size) {
 #ifdef DEBUG
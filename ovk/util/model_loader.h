@@ -13,10 +13,13 @@ namespace ovk::util {
 
 struct OVK_API Model {
 
-	Model(std::unique_ptr<ovk::Buffer>&& vertex, std::unique_ptr<ovk::Buffer>&& index, uint64_t draw_count);
+	Model(std::unique_ptr<ovk::Buffer>&& vertex, std::unique_ptr<ovk::Buffer>&& index, uint64_t draw_count, vk::IndexType index_type = vk::IndexType::eUint32);
 	
+  // index is null unless ParseOptions::use_index_buffer was set
   std::unique_ptr<ovk::Buffer> vertex, index;
+  // Vertices to draw, or indices if there is an index buffer
   uint64_t draw_count = 0;
+  vk::IndexType index_type = vk::IndexType::eUint32;
 };
 
 struct OVK_API VertexData {
@@ -35,9 +38,18 @@ struct OVK_API OutputBuffer {
 };
 
 struct OVK_API ParseOptions {
+  // Welds vertices with equal position, normal and texcoord and emits an index
+  // buffer (16 bit if the unique vertices fit). The callback is called once per
+  // unique vertex
   bool use_index_buffer = false;
+  // Reorders triangles and vertices for the post transform cache, overdraw and
+  // vertex fetch (see mesh_optimizer.h), requires use_index_buffer
+  bool optimize_mesh = false;
   bool disable_callback = true;
   void (*callback)(const VertexData &, OutputBuffer &) = nullptr;
+  // Keeps the parsed (welded and optimized) vertices in "<file>.ovkmesh" next
+  // to the model (see mesh_cache.h), later loads only run the callback
+  bool use_cache = true;
 };
 
 // template <typename T, typename VertexType>
@@ -0,0 +1,225 @@
+#include "profiler.h"
+#include "pch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+
+namespace ovk::util::profiler {
+
+// Must be a power of two
+constexpr uint64_t ring_capacity = 1 << 16;
+
+// Event in the ring, the fields are atomic since collect() reads them while the owning thread may overwrite them
+struct Slot {
+  // index + 1 of the event in the slot, 0 while it is being written
+  std::atomic<uint64_t> sequence = 0;
+  std::atomic<const char *> name = nullptr;
+  std::atomic<uint64_t> begin_ns = 0, end_ns = 0, frame = 0;
+  std::atomic<EventType> type = EventType::zone;
+};
+
+// Single producer (the owning thread), single consumer (collect())
+struct ThreadBuffer {
+  std::unique_ptr<Slot[]> events = std::make_unique<Slot[]>(ring_capacity);
+  // Only written by the owning thread
+  std::atomic<uint64_t> head = 0;
+  // Only written by collect() (under the registry lock)
+  uint64_t tail = 0;
+
+  uint32_t thread = 0;
+  std::string name;
+};
+
+static struct {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  uint32_t next_thread = 0;
+} registry;
+
+static std::atomic<Backend *> backend = nullptr;
+static std::atomic<bool> enabled = true;
+static std::atomic<uint64_t> frame = 0;
+
+static const auto startup = std::chrono::steady_clock::now();
+
+static ThreadBuffer &get_thread_buffer() {
+  // The registry keeps the buffer alive after the thread exited, so it can still be collected
+  thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto b = std::make_shared<ThreadBuffer>();
+    std::lock_guard lock(registry.mutex);
+    b->thread = registry.next_thread++;
+    registry.buffers.push_back(b);
+    return b;
+  }();
+  return *buffer;
+}
+
+static void record(const Event &event) {
+  auto &buffer = get_thread_buffer();
+  const auto head = buffer.head.load(std::memory_order_relaxed);
+  auto &slot = buffer.events[head & (ring_capacity - 1)];
+
+  // Seqlock, collect() discards the slot if the sequence changed while it copied it
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(event.name, std::memory_order_relaxed);
+  slot.begin_ns.store(event.begin_ns, std::memory_order_relaxed);
+  slot.end_ns.store(event.end_ns, std::memory_order_relaxed);
+  slot.frame.store(event.frame, std::memory_order_relaxed);
+  slot.type.store(event.type, std::memory_order_relaxed);
+  slot.sequence.store(head + 1, std::memory_order_release);
+
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void set_backend(Backend *b) { backend.store(b, std::memory_order_release); }
+
+void set_enabled(bool e) { enabled.store(e, std::memory_order_relaxed); }
+
+bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+uint64_t now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - startup)
+          .count());
+}
+
+uint64_t current_frame() { return frame.load(std::memory_order_relaxed); }
+
+void frame_mark() {
+  const auto f = frame.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (auto *b = backend.load(std::memory_order_acquire))
+    b->frame_mark(f);
+  if (!is_enabled())
+    return;
+
+  const auto now = now_ns();
+  record(Event{"Frame", now, now, f, 0, EventType::frame});
+}
+
+void set_thread_name(const char *name) {
+  auto &buffer = get_thread_buffer();
+  {
+    std::lock_guard lock(registry.mutex);
+    buffer.name = name;
+  }
+  if (auto *b = backend.load(std::memory_order_acquire))
+    b->thread_name(name);
+}
+
+std::vector<Event> collect() {
+  std::vector<Event> events;
+
+  std::lock_guard lock(registry.mutex);
+  for (auto &buffer : registry.buffers) {
+    const auto head = buffer->head.load(std::memory_order_acquire);
+    // The ring only holds the newest ring_capacity events
+    auto begin = std::max(buffer->tail, head > ring_capacity ? head - ring_capacity : 0);
+
+    // The owning thread keeps recording while we copy, events it overwrote (or
+    // is overwriting) in the meantime fail the sequence check and are dropped
+    for (auto i = begin; i < head; i++) {
+      const auto &slot = buffer->events[i & (ring_capacity - 1)];
+      if (slot.sequence.load(std::memory_order_acquire) != i + 1)
+        continue;
+
+      const Event event{slot.name.load(std::memory_order_relaxed),
+                        slot.begin_ns.load(std::memory_order_relaxed),
+                        slot.end_ns.load(std::memory_order_relaxed),
+                        slot.frame.load(std::memory_order_relaxed),
+                        buffer->thread,
+                        slot.type.load(std::memory_order_relaxed)};
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) == i + 1)
+        events.push_back(event);
+    }
+
+    buffer->tail = head;
+  }
+
+  std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+    return a.begin_ns < b.begin_ns;
+  });
+  return events;
+}
+
+static std::string escape_json(const char *s) {
+  std::string out;
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      out.push_back('\\');
+    out.push_back(*s);
+  }
+  return out;
+}
+
+bool export_chrome_trace(const std::string &path) {
+  const auto events = collect();
+
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    spdlog::error("[Profiler] (export_chrome_trace) failed to open {}", path);
+    return false;
+  }
+
+  // Chrome trace timestamps are in microseconds (fractions are allowed)
+  file << R"({"displayTimeUnit":"ns","traceEvents":[)";
+  auto first = true;
+  auto separator = [&]() {
+    if (!first)
+      file << ",\n";
+    first = false;
+  };
+
+  {
+    std::lock_guard lock(registry.mutex);
+    for (auto &buffer : registry.buffers) {
+      if (buffer->name.empty())
+        continue;
+      separator();
+      file << fmt::format(
+          R"({{"name":"thread_name","ph":"M","pid":0,"tid":{},"args":{{"name":"{}"}}}})",
+          buffer->thread, escape_json(buffer->name.c_str()));
+    }
+  }
+
+  for (auto &event : events) {
+    separator();
+    if (event.type == EventType::frame) {
+      file << fmt::format(
+          R"({{"name":"Frame {}","ph":"i","s":"g","pid":0,"tid":{},"ts":{:.3f}}})",
+          event.frame, event.thread, event.begin_ns / 1000.0);
+    } else {
+      file << fmt::format(
+          R"({{"name":"{}","ph":"X","pid":0,"tid":{},"ts":{:.3f},"dur":{:.3f},"args":{{"frame":{}}}}})",
+          escape_json(event.name), event.thread, event.begin_ns / 1000.0,
+          (event.end_ns - event.begin_ns) / 1000.0, event.frame);
+    }
+  }
+  file << "]}";
+
+  spdlog::info("[Profiler] (export_chrome_trace) wrote {} events to {}",
+               events.size(), path);
+  return true;
+}
+
+Zone::Zone(const char *name) : name(name), begin(now_ns()) {
+  if (auto *b = backend.load(std::memory_order_acquire))
+    b->zone_begin(name);
+}
+
+Zone::~Zone() {
+  const auto end = now_ns();
+  if (auto *b = backend.load(std::memory_order_acquire))
+    b->zone_end(name, begin, end);
+  if (!is_enabled())
+    return;
+
+  record(Event{name, begin, end, current_frame(), 0, EventType::zone});
+}
+
+} // namespace ovk::util::profiler
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "def.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Lightweight CPU profiler
+// Usage:
+//   void my_function() {
+//     OVK_PROFILE_SCOPE("my_function");
+//     ...
+//   }
+//
+//   while (running) {
+//     OVK_PROFILE_FRAME();
+//     ...
+//   }
+//
+//   ovk::util::profiler::export_chrome_trace("trace.json"); // -> open in chrome://tracing or ui.perfetto.dev
+//
+// Every thread records into its own lock-free ring buffer, so recording a zone is two
+// clock reads and a few stores. The ring keeps the most recent events, older ones are overwritten
+// (collect() drops events that are overwritten while it copies them).
+// Zone names must be string literals (or otherwise outlive the profiler) since only the pointer is stored.
+
+namespace ovk::util::profiler {
+
+enum class EventType : uint8_t { zone, frame };
+
+struct OVK_API Event {
+  const char *name;
+  uint64_t begin_ns, end_ns;
+  uint64_t frame;
+  uint32_t thread;
+  EventType type;
+};
+
+// Forward zones to an external profiler (eg. Tracy, Optick, Superluminal)
+// Callbacks are invoked on the thread that records the zone
+struct OVK_API Backend {
+  virtual ~Backend() = default;
+
+  virtual void zone_begin(const char *name) {}
+  virtual void zone_end(const char *name, uint64_t begin_ns, uint64_t end_ns) {}
+  virtual void frame_mark(uint64_t frame) {}
+  virtual void thread_name(const char *name) {}
+};
+
+// nullptr removes the backend, ownership stays with the caller
+OVK_API void set_backend(Backend *backend);
+// Disables recording into the ring buffers (the backend still gets called)
+OVK_API void set_enabled(bool enabled);
+OVK_API bool is_enabled();
+
+OVK_API uint64_t now_ns();
+OVK_API uint64_t current_frame();
+
+OVK_API void frame_mark();
+OVK_API void set_thread_name(const char *name);
+
+// Drains the ring buffers of all threads (events are sorted by begin time)
+OVK_API std::vector<Event> collect();
+// Drains the ring buffers and writes them as Chrome trace-event JSON
+OVK_API bool export_chrome_trace(const std::string &path);
+
+class OVK_API Zone {
+public:
+  explicit Zone(const char *name);
+  ~Zone();
+
+  Zone(const Zone &other) = delete;
+  Zone &operator=(const Zone &other) = delete;
+
+private:
+  const char *name;
+  uint64_t begin;
+};
+
+} // namespace ovk::util::profiler
+
+#define OVK_PROFILE_CONCAT_IMPL(a, b) a##b
+#define OVK_PROFILE_CONCAT(a, b) OVK_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef OVK_PROFILER
+#define OVK_PROFILE_SCOPE(name)                                                \
+  ::ovk::util::profiler::Zone OVK_PROFILE_CONCAT(_ovk_zone_, __LINE__)(name)
+#define OVK_PROFILE_FUNCTION() OVK_PROFILE_SCOPE(__FUNCTION__)
+#define OVK_PROFILE_FRAME() ::ovk::util::profiler::frame_mark()
+#else
+#define OVK_PROFILE_SCOPE(name)
+#define OVK_PROFILE_FUNCTION()
+#define OVK_PROFILE_FRAME()
+#endif
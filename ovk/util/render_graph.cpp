@@ -1,9 +1,234 @@
+#include "render_graph.h"
+#include "pch.h"
 
+#include "base/image.h"
+#include "base/render_command.h"
+#include "profiler.h"
 
-void concept_render_graph() {
+#include <algorithm>
 
-	using namespace ovk::util;
-	
-	ovk::util::RenderGraph graph()
+namespace ovk::util {
 
+static const vk::AccessFlags write_access_mask =
+    vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eColorAttachmentWrite |
+    vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eTransferWrite |
+    vk::AccessFlagBits::eHostWrite | vk::AccessFlagBits::eMemoryWrite;
+
+bool Access::is_write() const { return static_cast<bool>(access & write_access_mask); }
+
+RenderGraph::Pass &RenderGraph::Pass::read(Resource resource, const Access &access) {
+  uses.push_back(Use{resource, access, access.layout, false, false});
+  return *this;
+}
+
+RenderGraph::Pass &RenderGraph::Pass::write(Resource resource, const Access &access) {
+  // We do not know if the pass overwrites everything, so the previous contents stay needed
+  uses.push_back(Use{resource, access, access.layout, true, false});
+  return *this;
+}
+
+RenderGraph::Pass &RenderGraph::Pass::attachment(Resource resource, const vk::AttachmentDescription &description) {
+  Access attachment_access =
+      is_depth_format(description.format) ? access::depth_attachment : access::color_attachment;
+  attachment_access.layout = description.initialLayout;
+
+  const bool discard = description.loadOp != vk::AttachmentLoadOp::eLoad &&
+                       description.stencilLoadOp != vk::AttachmentLoadOp::eLoad;
+  uses.push_back(Use{resource, attachment_access, description.finalLayout, true, discard});
+  return *this;
+}
+
+RenderGraph::Pass &RenderGraph::Pass::side_effect() {
+  has_side_effect = true;
+  return *this;
+}
+
+RenderGraph::Pass &RenderGraph::Pass::set_color(glm::vec4 c) {
+  color = c;
+  return *this;
+}
+
+RenderGraph::Resource RenderGraph::import_image(Image &image) {
+  vk::ImageAspectFlags aspect =
+      is_depth_format(image.format) ? vk::ImageAspectFlagBits::eDepth : vk::ImageAspectFlagBits::eColor;
+  if (has_stencil_component(image.format))
+    aspect |= vk::ImageAspectFlagBits::eStencil;
+  const auto resource = import_image(image.handle.get(), aspect, image.layout);
+  resources[resource].owner = &image;
+  return resource;
+}
+
+RenderGraph::Resource RenderGraph::import_image(vk::Image image, vk::ImageAspectFlags aspect,
+                                                vk::ImageLayout layout) {
+  resources.push_back(ResourceInfo{image, aspect, nullptr, layout, true});
+  compiled = false;
+  return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::import_buffer() {
+  resources.push_back(ResourceInfo{nullptr, {}, nullptr, vk::ImageLayout::eUndefined, false});
+  compiled = false;
+  return static_cast<Resource>(resources.size() - 1);
+}
+
+RenderGraph::Pass &RenderGraph::add_pass(std::string name, std::function<void(RenderCommand &)> record) {
+  auto &pass = passes.emplace_back();
+  pass.name = std::move(name);
+  pass.record = std::move(record);
+  compiled = false;
+  return pass;
+}
+
+void RenderGraph::mark_output(Resource resource) {
+  ovk_asserts(resource < resources.size(), "[RenderGraph] (mark_output) unknown resource {}", resource);
+  resources[resource].output = true;
 }
+
+bool RenderGraph::Barrier::empty() const { return !src_stages && !dst_stages && images.empty(); }
+
+void RenderGraph::compile() {
+  OVK_PROFILE_SCOPE("RenderGraph::compile");
+
+  // Culling, walk backwards and keep every pass that writes something a later live pass (or the outside) needs
+  std::vector<bool> needed(resources.size());
+  for (size_t r = 0; r < resources.size(); r++)
+    needed[r] = resources[r].output;
+
+  std::vector<bool> alive(passes.size());
+  for (size_t i = passes.size(); i-- > 0;) {
+    const auto &pass = passes[i];
+    for (const auto &use : pass.uses)
+      ovk_asserts(use.resource < resources.size(), "[RenderGraph] (compile) pass {} uses unknown resource {}",
+                  pass.name, use.resource);
+
+    alive[i] = pass.has_side_effect || std::any_of(pass.uses.begin(), pass.uses.end(), [&](const auto &use) {
+                 return use.write && needed[use.resource];
+               });
+    if (!alive[i])
+      continue;
+
+    for (const auto &use : pass.uses)
+      if (use.write && use.discard)
+        needed[use.resource] = false;
+    for (const auto &use : pass.uses)
+      if (!use.discard)
+        needed[use.resource] = true;
+  }
+
+  // Synchronization, replay the live passes and track per resource what still has to be waited for
+  struct State {
+    vk::ImageLayout layout;
+    // Last write and the accesses it is already visible to
+    vk::PipelineStageFlags write_stages;
+    vk::AccessFlags write_access;
+    vk::PipelineStageFlags visible_stages;
+    vk::AccessFlags visible_access;
+    // Reads since the last write, the next write has to wait for them
+    vk::PipelineStageFlags read_stages;
+  };
+
+  std::vector<State> states(resources.size());
+  for (size_t r = 0; r < resources.size(); r++)
+    states[r].layout = resources[r].layout;
+
+  order.clear();
+  barriers.clear();
+  for (size_t i = 0; i < passes.size(); i++) {
+    if (!alive[i])
+      continue;
+
+    Barrier barrier;
+    for (const auto &use : passes[i].uses) {
+      auto &state = states[use.resource];
+      const auto &resource = resources[use.resource];
+      const auto &access = use.access;
+
+      if (resource.is_image && access.layout != vk::ImageLayout::eUndefined && access.layout != state.layout) {
+        // The transition itself is a write, so it waits for everything since the last write
+        barrier.src_stages |= state.write_stages | state.read_stages;
+        barrier.dst_stages |= access.stages;
+        barrier.images.push_back(vk::ImageMemoryBarrier{
+            state.write_access, access.access, state.layout, access.layout, VK_QUEUE_FAMILY_IGNORED,
+            VK_QUEUE_FAMILY_IGNORED, resource.image,
+            vk::ImageSubresourceRange{resource.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS}});
+
+        // The barrier made the previous write available, later readers only need to wait for the transition
+        state.write_stages = access.stages;
+        state.write_access = {};
+        state.visible_stages = access.stages;
+        state.visible_access = access.access;
+        state.read_stages = {};
+      } else if (use.write) {
+        // Write after write needs the previous write to be available, write after read only an execution dependency
+        if (state.write_stages || state.read_stages) {
+          barrier.src_stages |= state.write_stages | state.read_stages;
+          barrier.dst_stages |= access.stages;
+          barrier.src_access |= state.write_access;
+          barrier.dst_access |= access.access;
+        }
+      } else if (state.write_stages && ((access.stages & ~state.visible_stages) ||
+                                        (access.access & ~state.visible_access))) {
+        // Read after write
+        barrier.src_stages |= state.write_stages;
+        barrier.dst_stages |= access.stages;
+        barrier.src_access |= state.write_access;
+        barrier.dst_access |= access.access;
+        state.visible_stages |= access.stages;
+        state.visible_access |= access.access;
+      }
+
+      if (use.write) {
+        state.write_stages = access.stages;
+        state.write_access = access.access & write_access_mask;
+        state.visible_stages = {};
+        state.visible_access = {};
+        state.read_stages = {};
+      } else {
+        state.read_stages |= access.stages;
+      }
+      if (resource.is_image && use.final_layout != vk::ImageLayout::eUndefined)
+        state.layout = use.final_layout;
+    }
+
+    order.push_back(i);
+    barriers.push_back(std::move(barrier));
+  }
+
+  final_layouts.resize(resources.size());
+  for (size_t r = 0; r < resources.size(); r++)
+    final_layouts[r] = states[r].layout;
+
+  compiled = true;
+}
+
+void RenderGraph::execute(RenderCommand &cmd) {
+  ovk_asserts(compiled, "[RenderGraph] (execute) the graph changed since the last compile");
+
+  for (size_t i = 0; i < order.size(); i++) {
+    auto &pass = passes[order[i]];
+    const auto &barrier = barriers[i];
+
+    if (!barrier.empty()) {
+      const vk::MemoryBarrier memory_barrier{barrier.src_access, barrier.dst_access};
+      const uint32_t memory_barrier_count = barrier.src_access ? 1 : 0;
+
+      cmd.cmd_handle.pipelineBarrier(
+          barrier.src_stages ? barrier.src_stages : vk::PipelineStageFlagBits::eTopOfPipe,
+          barrier.dst_stages ? barrier.dst_stages : vk::PipelineStageFlagBits::eBottomOfPipe, {},
+          memory_barrier_count, &memory_barrier, 0, nullptr, static_cast<uint32_t>(barrier.images.size()),
+          barrier.images.data());
+    }
+
+    cmd.begin_region(pass.name, pass.color);
+    pass.record(cmd);
+    cmd.end_region();
+  }
+
+  for (size_t r = 0; r < resources.size(); r++)
+    if (resources[r].owner)
+      resources[r].owner->set_layout(final_layouts[r]);
+}
+
+size_t RenderGraph::culled_count() const { return passes.size() - order.size(); }
+
+} // namespace ovk::util
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "handle.h"
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Render graph for the passes of one command buffer
+// Usage:
+//   ovk::util::RenderGraph graph;
+//   auto shadow_map = graph.import_image(shadow_image);
+//   auto backbuffer = graph.import_image(swapchain->images[index], vk::ImageAspectFlagBits::eColor, vk::ImageLayout::eUndefined);
+//   graph.mark_output(backbuffer);
+//
+//   graph.add_pass("Shadow", [&](ovk::RenderCommand &cmd) { ... })
+//       .attachment(shadow_map, shadow_depth_description);
+//   graph.add_pass("Main", [&](ovk::RenderCommand &cmd) { ... })
+//       .read(shadow_map, ovk::util::access::fragment_sampled)
+//       .attachment(backbuffer, color_description);
+//
+//   graph.compile();
+//   graph.execute(cmd);
+//
+// Passes run in the order they are added and see what the passes before them wrote. compile culls every pass
+// whose results are never used (not read by a later live pass, not an output and no side effect) and computes the
+// synchronization: at most one vkCmdPipelineBarrier in front of a pass, layout transitions as image barriers and
+// all other hazards merged into one global memory barrier.
+// The graph is cheap to build, so building it again every frame is fine.
+
+namespace ovk {
+class Image;
+class RenderCommand;
+} // namespace ovk
+
+namespace ovk::util {
+
+// One use of a resource by a pass, the layout only matters for images
+struct OVK_API Access {
+  vk::PipelineStageFlags stages;
+  vk::AccessFlags access;
+  vk::ImageLayout layout = vk::ImageLayout::eUndefined;
+
+  [[nodiscard]] bool is_write() const;
+};
+
+namespace access {
+inline const Access vertex_sampled{vk::PipelineStageFlagBits::eVertexShader, vk::AccessFlagBits::eShaderRead,
+                                   vk::ImageLayout::eShaderReadOnlyOptimal};
+inline const Access fragment_sampled{vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead,
+                                     vk::ImageLayout::eShaderReadOnlyOptimal};
+inline const Access compute_sampled{vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead,
+                                    vk::ImageLayout::eShaderReadOnlyOptimal};
+inline const Access compute_storage_read{vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead,
+                                         vk::ImageLayout::eGeneral};
+inline const Access compute_storage_write{vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderWrite,
+                                          vk::ImageLayout::eGeneral};
+inline const Access color_attachment{vk::PipelineStageFlagBits::eColorAttachmentOutput,
+                                     vk::AccessFlagBits::eColorAttachmentRead |
+                                         vk::AccessFlagBits::eColorAttachmentWrite,
+                                     vk::ImageLayout::eColorAttachmentOptimal};
+inline const Access depth_attachment{vk::PipelineStageFlagBits::eEarlyFragmentTests |
+                                         vk::PipelineStageFlagBits::eLateFragmentTests,
+                                     vk::AccessFlagBits::eDepthStencilAttachmentRead |
+                                         vk::AccessFlagBits::eDepthStencilAttachmentWrite,
+                                     vk::ImageLayout::eDepthStencilAttachmentOptimal};
+inline const Access transfer_src{vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferRead,
+                                 vk::ImageLayout::eTransferSrcOptimal};
+inline const Access transfer_dst{vk::PipelineStageFlagBits::eTransfer, vk::AccessFlagBits::eTransferWrite,
+                                 vk::ImageLayout::eTransferDstOptimal};
+inline const Access present{vk::PipelineStageFlagBits::eBottomOfPipe, {}, vk::ImageLayout::ePresentSrcKHR};
+
+// Buffers
+inline const Access vertex_buffer{vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eVertexAttributeRead};
+inline const Access index_buffer{vk::PipelineStageFlagBits::eVertexInput, vk::AccessFlagBits::eIndexRead};
+inline const Access indirect_buffer{vk::PipelineStageFlagBits::eDrawIndirect,
+                                    vk::AccessFlagBits::eIndirectCommandRead};
+inline const Access uniform_buffer{vk::PipelineStageFlagBits::eVertexShader |
+                                       vk::PipelineStageFlagBits::eFragmentShader,
+                                   vk::AccessFlagBits::eUniformRead};
+inline const Access compute_buffer_read{vk::PipelineStageFlagBits::eComputeShader, vk::AccessFlagBits::eShaderRead};
+inline const Access compute_buffer_write{vk::PipelineStageFlagBits::eComputeShader,
+                                         vk::AccessFlagBits::eShaderWrite};
+} // namespace access
+
+class OVK_API RenderGraph {
+public:
+  using Resource = uint32_t;
+
+  class OVK_API Pass {
+  public:
+    Pass &read(Resource resource, const Access &access);
+    Pass &write(Resource resource, const Access &access);
+
+    // Attachment of the render pass this pass records. The render pass transitions initialLayout -> finalLayout
+    // itself, the graph only provides initialLayout (nothing to do for eUndefined). Unless the attachment is loaded
+    // the previous contents are discarded, so earlier writes do not keep their passes alive
+    Pass &attachment(Resource resource, const vk::AttachmentDescription &description);
+
+    // Never culled (eg. the pass writes host visible memory that is read on the cpu)
+    Pass &side_effect();
+
+    // Color of the debug region around the pass
+    Pass &set_color(glm::vec4 color);
+
+  private:
+    friend RenderGraph;
+
+    struct Use {
+      Resource resource;
+      Access access;
+      // Layout the image is in after the pass
+      vk::ImageLayout final_layout;
+      bool write;
+      // Overwrites everything, so the previous contents are not needed
+      bool discard;
+    };
+
+    std::string name;
+    glm::vec4 color = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+    std::function<void(RenderCommand &)> record;
+    std::vector<Use> uses;
+    bool has_side_effect = false;
+  };
+
+  // The layout of the image is taken from image.layout and written back by execute
+  Resource import_image(Image &image);
+  // For images without an ovk::Image (eg. swapchain images), layout is the one it is in when the graph starts
+  Resource import_image(vk::Image image, vk::ImageAspectFlags aspect, vk::ImageLayout layout);
+  // Buffers are synchronized with global memory barriers, so the graph does not need the handle
+  Resource import_buffer();
+
+  Pass &add_pass(std::string name, std::function<void(RenderCommand &)> record);
+
+  // Used after the graph (eg. presented or read back later), the passes writing it are never culled
+  void mark_output(Resource resource);
+
+  // Culls passes and computes the barriers, call after all passes are added
+  void compile();
+  // Records the barriers and passes that survived compile
+  void execute(RenderCommand &cmd);
+
+  // Number of passes compile culled
+  [[nodiscard]] size_t culled_count() const;
+
+private:
+  struct ResourceInfo {
+    vk::Image image;
+    vk::ImageAspectFlags aspect;
+    // Receives the final layout in execute
+    Image *owner = nullptr;
+    vk::ImageLayout layout;
+    bool is_image;
+    bool output = false;
+  };
+
+  struct Barrier {
+    vk::PipelineStageFlags src_stages, dst_stages;
+    vk::AccessFlags src_access, dst_access;
+    std::vector<vk::ImageMemoryBarrier> images;
+
+    [[nodiscard]] bool empty() const;
+  };
+
+  std::vector<ResourceInfo> resources;
+  // Deque, so add_pass can hand out references
+  std::deque<Pass> passes;
+
+  // Filled by compile, one barrier per live pass
+  std::vector<size_t> order;
+  std::vector<Barrier> barriers;
+  std::vector<vk::ImageLayout> final_layouts;
+  bool compiled = false;
+};
+
+} // namespace ovk::util
@@ -0,0 +1,61 @@
+#include "thread_pool.h"
+#include "pch.h"
+
+#include "profiler.h"
+
+namespace ovk::util {
+
+ThreadPool::ThreadPool(uint32_t thread_count, const std::string &name) {
+  if (thread_count == 0)
+    thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+  workers.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; i++)
+    workers.emplace_back(&ThreadPool::worker_loop, this, i, name);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+
+  for (auto &worker : workers)
+    worker.join();
+}
+
+uint32_t ThreadPool::size() const {
+  return static_cast<uint32_t>(workers.size());
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+  {
+    std::lock_guard lock(mutex);
+    ovk_assert(!stopping, "[ThreadPool] (enqueue) pool is shutting down");
+    tasks.push_back(std::move(task));
+  }
+  condition.notify_one();
+}
+
+void ThreadPool::worker_loop(uint32_t index, std::string name) {
+  const auto thread_name = fmt::format("{} {}", name, index);
+  profiler::set_thread_name(thread_name.c_str());
+
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock lock(mutex);
+      condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+      // Drain the queue before stopping, somebody might wait on the futures
+      if (tasks.empty())
+        return;
+
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+} // namespace ovk::util
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "def.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed size pool of worker threads
+// Usage:
+//   ovk::util::ThreadPool pool;
+//   auto result = pool.submit([] { return expensive(); });
+//   ...
+//   use(result.get());
+//
+// Tasks are run in submission order. The destructor finishes all queued tasks
+// before joining, so futures handed out by submit are always satisfied.
+
+namespace ovk::util {
+
+class OVK_API ThreadPool {
+public:
+  // 0 uses one thread less than the hardware has (the caller usually keeps
+  // working), but at least one
+  explicit ThreadPool(uint32_t thread_count = 0, const std::string &name = "Worker");
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &other) = delete;
+  ThreadPool &operator=(const ThreadPool &other) = delete;
+
+  template <typename F>
+  std::future<std::invoke_result_t<std::decay_t<F>>> submit(F &&f);
+
+  [[nodiscard]] uint32_t size() const;
+
+private:
+  void enqueue(std::function<void()> task);
+  void worker_loop(uint32_t index, std::string name);
+
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool stopping = false;
+};
+
+template <typename F>
+std::future<std::invoke_result_t<std::decay_t<F>>> ThreadPool::submit(F &&f) {
+  using R = std::invoke_result_t<std::decay_t<F>>;
+
+  // std::function needs to be copyable, packaged_task is not
+  auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+  auto future = task->get_future();
+  enqueue([task]() { (*task)(); });
+  return future;
+}
+
+} // namespace ovk::util